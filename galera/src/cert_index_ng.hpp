@@ -0,0 +1,422 @@
+//
+// Copyright (C) 2014 Codership Oy <info@codership.com>
+//
+
+//! @file cert_index_ng.hpp
+//
+// @brief Lock-striped certification index for v3 (KeySet) key entries.
+//
+// The index is split into a power of 2 number of shards, each guarded by
+// its own mutex. A key always maps to the same shard, so that certifying or
+// purging a write set needs to hold only the shards its keys fall into.
+// To avoid deadlocks shards are always locked in ascending order.
+//
+// Each shard owns an arena for its key entries and an open addressing hash
+// table that keeps entry pointers together with cached key hashes inline,
+// so that a lookup touches a single cache line in most cases.
+//
+
+#ifndef GALERA_CERT_INDEX_NG_HPP
+#define GALERA_CERT_INDEX_NG_HPP
+
+#include "key_entry_ng.hpp"
+#include "key_entry_arena.hpp"
+#include "key_set.hpp"
+
+#include "gu_mutex.hpp"
+#include "gu_atomic.hpp"
+#include "gu_throw.hpp"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace galera
+{
+    /*! Open addressing (linear probing) hash table of key entry pointers.
+     *  Deletion shifts subsequent entries back, so no tombstones are needed. */
+    class KeyEntryTable
+    {
+    public:
+
+        static size_t const MIN_CAPACITY = 256;
+
+        KeyEntryTable() : slots_(MIN_CAPACITY), size_(0), shift_(0)
+        {
+            shift_ = 64 - log2(slots_.size());
+        }
+
+        size_t size()     const { return size_; }
+        size_t capacity() const { return slots_.size(); }
+
+        KeyEntryNG* find(const KeySet::KeyPart& kp) const
+        {
+            uint64_t const h(kp.hash());
+
+            for (size_t i(home(h));; i = next(i))
+            {
+                const Slot& slot(slots_[i]);
+
+                if (0 == slot.entry_) return 0;
+
+                if (slot.hash_ == h && slot.entry_->key().matches(kp))
+                {
+                    return slot.entry_;
+                }
+            }
+        }
+
+        /*! Entry with matching key must not be in the table */
+        void insert(KeyEntryNG* const ke)
+        {
+            if (gu_unlikely((size_ + 1) * 2 > slots_.size()))
+            {
+                rehash(slots_.size() * 2);
+            }
+
+            insert(slots_, ke->key().hash(), ke);
+            ++size_;
+        }
+
+        /*! Returns the slot of the entry, entry must be in the table */
+        size_t locate(const KeyEntryNG* const ke) const
+        {
+            for (size_t i(home(ke->key().hash()));; i = next(i))
+            {
+                assert(slots_[i].entry_ != 0);
+                if (slots_[i].entry_ == ke) return i;
+            }
+        }
+
+        /*! Replaces entry pointer in the slot returned by locate(). Does not
+         *  dereference the old entry, so it may be already gone. */
+        void replace(size_t const slot, KeyEntryNG* const ke)
+        {
+            assert(slots_[slot].hash_ == ke->key().hash());
+            slots_[slot].entry_ = ke;
+        }
+
+        void erase(const KeyEntryNG* const ke)
+        {
+            size_t i(locate(ke));
+
+            /* shift back entries which would become unreachable */
+            for (size_t j(next(i)); slots_[j].entry_ != 0; j = next(j))
+            {
+                size_t const k(home(slots_[j].hash_));
+
+                /* skip entries whose home is cyclically in (i, j] */
+                if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+
+                slots_[i] = slots_[j];
+                i = j;
+            }
+
+            slots_[i] = Slot();
+            --size_;
+
+            if (gu_unlikely(size_ * 8 < slots_.size() &&
+                            slots_.size() > MIN_CAPACITY))
+            {
+                rehash(slots_.size() / 2);
+            }
+        }
+
+        size_t allocated() const { return slots_.capacity() * sizeof(Slot); }
+
+        void clear()
+        {
+            std::vector<Slot>(MIN_CAPACITY).swap(slots_);
+            shift_ = 64 - log2(slots_.size());
+            size_  = 0;
+        }
+
+    private:
+
+        struct Slot
+        {
+            Slot() : hash_(0), entry_(0) {}
+
+            uint64_t    hash_;
+            KeyEntryNG* entry_;
+        };
+
+        static int log2(size_t n)
+        {
+            int ret(0);
+            while (n >>= 1) ++ret;
+            return ret;
+        }
+
+        /* multiplicative hashing mixes in the upper hash bits: lower bits
+         * may be the same for all keys in a shard */
+        size_t home(uint64_t const h) const
+        {
+            return ((h * GU_ULONG_LONG(0x9e3779b97f4a7c15)) >> shift_);
+        }
+
+        size_t next(size_t const i) const
+        {
+            return ((i + 1) & (slots_.size() - 1));
+        }
+
+        void insert(std::vector<Slot>& slots, uint64_t const h,
+                    KeyEntryNG* const ke) const
+        {
+            size_t i(home(h));
+
+            while (slots[i].entry_ != 0) i = next(i);
+
+            slots[i].hash_  = h;
+            slots[i].entry_ = ke;
+        }
+
+        void rehash(size_t const capacity)
+        {
+            std::vector<Slot> tmp(capacity);
+
+            tmp.swap(slots_);
+            shift_ = 64 - log2(slots_.size());
+
+            for (size_t i(0); i < tmp.size(); ++i)
+            {
+                if (tmp[i].entry_) insert(slots_, tmp[i].hash_, tmp[i].entry_);
+            }
+        }
+
+        std::vector<Slot> slots_;
+        size_t            size_;
+        int               shift_;
+    };
+
+    class CertIndexNG
+    {
+    public:
+
+        typedef uint64_t ShardMask;
+
+        static int const MAX_SHARDS = sizeof(ShardMask) * 8;
+
+        explicit CertIndexNG(int const n_shards)
+            :
+            shards_  (0),
+            n_shards_(n_shards),
+            mask_    (n_shards - 1),
+            size_    (0)
+        {
+            if (n_shards < 1 || n_shards > MAX_SHARDS ||
+                (n_shards & (n_shards - 1)) != 0)
+            {
+                gu_throw_error(EINVAL) << "Invalid number of cert index "
+                                       << "shards: " << n_shards
+                                       << ", must be a power of 2 between 1 "
+                                       << "and " << MAX_SHARDS;
+            }
+
+            shards_ = new Shard[n_shards_];
+        }
+
+        ~CertIndexNG()
+        {
+            clear();
+            delete[] shards_;
+        }
+
+        int n_shards() const { return n_shards_; }
+
+        int shard(const KeySet::KeyPart& kp) const
+        {
+            /* lower bits are left for the shard hash table */
+            return ((kp.hash() >> SHARD_SHIFT) & mask_);
+        }
+
+        static ShardMask shard_bit(int const s)
+        {
+            return (ShardMask(1) << s);
+        }
+
+        ShardMask all_shards() const
+        {
+            return (n_shards_ == MAX_SHARDS ?
+                    ~ShardMask(0) : shard_bit(n_shards_) - 1);
+        }
+
+        /*! Returns the mask of the shards touched by the key set */
+        ShardMask shards(const KeySetIn& ks) const
+        {
+            if (1 == n_shards_) return 1;
+
+            ShardMask   ret(0);
+            ShardMask   const all(all_shards());
+            long        const count(ks.count());
+
+            ks.rewind();
+
+            for (long i(0); i < count && ret != all; ++i)
+            {
+                ret |= shard_bit(shard(ks.next()));
+            }
+
+            return ret;
+        }
+
+        /* The following methods must be called with the corresponding
+         * shard locked */
+
+        KeyEntryNG* find(const KeySet::KeyPart& kp) const
+        {
+            return shards_[shard(kp)].index_.find(kp);
+        }
+
+        /*! Creates a new unreferenced entry for the key part and inserts it
+         *  in the index. Matching entry must not be there already. */
+        KeyEntryNG* insert(const KeySet::KeyPart& kp)
+        {
+            Shard& s(shards_[shard(kp)]);
+            KeyEntryNG* const ret(s.arena_.alloc(kp));
+
+            s.index_.insert(ret);
+            ++size_;
+
+            return ret;
+        }
+
+        /*! Moves the entry to the most recent arena segment before it is
+         *  referenced by a new write set. Returns new entry location. */
+        KeyEntryNG* renew(KeyEntryNG* const kep)
+        {
+            Shard& s(shards_[shard(kep->key())]);
+
+            if (s.arena_.current(kep)) return kep;
+
+            /* arena frees kep and possibly its segment, so find the slot
+             * while kep is still there */
+            size_t const slot(s.index_.locate(kep));
+            KeyEntryNG* const ret(s.arena_.renew(kep));
+
+            s.index_.replace(slot, ret);
+
+            return ret;
+        }
+
+        /*! Removes the entry from the index and destroys it */
+        void erase(KeyEntryNG* const kep)
+        {
+            Shard& s(shards_[shard(kep->key())]);
+
+            assert(!kep->referenced());
+
+            s.index_.erase(kep);
+            s.arena_.free(kep);
+            --size_;
+        }
+
+        /* The following methods are not required to hold shard locks */
+
+        size_t size()  const { return size_(); }
+        bool   empty() const { return (0 == size()); }
+
+        size_t bucket_count()
+        {
+            size_t ret(0);
+
+            for (int s(0); s < n_shards_; ++s)
+            {
+                gu::Lock lock(shards_[s].mutex_);
+                ret += shards_[s].index_.capacity();
+            }
+
+            return ret;
+        }
+
+        /*! Memory allocated for key entries and hash tables */
+        size_t allocated()
+        {
+            size_t ret(0);
+
+            for (int s(0); s < n_shards_; ++s)
+            {
+                gu::Lock lock(shards_[s].mutex_);
+                ret += shards_[s].arena_.allocated() +
+                    shards_[s].index_.allocated();
+            }
+
+            return ret;
+        }
+
+        /*! Deletes all entries regardless of references */
+        void clear()
+        {
+            Lock lock(*this, all_shards());
+
+            for (int s(0); s < n_shards_; ++s)
+            {
+                shards_[s].index_.clear();
+                shards_[s].arena_.clear();
+            }
+
+            size_ = 0;
+        }
+
+        /*! Locks the shards given by mask in ascending order and unlocks
+         *  them in destructor. */
+        class Lock
+        {
+        public:
+
+            Lock(CertIndexNG& idx, ShardMask const mask)
+                : idx_(idx), mask_(mask)
+            {
+                for (int s(0); s < idx_.n_shards_; ++s)
+                {
+                    if (mask_ & shard_bit(s)) idx_.shards_[s].mutex_.lock();
+                }
+            }
+
+            ~Lock()
+            {
+                for (int s(idx_.n_shards_ - 1); s >= 0; --s)
+                {
+                    if (mask_ & shard_bit(s)) idx_.shards_[s].mutex_.unlock();
+                }
+            }
+
+        private:
+
+            Lock(const Lock&);
+            void operator=(const Lock&);
+
+            CertIndexNG&    idx_;
+            ShardMask const mask_;
+        };
+
+    private:
+
+        /* bits of key hash below that are used by shard hash tables */
+        static int const SHARD_SHIFT = 16;
+
+        struct Shard
+        {
+            Shard() : mutex_(), index_(), arena_() {}
+
+            gu::Mutex     mutex_;
+            KeyEntryTable index_;
+            KeyEntryArena arena_;
+
+        private:
+
+            Shard(const Shard&);
+            void operator=(const Shard&);
+        };
+
+        CertIndexNG(const CertIndexNG&);
+        void operator=(const CertIndexNG&);
+
+        Shard*           shards_;
+        int        const n_shards_;
+        int        const mask_;
+        gu::Atomic<long> size_;
+    };
+}
+
+#endif // GALERA_CERT_INDEX_NG_HPP
@@ -0,0 +1,338 @@
+//
+// Copyright (C) 2014 Codership Oy <info@codership.com>
+//
+
+//! @file cert_trx_map.hpp
+//
+// @brief Seqno-indexed ring containers for certification bookkeeping.
+//
+// Certified trxs arrive in seqno order, almost without gaps, and leave
+// certification in seqno order when purged. So instead of balanced trees
+// both the trx map and the set of last seen seqnos are kept in power of 2
+// sized rings indexed by seqno, which grow by doubling when needed.
+// Last seen seqnos too far from the rest to fit in a bounded ring are
+// kept aside in an ordered map.
+//
+
+#ifndef GALERA_CERT_TRX_MAP_HPP
+#define GALERA_CERT_TRX_MAP_HPP
+
+#include "trx_handle.hpp"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace galera
+{
+    /*! Map of certified trxs by global seqno. Trxs must be inserted in seqno
+     *  order and are removed from the lowest seqno up. */
+    class CertTrxMap
+    {
+    public:
+
+        CertTrxMap()
+            :
+            ring_ (MIN_CAPACITY, static_cast<TrxHandle*>(0)),
+            begin_(0),
+            end_  (0),
+            size_ (0)
+        {}
+
+        bool   empty() const { return (0 == size_); }
+        size_t size()  const { return size_; }
+
+        /*! Lowest seqno in the map or WSREP_SEQNO_UNDEFINED if empty */
+        wsrep_seqno_t lowest() const
+        {
+            return (empty() ? WSREP_SEQNO_UNDEFINED : begin_);
+        }
+
+        /*! Returns false if seqno is not above the highest in the map */
+        bool insert(wsrep_seqno_t const seqno, TrxHandle* const trx)
+        {
+            assert(trx != 0);
+
+            if (empty())
+            {
+                begin_ = end_ = seqno;
+            }
+            else if (gu_unlikely(seqno < end_))
+            {
+                return false;
+            }
+
+            if (gu_unlikely(seqno - begin_ >= wsrep_seqno_t(ring_.size())))
+            {
+                grow(seqno - begin_ + 1);
+            }
+
+            slot(seqno) = trx;
+            end_ = seqno + 1;
+            ++size_;
+
+            return true;
+        }
+
+        TrxHandle* find(wsrep_seqno_t const seqno) const
+        {
+            if (seqno < begin_ || seqno >= end_) return 0;
+
+            return ring_[seqno & (ring_.size() - 1)];
+        }
+
+        /*! Calls func for every trx in seqno order */
+        template <class Func>
+        void for_each(Func func) const
+        {
+            for (wsrep_seqno_t s(begin_); s < end_; ++s)
+            {
+                TrxHandle* const trx(ring_[s & (ring_.size() - 1)]);
+                if (trx) func(trx);
+            }
+        }
+
+        /*! Calls func for every trx with seqno up to and including given
+         *  and removes them from the map */
+        template <class Func>
+        void erase_upto(wsrep_seqno_t const seqno, Func func)
+        {
+            wsrep_seqno_t const bound(std::min(seqno + 1, end_));
+
+            for (; begin_ < bound; ++begin_)
+            {
+                TrxHandle*& trx(slot(begin_));
+
+                if (trx)
+                {
+                    func(trx);
+                    trx = 0;
+                    --size_;
+                }
+            }
+
+            skip_gaps();
+        }
+
+        void clear()
+        {
+            std::vector<TrxHandle*>(MIN_CAPACITY, static_cast<TrxHandle*>(0))
+                .swap(ring_);
+            begin_ = end_ = 0;
+            size_  = 0;
+        }
+
+    private:
+
+        static size_t const MIN_CAPACITY = 1 << 10;
+
+        TrxHandle*& slot(wsrep_seqno_t const seqno)
+        {
+            return ring_[seqno & (ring_.size() - 1)];
+        }
+
+        /* keep begin_ pointing at the lowest trx */
+        void skip_gaps()
+        {
+            if (empty())
+            {
+                begin_ = end_;
+            }
+            else
+            {
+                while (0 == slot(begin_)) ++begin_;
+            }
+        }
+
+        void grow(wsrep_seqno_t const span)
+        {
+            size_t capacity(ring_.size() * 2);
+            while (capacity < size_t(span)) capacity *= 2;
+
+            std::vector<TrxHandle*> tmp(capacity, static_cast<TrxHandle*>(0));
+
+            for (wsrep_seqno_t s(begin_); s < end_; ++s)
+            {
+                tmp[s & (capacity - 1)] = slot(s);
+            }
+
+            tmp.swap(ring_);
+        }
+
+        std::vector<TrxHandle*> ring_;
+        wsrep_seqno_t           begin_; // lowest seqno in the map
+        wsrep_seqno_t           end_;   // highest seqno in the map + 1
+        size_t                  size_;
+    };
+
+    /*! Multiset of seqnos (last seen seqnos of certified trxs) represented
+     *  as a ring of counters. Insertions and removals are O(1), lowest()
+     *  is O(1) amortized: removing the lowest seqno skips the range of
+     *  exhausted counters at once. The ring spans at most MAX_CAPACITY
+     *  seqnos, outliers beyond that (e.g. a very stale last seen seqno) are
+     *  counted in an ordered map instead. */
+    class CertDepsSet
+    {
+    public:
+
+        CertDepsSet()
+            :
+            counts_   (MIN_CAPACITY, 0),
+            lowest_   (0),
+            highest_  (0),
+            ring_size_(0),
+            outliers_ (),
+            size_     (0)
+        {}
+
+        /*! Maximum number of seqnos spanned by the ring */
+        static size_t const MAX_CAPACITY = 1 << 16;
+
+        bool   empty()    const { return (0 == size_); }
+        size_t size()     const { return size_; }
+        size_t capacity() const { return counts_.size(); }
+
+        wsrep_seqno_t lowest() const
+        {
+            assert(!empty());
+
+            if (gu_likely(outliers_.empty())) return lowest_;
+
+            wsrep_seqno_t const out(outliers_.begin()->first);
+
+            return (0 == ring_size_ ? out : std::min(lowest_, out));
+        }
+
+        size_t count(wsrep_seqno_t const seqno) const
+        {
+            size_t ret(in_ring(seqno) ? counts_[seqno & (counts_.size() - 1)]
+                       : 0);
+
+            if (gu_unlikely(!outliers_.empty()))
+            {
+                Outliers::const_iterator const i(outliers_.find(seqno));
+                if (i != outliers_.end()) ret += i->second;
+            }
+
+            return ret;
+        }
+
+        void insert(wsrep_seqno_t const seqno)
+        {
+            if (0 == ring_size_)
+            {
+                lowest_ = highest_ = seqno;
+            }
+            else if (seqno < lowest_)
+            {
+                if (gu_unlikely(!reserve(highest_ - seqno + 1)))
+                {
+                    insert_outlier(seqno);
+                    return;
+                }
+                lowest_ = seqno;
+            }
+            else if (seqno > highest_)
+            {
+                if (gu_unlikely(!reserve(seqno - lowest_ + 1)))
+                {
+                    insert_outlier(seqno);
+                    return;
+                }
+                highest_ = seqno;
+            }
+
+            ++counter(seqno);
+            ++ring_size_;
+            ++size_;
+        }
+
+        /*! Removes one instance of seqno, which must be present */
+        void erase(wsrep_seqno_t const seqno)
+        {
+            assert(count(seqno) > 0);
+
+            --size_;
+
+            if (gu_unlikely(!in_ring(seqno) || 0 == counter(seqno)))
+            {
+                Outliers::iterator const i(outliers_.find(seqno));
+                assert(i != outliers_.end());
+                if (0 == --i->second) outliers_.erase(i);
+                return;
+            }
+
+            --counter(seqno);
+            --ring_size_;
+
+            if (0 == ring_size_)
+            {
+                assert(0 == counter(seqno));
+                return;
+            }
+
+            if (seqno == lowest_)
+            {
+                while (0 == counter(lowest_)) ++lowest_;
+            }
+            else if (seqno == highest_)
+            {
+                while (0 == counter(highest_)) --highest_;
+            }
+
+            assert(lowest_ <= highest_);
+        }
+
+    private:
+
+        typedef std::map<wsrep_seqno_t, size_t> Outliers;
+
+        static size_t const MIN_CAPACITY = 1 << 10;
+
+        bool in_ring(wsrep_seqno_t const seqno) const
+        {
+            return (ring_size_ > 0 && seqno >= lowest_ && seqno <= highest_);
+        }
+
+        size_t& counter(wsrep_seqno_t const seqno)
+        {
+            return counts_[seqno & (counts_.size() - 1)];
+        }
+
+        void insert_outlier(wsrep_seqno_t const seqno)
+        {
+            ++outliers_[seqno];
+            ++size_;
+        }
+
+        /* returns false if the span does not fit in the maximum capacity */
+        bool reserve(wsrep_seqno_t const span)
+        {
+            if (gu_likely(span <= wsrep_seqno_t(counts_.size()))) return true;
+            if (span > wsrep_seqno_t(MAX_CAPACITY))               return false;
+
+            size_t capacity(counts_.size() * 2);
+            while (capacity < size_t(span)) capacity *= 2;
+
+            std::vector<size_t> tmp(capacity, 0);
+
+            for (wsrep_seqno_t s(lowest_); s <= highest_; ++s)
+            {
+                tmp[s & (capacity - 1)] = counter(s);
+            }
+
+            tmp.swap(counts_);
+
+            return true;
+        }
+
+        std::vector<size_t> counts_;
+        wsrep_seqno_t       lowest_;    // lowest seqno in the ring
+        wsrep_seqno_t       highest_;   // highest seqno in the ring
+        size_t              ring_size_; // number of seqnos in the ring
+        Outliers            outliers_;  // seqnos that don't fit in the ring
+        size_t              size_;
+    };
+}
+
+#endif // GALERA_CERT_TRX_MAP_HPP
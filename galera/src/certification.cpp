@@ -29,7 +29,11 @@ static std::string const CERT_PARAM_MAX_LENGTH   (CERT_PARAM_PREFIX +
 static std::string const CERT_PARAM_LENGTH_CHECK (CERT_PARAM_PREFIX +
                                                   "length_check");
 
+std::string const galera::Certification::PARAM_INDEX_SHARDS(CERT_PARAM_PREFIX +
+                                                            "index_shards");
+
 static std::string const CERT_PARAM_LOG_CONFLICTS_DEFAULT("no");
+static std::string const CERT_PARAM_INDEX_SHARDS_DEFAULT("1");
 
 /*** It is EXTREMELY important that these constants are the same on all nodes.
  *** Don't change them ever!!! ***/
@@ -40,6 +44,7 @@ void
 galera::Certification::register_params(gu::Config& cnf)
 {
     cnf.add(CERT_PARAM_LOG_CONFLICTS, CERT_PARAM_LOG_CONFLICTS_DEFAULT);
+    cnf.add(PARAM_INDEX_SHARDS, CERT_PARAM_INDEX_SHARDS_DEFAULT);
     /* The defaults below are deliberately not reflected in conf: people
      * should not know about these dangerous setting unless they read RTFM. */
     cnf.add(CERT_PARAM_MAX_LENGTH);
@@ -112,6 +117,9 @@ void
 galera::Certification::purge_for_trx_v3(TrxHandle* trx)
 {
     const KeySetIn& keys(trx->write_set_in().keyset());
+
+    CertIndexNG::Lock lock(cert_index_ng_, cert_index_ng_.shards(keys));
+
     keys.rewind();
 
     // Unref all referenced and remove if was referenced only by us
@@ -120,17 +128,15 @@ galera::Certification::purge_for_trx_v3(TrxHandle* trx)
         const KeySet::KeyPart& kp(keys.next());
         KeySet::Key::Prefix const p(kp.prefix());
 
-        KeyEntryNG ke(kp);
-        CertIndexNG::iterator const ci(cert_index_ng_.find(&ke));
+        KeyEntryNG* const kep(cert_index_ng_.find(kp));
 
-//        assert(ci != cert_index_ng_.end());
-        if (gu_unlikely(cert_index_ng_.end() == ci))
+//        assert(kep != 0);
+        if (gu_unlikely(0 == kep))
         {
             log_warn << "Missing key";
             continue;
         }
 
-        KeyEntryNG* const kep(*ci);
         assert(kep->referenced());
 
         if (kep->ref_trx(p) == trx)
@@ -139,8 +145,7 @@ galera::Certification::purge_for_trx_v3(TrxHandle* trx)
 
             if (kep->referenced() == false)
             {
-                cert_index_ng_.erase(ci);
-                delete kep;
+                cert_index_ng_.erase(kep); // destroys entry
             }
         }
     }
@@ -541,20 +546,18 @@ certify_and_depend_v3(const galera::KeyEntryNG*   const found,
 
 /* returns true on collision, false otherwise */
 static bool
-certify_v3(galera::Certification::CertIndexNG& cert_index_ng,
-           const galera::KeySet::KeyPart&      key,
-           galera::TrxHandle*                  trx,
-           bool const store_keys, bool const   log_conflicts)
+certify_v3(galera::CertIndexNG&           cert_index_ng,
+           const galera::KeySet::KeyPart& key,
+           galera::TrxHandle*             trx,
+           bool const store_keys, bool const log_conflicts)
 {
-    galera::KeyEntryNG ke(key);
-    galera::Certification::CertIndexNG::iterator ci(cert_index_ng.find(&ke));
+    galera::KeyEntryNG* const kep(cert_index_ng.find(key));
 
-    if (cert_index_ng.end() == ci)
+    if (0 == kep)
     {
         if (store_keys)
         {
-            galera::KeyEntryNG* const kep(new galera::KeyEntryNG(ke));
-            ci = cert_index_ng.insert(kep).first;
+            cert_index_ng.insert(key);
 
             cert_debug << "created new entry";
         }
@@ -564,7 +567,6 @@ certify_v3(galera::Certification::CertIndexNG& cert_index_ng,
     {
         cert_debug << "found existing entry";
 
-        galera::KeyEntryNG* const kep(*ci);
         // Note: For we skip certification for isolated trxs, only
         // cert index and key_list is populated.
         return (!trx->is_toi() &&
@@ -572,23 +574,28 @@ certify_v3(galera::Certification::CertIndexNG& cert_index_ng,
     }
 }
 
+/* Must be called with mutex_ unlocked: the shards touched by the write set
+ * are locked instead, so that certification does not block committers and
+ * concurrent certification tests on unrelated keys. */
 galera::Certification::TestResult
 galera::Certification::do_test_v3(TrxHandle* trx, bool store_keys)
 {
     cert_debug << "BEGIN CERTIFICATION v3: " << *trx;
 
-#ifndef NDEBUG
-    // to check that cleanup after cert failure returns cert_index_
-    // to original size
-    size_t prev_cert_index_size(cert_index_.size());
-#endif // NDEBUG
-
     const KeySetIn& key_set(trx->write_set_in().keyset());
     long const      key_count(key_set.count());
     long            processed(0);
 
     assert(key_count > 0);
 
+    CertIndexNG::Lock lock(cert_index_ng_, cert_index_ng_.shards(key_set));
+
+#ifndef NDEBUG
+    // to check that cleanup after cert failure returns cert_index_ng_
+    // to original size
+    size_t prev_cert_index_size(cert_index_ng_.size());
+#endif // NDEBUG
+
     key_set.rewind();
 
     for (; processed < key_count; ++processed)
@@ -601,8 +608,6 @@ galera::Certification::do_test_v3(TrxHandle* trx, bool store_keys)
         }
     }
 
-    trx->set_depends_seqno(std::max(trx->depends_seqno(), last_pa_unsafe_));
-
     if (store_keys == true)
     {
         assert (key_count == processed);
@@ -611,23 +616,21 @@ galera::Certification::do_test_v3(TrxHandle* trx, bool store_keys)
         for (long i(0); i < key_count; ++i)
         {
             const KeySet::KeyPart& k(key_set.next());
-            KeyEntryNG ke(k);
-            CertIndexNG::const_iterator ci(cert_index_ng_.find(&ke));
+            KeyEntryNG* kep(cert_index_ng_.find(k));
 
-            if (ci == cert_index_ng_.end())
+            if (0 == kep)
             {
                 gu_throw_fatal << "could not find key '" << k
                                << "' from cert index";
             }
 
-            KeyEntryNG* const kep(*ci);
-
+            // keep recently referenced entries together, so that purge
+            // releases whole arena segments
+            kep = cert_index_ng_.renew(kep);
             kep->ref(k.prefix(), k, trx);
 
         }
 
-        if (trx->pa_unsafe()) last_pa_unsafe_ = trx->global_seqno();
-
         key_count_ += key_count;
     }
     cert_debug << "END CERTIFICATION (success): " << *trx;
@@ -648,42 +651,49 @@ cert_fail:
          * processed key failed cert and was not added to index */
         for (long i(0); i < processed; ++i)
         {
-            KeyEntryNG ke(key_set.next());
+            const KeySet::KeyPart& k(key_set.next());
 
             // Clean up cert_index_ from entries which were added by this trx
-            CertIndexNG::iterator ci(cert_index_ng_.find(&ke));
+            KeyEntryNG* const kep(cert_index_ng_.find(k));
 
-            if (ci != cert_index_ng_.end())
+            if (kep != 0)
             {
-                KeyEntryNG* kep(*ci);
-
                 if (kep->referenced() == false)
                 {
                     // kel was added to cert_index_ by this trx -
-                    // remove from cert_index_ and fall through to delete
-                    cert_index_ng_.erase(ci);
+                    // remove from cert_index_ and destroy
+                    cert_index_ng_.erase(kep);
                 }
-                else continue;
-
-                assert(kep->referenced() == false);
-
-                delete kep;
-
             }
             else
             {
                 assert(0); // we actually should never be here, the key should
                            // be either added to cert_index_ or be there already
                 log_warn  << "could not find key '"
-                          << ke.key() << "' from cert index";
+                          << k << "' from cert index";
             }
         }
-        assert(cert_index_.size() == prev_cert_index_size);
+        assert(cert_index_ng_.size() == prev_cert_index_size);
     }
 
     return TEST_FAILED;
 }
 
+void
+galera::Certification::init_depends_seqno(TrxHandle* trx) const
+{
+    if ((trx->flags() & (TrxHandle::F_ISOLATION | TrxHandle::F_PA_UNSAFE))
+        || trx_map_.empty())
+    {
+        trx->set_depends_seqno(trx->global_seqno() - 1);
+    }
+    else
+    {
+        trx->set_depends_seqno(trx_map_.lowest() - 1);
+    }
+}
+
+
 galera::Certification::TestResult
 galera::Certification::do_test(TrxHandle* trx, bool store_keys)
 {
@@ -722,30 +732,42 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
 
     TestResult res(TEST_FAILED);
 
-    gu::Lock lock(mutex_); // why do we need that? certification access
-                           // must be fully guarded by the local_monitor_
-
-    /* initialize parent seqno */
-    if ((trx->flags() & (TrxHandle::F_ISOLATION | TrxHandle::F_PA_UNSAFE))
-        || trx_map_.empty())
-    {
-        trx->set_depends_seqno(trx->global_seqno() - 1);
-    }
-    else
-    {
-        trx->set_depends_seqno(
-            trx_map_.begin()->second->global_seqno() - 1);
-    }
-
     switch (version_)
     {
     case 1:
     case 2:
+    {
+        gu::Lock lock(mutex_); // why do we need that? certification access
+                               // must be fully guarded by the local_monitor_
+        init_depends_seqno(trx);
         res = do_test_v1to2(trx, store_keys);
         break;
+    }
     case 3:
+    {
+        wsrep_seqno_t last_pa_unsafe;
+        {
+            gu::Lock lock(mutex_);
+            init_depends_seqno(trx);
+            last_pa_unsafe = last_pa_unsafe_;
+        }
+
+        // cert index is guarded by its own shard locks
         res = do_test_v3(trx, store_keys);
+
+        if (TEST_OK == res)
+        {
+            trx->set_depends_seqno(std::max(trx->depends_seqno(),
+                                            last_pa_unsafe));
+
+            if (store_keys == true && trx->pa_unsafe())
+            {
+                gu::Lock lock(mutex_);
+                last_pa_unsafe_ = trx->global_seqno();
+            }
+        }
         break;
+    }
     default:
         gu_throw_fatal << "certification test for version "
                        << version_ << " not implemented";
@@ -805,7 +827,7 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd)
     version_               (-1),
     trx_map_               (),
     cert_index_            (),
-    cert_index_ng_         (),
+    cert_index_ng_         (conf.get<int>(PARAM_INDEX_SHARDS)),
     deps_set_              (),
     service_thd_           (thd),
     mutex_                 (),
@@ -845,7 +867,7 @@ galera::Certification::~Certification()
 
     gu::Lock lock(mutex_);
 
-    for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
+    trx_map_.for_each(PurgeAndDiscard(*this));
     service_thd_.release_seqno(position_);
     service_thd_.flush();
 }
@@ -872,7 +894,7 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
 
     if (seqno >= position_)
     {
-        std::for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
+        trx_map_.for_each(PurgeAndDiscard(*this));
         assert(cert_index_.size() == 0);
         assert(cert_index_ng_.size() == 0);
     }
@@ -882,12 +904,9 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
                  << seqno;
         std::for_each(cert_index_.begin(), cert_index_.end(),
                       gu::DeleteObject());
-        std::for_each(cert_index_ng_.begin(), cert_index_ng_.end(),
-                      gu::DeleteObject());
-        std::for_each(trx_map_.begin(), trx_map_.end(),
-                      Unref2nd<TrxMap::value_type>());
+        cert_index_ng_.clear(); // deletes entries
+        trx_map_.for_each(Unref());
         cert_index_.clear();
-        cert_index_ng_.clear();
     }
 
     trx_map_.clear();
@@ -935,7 +954,7 @@ wsrep_seqno_t galera::Certification::get_safe_to_discard_seqno_() const
     }
     else
     {
-        retval = (*deps_set_.begin()) - 1;
+        retval = deps_set_.lowest() - 1;
     }
     return retval;
 }
@@ -947,12 +966,9 @@ galera::Certification::purge_trxs_upto_(wsrep_seqno_t const seqno,
 {
     assert (seqno > 0);
 
-    TrxMap::iterator purge_bound(trx_map_.upper_bound(seqno));
-
     cert_debug << "purging index up to " << seqno;
 
-    for_each(trx_map_.begin(), purge_bound, PurgeAndDiscard(*this));
-    trx_map_.erase(trx_map_.begin(), purge_bound);
+    trx_map_.erase_upto(seqno, PurgeAndDiscard(*this));
 
     if (handle_gcache) service_thd_.release_seqno(seqno);
 
@@ -960,7 +976,7 @@ galera::Certification::purge_trxs_upto_(wsrep_seqno_t const seqno,
     {
         log_debug << "trx map after purge: length: " << trx_map_.size()
                   << ", requested purge seqno: " << seqno
-                  << ", real purge seqno: " << trx_map_.begin()->first - 1;
+                  << ", real purge seqno: " << trx_map_.lowest() - 1;
     }
 
     return seqno;
@@ -987,12 +1003,12 @@ galera::Certification::append_trx(TrxHandle* trx)
                       << " trx seqno " << trx->global_seqno();
         }
 
-        if (gu_unlikely((trx->last_seen_seqno() + 1) < trx_map_.begin()->first))
+        if (gu_unlikely((trx->last_seen_seqno() + 1) < trx_map_.lowest()))
         {
             /* See #733 - for now it is false positive */
             cert_debug
                 << "WARNING: last_seen_seqno is below certification index: "
-                << trx_map_.begin()->first << " > " << trx->last_seen_seqno();
+                << trx_map_.lowest() << " > " << trx->last_seen_seqno();
         }
 
         position_ = trx->global_seqno();
@@ -1026,8 +1042,7 @@ galera::Certification::append_trx(TrxHandle* trx)
     {
         gu::Lock lock(mutex_);
 
-        if (trx_map_.insert(
-                std::make_pair(trx->global_seqno(), trx)).second == false)
+        if (trx_map_.insert(trx->global_seqno(), trx) == false)
             gu_throw_fatal << "duplicate trx entry " << *trx;
 
         deps_set_.insert(trx->last_seen_seqno());
@@ -1052,12 +1067,12 @@ wsrep_seqno_t galera::Certification::set_trx_committed(TrxHandle* trx)
         {
             // trxs with depends_seqno == -1 haven't gone through
             // append_trx
-            DepsSet::iterator i(deps_set_.find(trx->last_seen_seqno()));
-            assert(i != deps_set_.end());
+            assert(deps_set_.count(trx->last_seen_seqno()) > 0);
 
-            if (deps_set_.size() == 1) safe_to_discard_seqno_ = *i;
+            if (deps_set_.size() == 1)
+                safe_to_discard_seqno_ = trx->last_seen_seqno();
 
-            deps_set_.erase(i);
+            deps_set_.erase(trx->last_seen_seqno());
         }
 
         if (gu_unlikely(index_purge_required()))
@@ -1075,13 +1090,11 @@ wsrep_seqno_t galera::Certification::set_trx_committed(TrxHandle* trx)
 galera::TrxHandle* galera::Certification::get_trx(wsrep_seqno_t seqno)
 {
     gu::Lock lock(mutex_);
-    TrxMap::iterator i(trx_map_.find(seqno));
-
-    if (i == trx_map_.end()) return 0;
+    TrxHandle* const trx(trx_map_.find(seqno));
 
-    i->second->ref();
+    if (trx) trx->ref();
 
-    return i->second;
+    return trx;
 }
 
 void
@@ -7,6 +7,8 @@
 
 #include "trx_handle.hpp"
 #include "key_entry_ng.hpp"
+#include "cert_index_ng.hpp"
+#include "cert_trx_map.hpp"
 #include "galera_service_thd.hpp"
 
 #include "gu_unordered.hpp"
@@ -24,21 +26,18 @@ namespace galera
     public:
 
         static std::string const PARAM_LOG_CONFLICTS;
+        static std::string const PARAM_INDEX_SHARDS;
 
         static void register_params(gu::Config&);
 
         typedef gu::UnorderedSet<KeyEntryOS*,
                                  KeyEntryPtrHash, KeyEntryPtrEqual> CertIndex;
 
-        typedef gu::UnorderedSet<KeyEntryNG*,
-                                 KeyEntryPtrHashNG, KeyEntryPtrEqualNG>
-        CertIndexNG;
-
     private:
 
-        typedef std::multiset<wsrep_seqno_t>        DepsSet;
+        typedef CertDepsSet DepsSet;
 
-        typedef std::map<wsrep_seqno_t, TrxHandle*> TrxMap;
+        typedef CertTrxMap  TrxMap;
 
     public:
 
@@ -111,6 +110,11 @@ namespace galera
                 cert_index_ng_.bucket_count();
         }
 
+        size_t index_allocated()
+        {
+            return cert_index_ng_.allocated();
+        }
+
         bool index_purge_required()
         {
             register long const count(key_count_.fetch_and_zero());
@@ -124,6 +128,7 @@ namespace galera
 
     private:
 
+        void init_depends_seqno(TrxHandle*) const;
         TestResult do_test(TrxHandle*, bool);
         TestResult do_test_v1to2(TrxHandle*, bool);
         TestResult do_test_v3(TrxHandle*, bool);
@@ -142,10 +147,9 @@ namespace galera
 
             PurgeAndDiscard(Certification& cert) : cert_(cert) { }
 
-            void operator()(TrxMap::value_type& vt) const
+            void operator()(TrxHandle* const trx) const
             {
                 {
-                    TrxHandle* trx(vt.second);
                     TrxHandleLock lock(*trx);
 
                     if (trx->is_committed() == false)
@@ -165,7 +169,7 @@ namespace galera
                                   << " refcnt " << trx->refcnt();
                     }
                 }
-                vt.second->unref();
+                trx->unref();
             }
 
             PurgeAndDiscard(const PurgeAndDiscard& other) : cert_(other.cert_)
@@ -177,6 +181,12 @@ namespace galera
             Certification& cert_;
         };
 
+        class Unref
+        {
+        public:
+            void operator()(TrxHandle* const trx) const { trx->unref(); }
+        };
+
         int           version_;
         TrxMap        trx_map_;
         CertIndex     cert_index_;
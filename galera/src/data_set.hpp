@@ -19,10 +19,11 @@ namespace galera
         enum Version
         {
             EMPTY = 0,
-            VER1
+            VER1,
+            VER2  /* VER1 with CRC32C checksum */
         };
 
-        static Version const MAX_VERSION = VER1;
+        static Version const MAX_VERSION = VER2;
 
         static Version version (unsigned int ver)
         {
@@ -125,6 +126,7 @@ namespace galera
             {
             case DataSet::EMPTY: break; /* Can't create EMPTY DataSetOut */
             case DataSet::VER1:  return gu::RecordSet::CHECK_MMH128;
+            case DataSet::VER2:  return gu::RecordSet::CHECK_CRC32C;
             }
             throw;
         }
@@ -135,7 +137,8 @@ namespace galera
             switch (ver)
             {
             case DataSet::EMPTY: break; /* Can't create EMPTY DataSetOut */
-            case DataSet::VER1:  return gu::RecordSet::VER1;
+            case DataSet::VER1:
+            case DataSet::VER2:  return gu::RecordSet::VER1;
             }
             throw;
         }
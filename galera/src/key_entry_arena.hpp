@@ -0,0 +1,234 @@
+//
+// Copyright (C) 2014 Codership Oy <info@codership.com>
+//
+
+//! @file key_entry_arena.hpp
+//
+// @brief Segmented arena allocator for v3 certification index key entries.
+//
+// Key entries are carved sequentially from fixed size aligned segments.
+// A segment is returned to the system as a whole once the last of its entries
+// is freed. Since write sets are certified in seqno order and referenced
+// entries are moved to the current segment (see renew()), older segments
+// hold only entries referenced by older write sets, and purging certification
+// index up to some seqno frees whole segments instead of individual entries.
+//
+
+#ifndef GALERA_KEY_ENTRY_ARENA_HPP
+#define GALERA_KEY_ENTRY_ARENA_HPP
+
+#include "key_entry_ng.hpp"
+
+#include "gu_throw.hpp"
+#include "gu_macros.h"
+
+#include <new>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+namespace galera
+{
+    class KeyEntryArena
+    {
+    public:
+
+        /* must be a power of 2, segments are aligned to their size */
+        static size_t const SEGMENT_SIZE = 1 << 15;
+
+        KeyEntryArena()
+            :
+            current_   (0),
+            spare_     (0),
+            retired_   (0),
+            n_segments_(0)
+        {}
+
+        ~KeyEntryArena()
+        {
+            clear();
+            ::free(spare_);
+        }
+
+        /*! Allocates a new unreferenced entry for the key part in the current
+         *  segment */
+        KeyEntryNG* alloc(const KeySet::KeyPart& kp)
+        {
+            if (gu_unlikely(0 == current_ || current_->used_ == ENTRIES))
+            {
+                new_segment();
+            }
+
+            KeyEntryNG* const ret
+                (new (current_->entry(current_->used_)) KeyEntryNG(kp));
+
+            ++current_->used_;
+            ++current_->live_;
+
+            return ret;
+        }
+
+        /*! Destroys the entry and releases its segment if it was the last live
+         *  entry there */
+        void free(KeyEntryNG* const ke)
+        {
+            Segment* const seg(segment(ke));
+
+            assert(seg->live_ > 0);
+
+            ke->~KeyEntryNG();
+
+            if (0 == --seg->live_)
+            {
+                if (seg == current_)
+                {
+                    current_->used_ = 0; // reuse from the beginning
+                }
+                else
+                {
+                    release(seg);
+                }
+            }
+        }
+
+        /*! Returns true if the entry was allocated in the current segment */
+        bool current(const KeyEntryNG* const ke) const
+        {
+            return (segment(ke) == current_);
+        }
+
+        /*! Moves the entry to the current segment, if it is not there already,
+         *  and returns its new location. */
+        KeyEntryNG* renew(KeyEntryNG* const ke)
+        {
+            if (current(ke)) return ke;
+
+            KeyEntryNG* const ret(alloc(ke->key()));
+            ret->swap(*ke); // ke is left unreferenced
+            free(ke);
+
+            return ret;
+        }
+
+        /*! Releases all segments regardless of the entries they hold.
+         *  Entries own no resources, so their destructors are not called. */
+        void clear()
+        {
+            while (retired_) release(retired_);
+
+            if (current_)
+            {
+                release(current_);
+                current_ = 0;
+            }
+        }
+
+        /*! Memory held by the arena */
+        size_t allocated() const
+        {
+            return (n_segments_ + (spare_ != 0)) * SEGMENT_SIZE;
+        }
+
+    private:
+
+        struct Segment
+        {
+            Segment* prev_;
+            Segment* next_;
+            int      used_;
+            int      live_;
+
+            KeyEntryNG* entry(int const i)
+            {
+                return reinterpret_cast<KeyEntryNG*>
+                    (reinterpret_cast<char*>(this) + HEADER_SIZE) + i;
+            }
+        };
+
+        /* header size rounded up to keep entries pointer-aligned */
+        static size_t const HEADER_SIZE =
+            (sizeof(Segment) + sizeof(void*) - 1) / sizeof(void*) *
+            sizeof(void*);
+
+        static int const ENTRIES =
+            (SEGMENT_SIZE - HEADER_SIZE) / sizeof(KeyEntryNG);
+
+        static Segment* segment(const KeyEntryNG* const ke)
+        {
+            return reinterpret_cast<Segment*>
+                (reinterpret_cast<uintptr_t>(ke) & ~(SEGMENT_SIZE - 1));
+        }
+
+        void new_segment()
+        {
+            Segment* seg(spare_);
+
+            if (seg)
+            {
+                spare_ = 0;
+            }
+            else
+            {
+                void* ptr;
+
+                if (0 != posix_memalign(&ptr, SEGMENT_SIZE, SEGMENT_SIZE))
+                {
+                    gu_throw_error(ENOMEM) << "Failed to allocate "
+                                           << SEGMENT_SIZE
+                                           << " bytes for key entry segment";
+                }
+
+                seg = static_cast<Segment*>(ptr);
+            }
+
+            seg->prev_ = 0;
+            seg->next_ = 0;
+            seg->used_ = 0;
+            seg->live_ = 0;
+
+            ++n_segments_;
+
+            if (current_)
+            {
+                /* current segment can't be empty when full, push it to
+                 * retired list */
+                assert(current_->live_ > 0);
+
+                current_->next_ = retired_;
+                if (retired_) retired_->prev_ = current_;
+                retired_ = current_;
+            }
+
+            current_ = seg;
+        }
+
+        void release(Segment* const seg)
+        {
+            if (seg != current_)
+            {
+                if (seg->prev_) seg->prev_->next_ = seg->next_;
+                else            retired_          = seg->next_;
+
+                if (seg->next_) seg->next_->prev_ = seg->prev_;
+            }
+
+            --n_segments_;
+
+            /* keep one segment around to avoid allocation churn when segments
+             * are released and allocated at about the same rate */
+            if (0 == spare_) spare_ = seg;
+            else             ::free(seg);
+        }
+
+        KeyEntryArena(const KeyEntryArena&);
+        void operator=(const KeyEntryArena&);
+
+        Segment* current_;
+        Segment* spare_;
+        Segment* retired_;
+        size_t   n_segments_;
+    };
+}
+
+#endif // GALERA_KEY_ENTRY_ARENA_HPP
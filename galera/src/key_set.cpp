@@ -160,7 +160,7 @@ KeySetOut::KeyPart::KeyPart (KeyParts&      added,
                              int const      part_num)
     :
     hash_ (parent->hash_),
-    part_ (0),
+    part_ (),
     value_(reinterpret_cast<const gu::byte_t*>(kd.parts[part_num].ptr)),
     size_ (kd.parts[part_num].len),
     ver_  (parent->ver_),
@@ -218,7 +218,7 @@ KeySetOut::KeyPart::KeyPart (KeyParts&      added,
         found = res.first;
     }
 
-    part_ = &(*found);
+    part_ = *found;
 #else /* insert() way */
     std::pair<KeyParts::iterator, bool> const inserted(added.insert(kp));
 
@@ -260,15 +260,15 @@ KeySetOut::KeyPart::KeyPart (KeyParts&      added,
         }
     }
 
-    part_ = &(*inserted.first);
+    part_ = *inserted.first;
 #endif /* insert() way */
 }
 
 void
 KeySetOut::KeyPart::print (std::ostream& os) const
 {
-    if (part_)
-        os << *part_;
+    if (part_.ptr())
+        os << part_;
     else
         os << "0x0";
 
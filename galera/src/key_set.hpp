@@ -8,6 +8,7 @@
 
 #include "gu_rset.hpp"
 #include "gu_unordered.hpp"
+#include "gu_vector.hpp"
 #include "gu_logger.hpp"
 #include "gu_hexdump.hpp"
 #include "key_data.hpp"
@@ -356,21 +357,20 @@ public:
 #else
     KeyPartSet;
 
-    /* This is a naive mock up of an "unordered set" that first tries to use
-     * preallocated set of buckets and falls back to a "real" heap-based
-     * unordered set from STL/TR1 when preallocated one is exhausted.
-     * The goal is to make sure that at least 3 keys can be inserted without
-     * the need for dynamic allocation.
-     * In practice, with 64 "buckets" and search depth of 3, the average
-     * number of inserted keys before there is a need to go for heap is 25.
-     * 128 buckets will give you 45 and 256 - around 80. */
+    /* This is an open addressing "unordered set" of pointers to key parts
+     * already stored in the key set. It reuses the hash that is serialized
+     * in the key part header, does linear probing and doubles the table
+     * when it becomes half full. First FIRST_SIZE slots are reserved
+     * inside the object, so that small transactions don't need dynamic
+     * allocation at all. Note that the table can't be allocated from the
+     * key set's gu::Allocator - everything allocated there becomes a part
+     * of the serialized key set.
+     * NB: iterators are invalidated by insert() and erase(). */
     class KeyParts
     {
     public:
-        KeyParts() : first_(), second_(NULL), first_size_(0)
-        { ::memset(first_, 0, sizeof(first_)); }
-
-        ~KeyParts() { delete second_; }
+        KeyParts() : table_(), size_(0)
+        { table_->resize(FIRST_SIZE, NULL); }
 
         /* This iterator class is declared for compatibility with
          * unordered_set. We may actually use a more simple interface here. */
@@ -378,7 +378,7 @@ public:
         {
         public:
             iterator(const KeySet::KeyPart* kp) : kp_(kp) {}
-            /* This is sort-of a dirty hack to ensure that first_ array
+            /* This is sort-of a dirty hack to ensure that table_ array
              * of KeyParts class can be treated like a POD array.
              * It uses the fact that the only non-static member of
              * KeySet::KeyPart is gu::byte_t* and so does direct casts between
@@ -406,100 +406,90 @@ public:
 
         const iterator find(const KeySet::KeyPart& kp)
         {
-            unsigned int idx(kp.hash());
-
-            for (unsigned int i(0); i < FIRST_DEPTH; ++i, ++idx)
-            {
-                idx &= FIRST_MASK;
-
-                if (0 !=first_[idx] && KeySet::KeyPart(first_[idx]).matches(kp))
-                {
-                    return iterator(&first_[idx]);
-                }
-            }
-
-            if (second_ && second_->size() > 0)
-            {
-                KeyPartSet::iterator i2(second_->find(kp));
-                if (i2 != second_->end()) return iterator(&(*i2));
-            }
+            size_t const idx(slot(kp));
 
-            return end();
+            return (table_[idx] ? iterator(&table_[idx]) : end());
         }
 
         std::pair<iterator, bool> insert(const KeySet::KeyPart& kp)
         {
-            unsigned int idx(kp.hash());
+            size_t idx(slot(kp));
 
-            for (unsigned int i(0); i < FIRST_DEPTH; ++i, ++idx)
+            if (table_[idx])
             {
-                idx &= FIRST_MASK;
-
-                if (0 == first_[idx])
-                {
-                    first_[idx] = kp.ptr();
-                    ++first_size_;
-                    return
-                        std::pair<iterator, bool>(iterator(&first_[idx]), true);
-                }
-
-                if (KeySet::KeyPart(first_[idx]).matches(kp))
-                {
-                    return
-                        std::pair<iterator, bool>(iterator(&first_[idx]),false);
-                }
+                return std::pair<iterator, bool>(iterator(&table_[idx]), false);
             }
 
-            if (!second_)
+            if (gu_unlikely((size_ + 1) * 2 > table_.size()))
             {
-                second_ = new KeyPartSet();
-//                log_info << "Requesting heap at load factor "
-//                         << first_size_ << '/' << FIRST_SIZE << " = "
-//                         << (double(first_size_)/FIRST_SIZE);
+                grow();
+                idx = slot(kp);
             }
 
-            std::pair<KeyPartSet::iterator, bool> res = second_->insert(kp);
-            return std::pair<iterator, bool>(iterator(&(*res.first)),
-                                             res.second);
+            table_[idx] = kp.ptr();
+            ++size_;
+
+            return std::pair<iterator, bool>(iterator(&table_[idx]), true);
         }
 
         iterator erase(iterator it)
         {
-            unsigned int idx(it->hash());
+            size_t idx(slot(*it));
 
-            for (unsigned int i(0); i < FIRST_DEPTH; ++i, ++idx)
-            {
-                idx &= FIRST_MASK;
-
-                if (first_[idx] && KeySet::KeyPart(first_[idx]).matches(*it))
-                {
-                    first_[idx] = 0;
-                    --first_size_;
-                    return iterator(&first_[(idx + 1) & FIRST_MASK]);
-                }
-            }
+            if (!table_[idx]) return end();
 
-            if (second_ && second_->size() > 0)
-            {
-                KeyPartSet::iterator it2(second_->erase(second_->find(*it)));
+            table_[idx] = NULL;
+            --size_;
+
+            /* backward shift: reinsert the rest of the cluster so that
+             * probing sequences stay unbroken, no tombstones needed */
+            size_t const mask(table_.size() - 1);
 
-                if (it2 != second_->end()) return iterator(&(*it2));
+            for (idx = (idx + 1) & mask; table_[idx]; idx = (idx + 1) & mask)
+            {
+                const gu::byte_t* const ptr(table_[idx]);
+                table_[idx] = NULL;
+                table_[slot(KeySet::KeyPart(ptr))] = ptr;
             }
 
             return end();
         }
 
-        size_t size() const { return (first_size_ + second_->size()); }
+        size_t size() const { return size_; }
 
     private:
 
-        static unsigned int const FIRST_MASK  = 0x3f; // 63
-        static unsigned int const FIRST_SIZE  = FIRST_MASK + 1;
-        static unsigned int const FIRST_DEPTH = 3;
+        static size_t const FIRST_SIZE = 64; // must be a power of 2
+
+        /* @return index of the slot containing the matching key part or
+         *         of the empty slot where it should be inserted */
+        size_t slot(const KeySet::KeyPart& kp) const
+        {
+            size_t const mask(table_.size() - 1);
+            size_t idx(kp.hash() & mask);
+
+            while (table_[idx] && !KeySet::KeyPart(table_[idx]).matches(kp))
+            {
+                idx = (idx + 1) & mask;
+            }
+
+            return idx;
+        }
+
+        void grow()
+        {
+            std::vector<const gu::byte_t*> const old(table_->begin(),
+                                                     table_->end());
+            table_->assign(old.size() * 2, NULL);
+
+            for (size_t i(0); i < old.size(); ++i)
+            {
+                if (old[i]) table_[slot(KeySet::KeyPart(old[i]))] = old[i];
+            }
+        }
 
-        const gu::byte_t* first_[FIRST_SIZE];
-        KeyPartSet*       second_;
-        unsigned int      first_size_;
+        gu::Vector<const gu::byte_t*, FIRST_SIZE> table_;
+        size_t                                    size_;
     };
 #endif /* 1 */
 
@@ -510,7 +500,7 @@ public:
         KeyPart (KeySet::Version const ver = KeySet::FLAT16)
             :
             hash_ (),
-            part_ (0),
+            part_ (),
             value_(0),
             size_ (0),
             ver_  (ver),
@@ -564,7 +554,7 @@ public:
         }
 
         bool
-        exclusive () const { return (part_ && part_->exclusive()); }
+        exclusive () const { return (part_.ptr() && part_.exclusive()); }
 
         bool
         shared () const { return !exclusive(); }
@@ -598,7 +588,7 @@ public:
     private:
 
         gu::Hash          hash_;
-        const KeySet::KeyPart* part_;
+        KeySet::KeyPart   part_; // copy: KeyParts table may be relocated
         mutable
         const gu::byte_t* value_;
         unsigned int      size_;
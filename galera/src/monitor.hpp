@@ -1,5 +1,5 @@
 //
-// Copyright (C) 2010-2013 Codership Oy
+// Copyright (C) 2010-2014 Codership Oy
 //
 
 #ifndef GALERA_MONITOR_HPP
@@ -7,23 +7,69 @@
 
 #include "trx_handle.hpp"
 #include <gu_lock.hpp> // for gu::Mutex and gu::Cond
+#include <gu_atomic.hpp>
+#include <gu_throw.hpp>
 
-#include <vector>
+#include <algorithm>
+
+#include <sched.h>
+#include <stdint.h>
 
 namespace galera
 {
+    //
+    // Monitor enforces the order in which objects enter and leave critical
+    // sections. An object may enter after the monitor has left the seqno
+    // returned by its depends_seqno().
+    //
+    // last_left_, last_entered_ and slot states are atomic, so that objects
+    // which don't have to wait enter and leave without locking mutex_.
+    // mutex_ is locked only to park threads which have to wait and to wake
+    // them up, and for drain/interrupt/self-cancel. Waiting threads are
+    // linked to the slot of the seqno they wait for and are woken up when
+    // that slot is released.
+    //
+    // Slots are kept in a power of 2 sized ring which grows when the window
+    // between last_left_ and the entering seqno does not fit and shrinks
+    // when the window stays small, up to the maximum window size.
+    //
     template <class C>
     class Monitor
     {
+    public:
+
+        static ssize_t const MIN_SIZE     = 1 << 7;
+        static ssize_t const DEFAULT_SIZE = 1 << 16; // default max window
+        static ssize_t const MAX_SIZE     = 1 << 30;
+
     private:
 
-        struct Process
+        // waiting thread, lives on its stack
+        struct Waiter
         {
-            Process() : obj_(0), cond_(), wait_cond_(), state_(S_IDLE) { }
+            Waiter(wsrep_seqno_t const seqno, wsrep_seqno_t const wait_for)
+                :
+                cond_    (),
+                next_    (0),
+                seqno_   (seqno),
+                wait_for_(wait_for),
+                linked_  (false)
+            {}
+
+            gu::Cond            cond_;
+            Waiter*             next_;
+            wsrep_seqno_t const seqno_;    // own slot or -1 for wait()
+            wsrep_seqno_t const wait_for_; // seqno to be left
+            bool                linked_;
+
+        private:
+
+            Waiter(const Waiter&);
+            void operator=(const Waiter&);
+        };
 
-            const C* obj_;
-            gu::Cond cond_;
-            gu::Cond wait_cond_;
+        struct Slot
+        {
             enum State
             {
                 S_IDLE,     // Slot is free
@@ -31,28 +77,127 @@ namespace galera
                 S_CANCELED,
                 S_APPLYING, // Applying
                 S_FINISHED  // Finished
-            } state_;
+            };
+
+            Slot() : word_(S_IDLE), waiter_(0), waiters_(0) { }
+
+            // Slot state is stored together with the seqno of the object
+            // occupying the slot, so that a thread which has read a stale
+            // last_left_ can't release the slot after it was reused.
+            static uint64_t word(wsrep_seqno_t const seqno, State const state)
+            {
+                return ((uint64_t(seqno) << STATE_BITS) | state);
+            }
+
+            static State state(uint64_t const w)
+            {
+                return State(w & STATE_MASK);
+            }
+
+            // valid for non-negative seqnos only
+            static wsrep_seqno_t seqno(uint64_t const w)
+            {
+                return wsrep_seqno_t(w >> STATE_BITS);
+            }
+
+            State state() const { return state(word_()); }
+
+            void set(wsrep_seqno_t const seqno, State const state)
+            {
+                word_ = word(seqno, state);
+            }
+
+            // must be called with mutex_ locked, keeps the seqno
+            void set_state(State const state)
+            {
+                word_ = ((word_() & ~STATE_MASK) | state);
+            }
+
+            bool transit(wsrep_seqno_t const seqno,
+                         State const from, State const to)
+            {
+                uint64_t expected(word(seqno, from));
+                return word_.compare_and_swap(expected, word(seqno, to));
+            }
+
+            gu::Atomic<uint64_t> word_;
+            Waiter*              waiter_;  // occupant waiting to enter
+            Waiter*              waiters_; // waiting for this slot seqno
 
         private:
 
-            // non-copyable
-            Process(const Process& other);
-            void operator=(const Process&);
+            static int const      STATE_BITS = 3;
+            static uint64_t const STATE_MASK = (1 << STATE_BITS) - 1;
+
+            Slot(const Slot&);
+            void operator=(const Slot&);
         };
 
-        static const ssize_t process_size_ = (1ULL << 16);
-        static const size_t  process_mask_ = process_size_ - 1;
+        // Marks a lock-free section which may access slots_. Slots are
+        // reallocated only when there are no such sections in progress.
+        class FastPath
+        {
+        public:
+
+            explicit FastPath(Monitor& mon) : mon_(mon), ok_(true)
+            {
+                ++mon_.active_;
+                // pairs with active_ check in quiesce()
+                if (gu_unlikely(mon_.resizing_() != 0))
+                {
+                    --mon_.active_;
+                    ok_ = false;
+                }
+            }
+
+            ~FastPath() { if (ok_) --mon_.active_; }
+
+            bool ok() const { return ok_; }
+
+        private:
+
+            FastPath(const FastPath&);
+            void operator=(const FastPath&);
+
+            Monitor& mon_;
+            bool     ok_;
+        };
+
+        // Registers a thread which is going to wait on a condition, so that
+        // post_leave() locks mutex_ to wake it up. Must be created before
+        // the condition is checked for the first time: pairs with waiters_
+        // check after last_left_ update in post_leave().
+        class Waiting
+        {
+        public:
+
+            explicit Waiting(Monitor& mon) : mon_(mon) { ++mon_.waiters_; }
+
+            ~Waiting() { --mon_.waiters_; }
+
+        private:
+
+            Waiting(const Waiting&);
+            void operator=(const Waiting&);
+
+            Monitor& mon_;
+        };
 
     public:
 
-        Monitor()
+        explicit Monitor(ssize_t const max_size = DEFAULT_SIZE)
             :
             mutex_(),
             cond_(),
             last_entered_(-1),
             last_left_(-1),
             drain_seqno_(LLONG_MAX),
-            process_(new Process[process_size_]),
+            slots_(new Slot[MIN_SIZE]),
+            mask_(MIN_SIZE - 1),
+            max_size_(check_size(max_size)),
+            resizing_(0),
+            active_(0),
+            waiters_(0),
             entered_(0),
             oooe_(0),
             oool_(0),
@@ -61,12 +206,12 @@ namespace galera
 
         ~Monitor()
         {
-            delete[] process_;
-            if (entered_ > 0)
+            delete[] slots_;
+            if (entered_() > 0)
             {
-                log_info << "mon: entered " << entered_
-                         << " oooe fraction " << double(oooe_)/entered_
-                         << " oool fraction " << double(oool_)/entered_;
+                log_info << "mon: entered " << entered_()
+                         << " oooe fraction " << double(oooe_())/entered_()
+                         << " oool fraction " << double(oool_())/entered_();
             }
             else
             {
@@ -77,10 +222,11 @@ namespace galera
         void set_initial_position(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
-            if (last_entered_ == -1 || seqno == -1)
+            if (last_entered_() == -1 || seqno == -1)
             {
                 // first call or reset
-                last_entered_ = last_left_ = seqno;
+                last_entered_ = seqno;
+                last_left_    = seqno;
             }
             else
             {
@@ -91,159 +237,203 @@ namespace galera
             }
             if (seqno != -1)
             {
-                const size_t idx(indexof(seqno));
-                process_[idx].wait_cond_.broadcast();
+                // last_left_ could jump over seqnos somebody waits for
+                for (size_t i(0); i <= mask_; ++i) wake_waiters(slots_[i]);
             }
         }
 
         void enter(C& obj)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t        idx(indexof(obj_seqno));
-            gu::Lock            lock(mutex_);
 
-            assert(obj_seqno > last_left_);
+            assert(obj_seqno > last_left_());
+
+#ifdef GU_DBUG_ON
+            {
+                // sync point before the object may enter without waiting,
+                // the object can be interrupted meanwhile as if it was waiting
+                gu::Lock lock(mutex_);
+                obj.debug_sync(mutex_);
+            }
+#endif // GU_DBUG_ON
+
+            if (gu_likely(try_enter(obj))) return;
+
+            gu::Lock lock(mutex_);
 
             pre_enter(obj, lock);
 
-            if (gu_likely(process_[idx].state_ != Process::S_CANCELED))
+            if (gu_likely(slot(obj_seqno).state() != Slot::S_CANCELED))
             {
-                assert(process_[idx].state_ == Process::S_IDLE);
+                assert(slot(obj_seqno).state() == Slot::S_IDLE);
 
-                process_[idx].state_ = Process::S_WAITING;
-                process_[idx].obj_   = &obj;
+                Waiter w(obj_seqno, obj.depends_seqno());
 
-#ifdef GU_DBUG_ON
-                obj.debug_sync(mutex_);
-#endif // GU_DBUG_ON
-                while (may_enter(obj) == false &&
-                       process_[idx].state_ == Process::S_WAITING)
+                slot(obj_seqno).set(obj_seqno, Slot::S_WAITING);
+
+                if (last_left_() < w.wait_for_)
                 {
-                    obj.unlock();
-                    lock.wait(process_[idx].cond_);
-                    obj.lock();
+                    slot(obj_seqno).waiter_ = &w;
+                    add_waiter(w);
+
+                    // slots may be reallocated while waiting, so they are
+                    // looked up anew after each wait
+                    while (last_left_() < w.wait_for_ &&
+                           slot(obj_seqno).state() == Slot::S_WAITING)
+                    {
+                        obj.unlock();
+                        lock.wait(w.cond_);
+                        obj.lock();
+                    }
+
+                    remove_waiter(w);
+                    slot(obj_seqno).waiter_ = 0;
                 }
 
-                if (process_[idx].state_ != Process::S_CANCELED)
+                if (slot(obj_seqno).state() != Slot::S_CANCELED)
                 {
-                    assert(process_[idx].state_ == Process::S_WAITING ||
-                           process_[idx].state_ == Process::S_APPLYING);
+                    assert(slot(obj_seqno).state() == Slot::S_WAITING ||
+                           slot(obj_seqno).state() == Slot::S_APPLYING);
 
-                    process_[idx].state_ = Process::S_APPLYING;
+                    slot(obj_seqno).set(obj_seqno, Slot::S_APPLYING);
 
-                    ++entered_;
-                    oooe_     += ((last_left_ + 1) < obj_seqno);
-                    win_size_ += (last_entered_ - last_left_);
+                    update_stats(obj_seqno);
                     return;
                 }
             }
 
-            assert(process_[idx].state_ == Process::S_CANCELED);
-            process_[idx].state_ = Process::S_IDLE;
+            assert(slot(obj_seqno).state() == Slot::S_CANCELED);
+            slot(obj_seqno).set(obj_seqno, Slot::S_IDLE);
 
             gu_throw_error(EINTR);
         }
 
         void leave(const C& obj)
         {
-#ifndef NDEBUG
-            size_t   idx(indexof(obj.seqno()));
-#endif /* NDEBUG */
-            gu::Lock lock(mutex_);
-
-            assert(process_[idx].state_ == Process::S_APPLYING ||
-                   process_[idx].state_ == Process::S_CANCELED);
-
-            assert(process_[indexof(last_left_)].state_ == Process::S_IDLE);
-
-            post_leave(obj, lock);
+            post_leave(obj);
         }
 
         void self_cancel(C& obj)
         {
             wsrep_seqno_t const obj_seqno(obj.seqno());
-            size_t   idx(indexof(obj_seqno));
             gu::Lock lock(mutex_);
 
-            assert(obj_seqno > last_left_);
+            assert(obj_seqno > last_left_());
+
+            Waiting waiting(*this);
 
-            while (obj_seqno - last_left_ >= process_size_)
+            while (obj_seqno - last_left_() >= max_size_())
                 // TODO: exit on error
             {
                 log_warn << "Trying to self-cancel seqno out of process "
                          << "space: obj_seqno - last_left_ = " << obj_seqno
-                         << " - " << last_left_ << " = "
-                         << (obj_seqno - last_left_)
-                         << ", process_size_: "  << process_size_
+                         << " - " << last_left_() << " = "
+                         << (obj_seqno - last_left_())
+                         << ", max window: "  << max_size_()
                          << ". Deadlock is very likely.";
                 obj.unlock();
                 lock.wait(cond_);
                 obj.lock();
             }
 
-            assert(process_[idx].state_ == Process::S_IDLE ||
-                   process_[idx].state_ == Process::S_CANCELED);
+            reserve(obj_seqno);
 
-            if (obj_seqno > last_entered_) last_entered_ = obj_seqno;
+            Slot& p(slot(obj_seqno));
 
-            if (obj_seqno <= drain_seqno_)
-            {
-                post_leave(obj, lock);
-            }
-            else
+            assert(p.state() == Slot::S_IDLE ||
+                   p.state() == Slot::S_CANCELED);
+
+            update_last_entered(obj_seqno);
+
+            p.set(obj_seqno, Slot::S_FINISHED);
+
+            if (obj_seqno <= drain_seqno_())
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                wsrep_seqno_t left;
+                long const    released(update_last_left(left));
+
+                if (released > 0) wake_up(left - released + 1, left);
             }
         }
 
         void interrupt(const C& obj)
         {
-
-            size_t   idx (indexof(obj.seqno()));
+            wsrep_seqno_t const obj_seqno(obj.seqno());
             gu::Lock lock(mutex_);
 
-            while (obj.seqno() - last_left_ >= process_size_)
-                // TODO: exit on error
             {
-                lock.wait(cond_);
+                Waiting waiting(*this);
+
+                while (obj_seqno - last_left_() >= max_size_())
+                    // TODO: exit on error
+                {
+                    lock.wait(cond_);
+                }
             }
 
-            if ((process_[idx].state_ == Process::S_IDLE &&
-                 obj.seqno()          >  last_left_ ) ||
-                process_[idx].state_ == Process::S_WAITING )
+            if (obj_seqno <= last_left_())
+            {
+                log_debug << "interrupting " << obj_seqno
+                          << " le " << last_entered_()
+                          << " ll " << last_left_();
+                return;
+            }
+
+            reserve(obj_seqno);
+
+            Slot&    p(slot(obj_seqno));
+            uint64_t idle(p.word_());
+
+            // slot can concurrently change only from S_IDLE to S_APPLYING
+            // (entering without waiting), everything else is under mutex_
+            if ((Slot::state(idle) == Slot::S_IDLE &&
+                 p.word_.compare_and_swap(idle, Slot::word(
+                                              obj_seqno, Slot::S_CANCELED))) ||
+                p.transit(obj_seqno, Slot::S_WAITING, Slot::S_CANCELED))
             {
-                process_[idx].state_ = Process::S_CANCELED;
-                process_[idx].cond_.signal();
+                if (p.waiter_) p.waiter_->cond_.signal();
                 // since last_left + 1 cannot be <= S_WAITING we're not
                 // modifying a window here. No broadcasting.
             }
             else
             {
-                log_debug << "interrupting " << obj.seqno()
-                          << " state " << process_[idx].state_
-                          << " le " << last_entered_
-                          << " ll " << last_left_;
+                log_debug << "interrupting " << obj_seqno
+                          << " state " << p.state()
+                          << " le " << last_entered_()
+                          << " ll " << last_left_();
             }
         }
 
-        wsrep_seqno_t last_left()   const
+        wsrep_seqno_t last_left()   const { return last_left_(); }
+
+        // maximum window size
+        ssize_t       size()        const { return max_size_(); }
+
+        // current slot ring size
+        ssize_t       capacity()    const { return mask_ + 1; }
+
+        void set_size(ssize_t const max_size)
         {
             gu::Lock lock(mutex_);
-            return last_left_;
+
+            max_size_ = check_size(max_size);
+
+            if (capacity() > max_size_()) try_shrink(max_size_());
+
+            cond_.broadcast(); // window might have grown
         }
-        ssize_t       size()        const { return process_size_; }
 
         bool would_block (wsrep_seqno_t seqno) const
         {
-            return (seqno - last_left_ >= process_size_ ||
-                    seqno > drain_seqno_);
+            return (seqno - last_left_() >= max_size_() ||
+                    seqno > drain_seqno_());
         }
 
         void drain(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
 
-            while (drain_seqno_ != LLONG_MAX)
+            while (drain_seqno_() != LLONG_MAX)
             {
                 lock.wait(cond_);
             }
@@ -251,7 +441,10 @@ namespace galera
             drain_common(seqno, lock);
 
             // there can be some stale canceled entries
-            update_last_left();
+            wsrep_seqno_t left;
+            long const    released(update_last_left(left));
+
+            if (released > 0) wake_up(left - released + 1, left);
 
             drain_seqno_ = LLONG_MAX;
             cond_.broadcast();
@@ -260,33 +453,45 @@ namespace galera
         void wait(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
-            if (last_left_ < seqno)
+            if (last_left_() < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_);
+                Waiter w(WSREP_SEQNO_UNDEFINED, seqno);
+                add_waiter(w);
+                if (last_left_() < seqno) lock.wait(w.cond_);
+                remove_waiter(w);
             }
         }
 
         void wait(wsrep_seqno_t seqno, const gu::datetime::Date& wait_until)
         {
             gu::Lock lock(mutex_);
-            if (last_left_ < seqno)
+            if (last_left_() < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_, wait_until);
+                Waiter w(WSREP_SEQNO_UNDEFINED, seqno);
+                add_waiter(w);
+                try
+                {
+                    if (last_left_() < seqno) lock.wait(w.cond_, wait_until);
+                }
+                catch (...)
+                {
+                    remove_waiter(w);
+                    throw;
+                }
+                remove_waiter(w);
             }
         }
 
 
         void get_stats(double* oooe, double* oool, double* win_size)
         {
-            gu::Lock lock(mutex_);
+            long const entered(entered_());
 
-            if (entered_ > 0)
+            if (entered > 0)
             {
-                *oooe = (oooe_ > 0 ? double(oooe_)/entered_ : .0);
-                *oool = (oool_ > 0 ? double(oool_)/entered_ : .0);
-                *win_size = (win_size_ > 0 ? double(win_size_)/entered_ : .0);
+                *oooe = double(oooe_())/entered;
+                *oool = double(oool_())/entered;
+                *win_size = double(win_size_())/entered;
             }
             else
             {
@@ -296,115 +501,279 @@ namespace galera
 
         void flush_stats()
         {
-            gu::Lock lock(mutex_);
             oooe_ = 0; oool_ = 0; win_size_ = 0; entered_ = 0;
         }
 
     private:
 
-        size_t indexof(wsrep_seqno_t seqno)
+        static ssize_t check_size(ssize_t const size)
+        {
+            if (size < MIN_SIZE || size > MAX_SIZE || (size & (size - 1)))
+            {
+                gu_throw_error(EINVAL) << "Invalid monitor window size: "
+                                       << size << ", must be a power of 2 "
+                                       << "between " << MIN_SIZE << " and "
+                                       << MAX_SIZE;
+            }
+
+            return size;
+        }
+
+        Slot& slot(wsrep_seqno_t const seqno) const
         {
-            return (seqno & process_mask_);
+            return slots_[seqno & mask_];
         }
 
         bool may_enter(const C& obj) const
         {
-            return obj.condition(last_entered_, last_left_);
+            return (last_left_() >= obj.depends_seqno());
+        }
+
+        // enter without locking mutex_ if the object does not have to wait
+        bool try_enter(C& obj)
+        {
+            const wsrep_seqno_t obj_seqno(obj.seqno());
+
+            if (would_block(obj_seqno) || may_enter(obj) == false)
+            {
+                return false;
+            }
+
+            FastPath fp(*this);
+
+            if (!fp.ok()) return false;
+
+            // seqno does not fit in slot ring, needs to grow it
+            if (obj_seqno - last_left_() > wsrep_seqno_t(mask_)) return false;
+
+            Slot&          p(slot(obj_seqno));
+            uint64_t const idle(p.word_());
+
+            if (Slot::state(idle) != Slot::S_IDLE) return false;
+
+            uint64_t expected(idle);
+
+            if (!p.word_.compare_and_swap(expected,
+                                          Slot::word(obj_seqno,
+                                                     Slot::S_APPLYING)))
+            {
+                return false; // interrupted
+            }
+
+            // drain could have started after would_block() check: pairs with
+            // drain_seqno_ update in drain_common()
+            if (gu_unlikely(obj_seqno > drain_seqno_()))
+            {
+                p.word_ = idle;
+                return false;
+            }
+
+            update_last_entered(obj_seqno);
+            update_stats(obj_seqno);
+
+            return true;
+        }
+
+        void update_last_entered(wsrep_seqno_t const obj_seqno)
+        {
+            wsrep_seqno_t le(last_entered_());
+
+            while (le < obj_seqno &&
+                   !last_entered_.compare_and_swap(le, obj_seqno)) {}
+        }
+
+        void update_stats(wsrep_seqno_t const obj_seqno)
+        {
+            wsrep_seqno_t const left(last_left_());
+
+            ++entered_;
+            if (left + 1 < obj_seqno) ++oooe_;
+            win_size_ += (last_entered_() - left);
         }
 
         // wait until it is possible to grab slot in monitor,
         // update last entered
         void pre_enter(C& obj, gu::Lock& lock)
         {
-            assert(last_left_ <= last_entered_);
+            assert(last_left_() <= last_entered_());
 
             const wsrep_seqno_t obj_seqno(obj.seqno());
 
-            while (would_block (obj_seqno)) // TODO: exit on error
             {
-                obj.unlock();
-                lock.wait(cond_);
-                obj.lock();
+                Waiting waiting(*this);
+
+                while (would_block (obj_seqno)) // TODO: exit on error
+                {
+                    obj.unlock();
+                    lock.wait(cond_);
+                    obj.lock();
+                }
             }
 
-            if (last_entered_ < obj_seqno) last_entered_ = obj_seqno;
+            reserve(obj_seqno);
+            update_last_entered(obj_seqno);
         }
 
-        void update_last_left()
+        // Releases finished slots following last_left_ and advances
+        // last_left_ past them. Can be called concurrently: a slot is
+        // released by the thread which manages to switch it from S_FINISHED
+        // to S_IDLE, and only that thread can advance last_left_ to that
+        // slot seqno. Returns the number of slots released by this call,
+        // left is set to the last released seqno.
+        long update_last_left(wsrep_seqno_t& left)
         {
-            for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
-            {
-                Process& a(process_[indexof(i)]);
+            long ret(0);
 
-                if (Process::S_FINISHED == a.state_)
-                {
-                    a.state_   = Process::S_IDLE;
-                    last_left_ = i;
-                    a.wait_cond_.broadcast();
-                }
-                else
+            for (left = last_left_();; ++left, ++ret)
+            {
+                if (!slot(left + 1).transit(left + 1,
+                                            Slot::S_FINISHED,
+                                            Slot::S_IDLE))
                 {
                     break;
                 }
+
+                last_left_ = left + 1;
             }
-            assert(last_left_ <= last_entered_);
+
+            return ret;
+        }
+
+        // must be called with mutex_ locked
+        void add_waiter(Waiter& w)
+        {
+            Slot& s(slot(w.wait_for_));
+
+            w.next_   = s.waiters_;
+            w.linked_ = true;
+            s.waiters_ = &w;
+
+            // must be visible before the waited condition is checked again,
+            // pairs with waiters_ check in post_leave()
+            ++waiters_;
         }
 
-        void wake_up_next()
+        // must be called with mutex_ locked, w may be already removed by
+        // wake_waiters()
+        void remove_waiter(Waiter& w)
         {
-            for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
+            if (w.linked_)
+            {
+                Waiter** p(&slot(w.wait_for_).waiters_);
+
+                while (*p != &w) p = &(*p)->next_;
+
+                *p        = w.next_;
+                w.next_   = 0;
+                w.linked_ = false;
+            }
+
+            --waiters_;
+        }
+
+        // must be called with mutex_ locked, wakes up those waiting on slot
+        // whose seqnos have been left
+        void wake_waiters(Slot& a)
+        {
+            wsrep_seqno_t const left(last_left_());
+
+            for (Waiter** p(&a.waiters_); *p != 0;)
             {
-                Process& a(process_[indexof(i)]);
-                if (a.state_           == Process::S_WAITING &&
-                    may_enter(*a.obj_) == true)
+                Waiter* const w(*p);
+
+                if (w->wait_for_ > left) // waits for a later seqno
+                {
+                    p = &w->next_;
+                    continue;
+                }
+
+                *p          = w->next_;
+                w->next_    = 0;
+                w->linked_  = false;
+
+                if (w->seqno_ != WSREP_SEQNO_UNDEFINED &&
+                    slot(w->seqno_).state() == Slot::S_WAITING)
                 {
                     // We need to set state to APPLYING here because if
                     // it is  the last_left_ + 1 and it gets canceled in
                     // the race  that follows exit from this function,
                     // there will be  nobody to clean up and advance
                     // last_left_.
-                    a.state_ = Process::S_APPLYING;
-                    a.cond_.signal();
+                    slot(w->seqno_).set_state(Slot::S_APPLYING);
                 }
+
+                w->cond_.signal();
             }
         }
 
-        void post_leave(const C& obj, gu::Lock& lock)
+        // must be called with mutex_ locked after releasing slots from
+        // first to last
+        void wake_up(wsrep_seqno_t const first, wsrep_seqno_t const last)
+        {
+            wsrep_seqno_t const end(std::min(last, first + wsrep_seqno_t(mask_)));
+
+            for (wsrep_seqno_t i(first); i <= end; ++i)
+            {
+                wake_waiters(slot(i));
+            }
+
+            // window shrinked and/or drain_seqno_ may be reached
+            cond_.broadcast();
+        }
+
+        void post_leave(const C& obj)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t idx(indexof(obj_seqno));
 
-            if (last_left_ + 1 == obj_seqno) // we're shrinking window
+            wsrep_seqno_t left(0);
+            long          released(0);
+            size_t        mask(0);
+            bool          fast(false);
+
             {
-                process_[idx].state_ = Process::S_IDLE;
-                last_left_           = obj_seqno;
-                process_[idx].wait_cond_.broadcast();
+                FastPath fp(*this);
 
-                update_last_left();
-                oool_ += (last_left_ > obj_seqno);
-                // wake up waiters that may remain above us (last_left_
-                // now is max)
-                wake_up_next();
+                if (gu_likely(fp.ok()))
+                {
+                    fast = true;
+
+                    assert(slot(obj_seqno).state() == Slot::S_APPLYING ||
+                           slot(obj_seqno).state() == Slot::S_CANCELED);
+
+                    slot(obj_seqno).set(obj_seqno, Slot::S_FINISHED);
+                    released = update_last_left(left);
+                    mask     = mask_;
+                }
             }
-            else
+
+            if (gu_unlikely(!fast))
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                gu::Lock lock(mutex_);
+
+                slot(obj_seqno).set(obj_seqno, Slot::S_FINISHED);
+                released = update_last_left(left);
+                mask     = mask_;
+
+                if (released > 0) wake_up(left - released + 1, left);
             }
+            else if (released > 0)
+            {
+                // ring wrapped around: check if it is worth shrinking
+                bool const shrink(ssize_t(mask) >= MIN_SIZE &&
+                                  (left & mask) < size_t(released));
 
-            process_[idx].obj_ = 0;
+                // pairs with waiters_ increment in add_waiter() and Waiting
+                if (waiters_() > 0 || shrink)
+                {
+                    gu::Lock lock(mutex_);
 
-            assert((last_left_ >= obj_seqno &&
-                    process_[idx].state_ == Process::S_IDLE) ||
-                   process_[idx].state_ == Process::S_FINISHED);
-            assert(last_left_ != last_entered_ ||
-                   process_[indexof(last_left_)].state_ == Process::S_IDLE);
+                    wake_up(left - released + 1, left);
 
-            if ((last_left_ >= obj_seqno) ||  // - occupied window shrinked
-                (last_left_ >= drain_seqno_)) // - this is to notify drain that
-                                              //   we reached drain_seqno_
-            {
-                cond_.broadcast();
+                    if (shrink) try_shrink(capacity() / 2);
+                }
             }
+
+            if (released > 0 && left > obj_seqno) ++oool_;
         }
 
         void drain_common(wsrep_seqno_t seqno, gu::Lock& lock)
@@ -413,18 +782,125 @@ namespace galera
 
             drain_seqno_ = seqno;
 
-            if (last_left_ > drain_seqno_)
+            if (last_left_() > drain_seqno_())
             {
                 log_debug << "last left greater than drain seqno";
-                for (wsrep_seqno_t i = drain_seqno_; i <= last_left_; ++i)
+                for (wsrep_seqno_t i = drain_seqno_(); i <= last_left_(); ++i)
                 {
-                    const Process& a(process_[indexof(i)]);
                     log_debug << "applier " << i
-                              << " in state " << a.state_;
+                              << " in state " << slot(i).state();
+                }
+            }
+
+            Waiting waiting(*this);
+
+            while (last_left_() < drain_seqno_()) lock.wait(cond_);
+        }
+
+        // must be called with mutex_ locked: grows slot ring to fit seqno
+        void reserve(wsrep_seqno_t const seqno)
+        {
+            wsrep_seqno_t const span(seqno - last_left_());
+
+            if (gu_likely(span <= wsrep_seqno_t(mask_))) return;
+
+            ssize_t size(capacity());
+            while (size <= span) size *= 2;
+
+            quiesce();
+            resize(size);
+            resume();
+        }
+
+        // must be called with mutex_ locked: halves slot ring if all
+        // occupied slots fit in the smaller one
+        void try_shrink(ssize_t const size)
+        {
+            if (size < MIN_SIZE || size >= capacity()) return;
+
+            // leave room for the window to grow back
+            if ((last_entered_() - last_left_()) * 4 > size) return;
+
+            // slots can't be scanned while lock-free enters may occupy them
+            quiesce();
+
+            if (fits(size)) resize(size);
+
+            resume();
+        }
+
+        // must be called with lock-free sections quiesced: checks that all
+        // occupied slots map to distinct slots in a ring of the given size
+        bool fits(ssize_t const size) const
+        {
+            wsrep_seqno_t const left(last_left_());
+
+            for (size_t i(0); i <= mask_; ++i)
+            {
+                uint64_t const w(slots_[i].word_());
+
+                if (Slot::state(w) != Slot::S_IDLE &&
+                    Slot::seqno(w) - left >= size)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // must be called with mutex_ locked: waits for lock-free sections
+        // in progress to finish, new ones will go for mutex_ until resume()
+        void quiesce()
+        {
+            resizing_ = 1;
+            while (active_() > 0) sched_yield();
+        }
+
+        void resume() { resizing_ = 0; }
+
+        // must be called with mutex_ locked and lock-free sections quiesced
+        void resize(ssize_t const size)
+        {
+            log_debug << "resizing monitor window from " << capacity()
+                      << " to " << size;
+
+            assert(resizing_() != 0);
+
+            Slot* const old(slots_);
+            size_t const old_mask(mask_);
+
+            slots_ = new Slot[size];
+            mask_  = size - 1;
+
+            for (size_t i(0); i <= old_mask; ++i)
+            {
+                Slot&          o(old[i]);
+                uint64_t const w(o.word_());
+
+                if (Slot::state(w) != Slot::S_IDLE)
+                {
+                    Slot& n(slot(Slot::seqno(w)));
+
+                    assert(n.state() == Slot::S_IDLE);
+
+                    n.word_   = w;
+                    n.waiter_ = o.waiter_;
+                }
+
+                // relink waiters to their new slots
+                while (o.waiters_ != 0)
+                {
+                    Waiter* const wt(o.waiters_);
+                    Slot&         n(slot(wt->wait_for_));
+
+                    o.waiters_ = wt->next_;
+                    wt->next_  = n.waiters_;
+                    n.waiters_ = wt;
                 }
             }
 
-            while (last_left_ < drain_seqno_) lock.wait(cond_);
+            delete[] old;
         }
 
         Monitor(const Monitor&);
@@ -432,14 +908,19 @@ namespace galera
 
         gu::Mutex mutex_;
         gu::Cond  cond_;
-        wsrep_seqno_t last_entered_;
-        wsrep_seqno_t last_left_;
-        wsrep_seqno_t drain_seqno_;
-        Process*      process_;
-        long entered_;  // entered
-        long oooe_;     // out of order entered
-        long oool_;     // out of order left
-        long win_size_; // window between last_left_ and last_entered_
+        gu::Atomic<wsrep_seqno_t> last_entered_;
+        gu::Atomic<wsrep_seqno_t> last_left_;
+        gu::Atomic<wsrep_seqno_t> drain_seqno_;
+        Slot*            slots_;
+        size_t           mask_;
+        gu::Atomic<long> max_size_;
+        gu::Atomic<int>  resizing_; // slots_ are being reallocated
+        gu::Atomic<long> active_;   // lock-free sections in progress
+        gu::Atomic<long> waiters_;  // threads waiting on conditions
+        gu::Atomic<long> entered_;  // entered
+        gu::Atomic<long> oooe_;     // out of order entered
+        gu::Atomic<long> oool_;     // out of order left
+        gu::Atomic<long> win_size_; // window between last_left_ and last_entered_
     };
 }
 
@@ -11,6 +11,7 @@
 
 #include <gu_debug_sync.hpp>
 #include <gu_abort.h>
+#include <gu_time.h>
 
 #include <sstream>
 #include <iostream>
@@ -178,9 +179,12 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     ist_senders_        (gcs_, gcache_),
     wsdb_               (),
     cert_               (config_, service_thd_),
-    local_monitor_      (),
-    apply_monitor_      (),
-    commit_monitor_     (),
+    local_monitor_      (gu::from_string<ssize_t>(
+                             config_.get(Param::max_monitor_window))),
+    apply_monitor_      (gu::from_string<ssize_t>(
+                             config_.get(Param::max_monitor_window))),
+    commit_monitor_     (gu::from_string<ssize_t>(
+                             config_.get(Param::max_monitor_window))),
     causal_read_timeout_(config_.get(Param::causal_read_timeout)),
     receivers_          (),
     replicated_         (),
@@ -194,6 +198,12 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     local_cert_failures_(),
     local_replays_      (),
     causal_reads_       (),
+    repl_latency_       (),
+    local_monitor_wait_ (),
+    cert_latency_       (),
+    apply_monitor_wait_ (),
+    apply_latency_      (),
+    commit_monitor_wait_(),
     preordered_id_      (),
     incoming_list_      (""),
     incoming_mutex_     (),
@@ -306,7 +316,9 @@ wsrep_status_t galera::ReplicatorSMM::connect(const std::string& cluster_name,
         ret = WSREP_NODE_FAIL;
     }
 
-    gcache_.reset();
+    /* history recovered from gcache file can be used for IST only if it
+     * leads to the current state */
+    gcache_.recover(to_gu_uuid(gcs_uuid), seqno);
 
     if (ret == WSREP_OK &&
         (err = gcs_.connect(cluster_name, cluster_url, bootstrap)) != 0)
@@ -441,19 +453,27 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     ApplyOrder ao(*trx);
     CommitOrder co(*trx, co_mode_);
 
+    long long const am_start(gu_time_monotonic());
     gu_trace(apply_monitor_.enter(ao));
     trx->set_state(TrxHandle::S_APPLYING);
 
     wsrep_trx_meta_t meta = {{state_uuid_, trx->global_seqno() },
                              trx->depends_seqno()};
 
+    long long const apply_start(gu_time_monotonic());
+    apply_monitor_wait_.insert(apply_start - am_start);
+
     gu_trace(apply_trx_ws(recv_ctx, apply_cb_, commit_cb_, *trx, meta));
     /* at this point any exception in apply_trx_ws() is fatal, not
      * catching anything. */
 
+    long long const cm_start(gu_time_monotonic());
+    apply_latency_.insert(cm_start - apply_start);
+
     if (gu_likely(co_mode_ != CommitOrder::BYPASS))
     {
         gu_trace(commit_monitor_.enter(co));
+        commit_monitor_wait_.insert(gu_time_monotonic() - cm_start);
     }
     trx->set_state(TrxHandle::S_COMMITTING);
 
@@ -545,6 +565,7 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
 
     trx->set_state(TrxHandle::S_REPLICATING);
 
+    long long const repl_start(gu_time_monotonic());
     ssize_t rcode(-1);
 
     do
@@ -614,6 +635,7 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
 
     ++replicated_;
     replicated_bytes_ += rcode;
+    repl_latency_.insert(gu_time_monotonic() - repl_start);
     trx->set_gcs_handle(-1);
 
     if (trx->new_version())
@@ -768,9 +790,12 @@ wsrep_status_t galera::ReplicatorSMM::pre_commit(TrxHandle*        trx,
     CommitOrder co(*trx, co_mode_);
     bool interrupted(false);
 
+    long long const am_start(gu_time_monotonic());
+
     try
     {
         gu_trace(apply_monitor_.enter(ao));
+        apply_monitor_wait_.insert(gu_time_monotonic() - am_start);
     }
     catch (gu::Exception& e)
     {
@@ -790,9 +815,12 @@ wsrep_status_t galera::ReplicatorSMM::pre_commit(TrxHandle*        trx,
         trx->set_state(TrxHandle::S_COMMITTING);
         if (co_mode_ != CommitOrder::BYPASS)
         {
+            long long const cm_start(gu_time_monotonic());
+
             try
             {
                 gu_trace(commit_monitor_.enter(co));
+                commit_monitor_wait_.insert(gu_time_monotonic() - cm_start);
             }
             catch (gu::Exception& e)
             {
@@ -1102,8 +1130,8 @@ writeset_from_handle (wsrep_po_handle_t& handle,
                 trx_params.working_dir_, wsrep_trx_id_t(&handle),
                 /* key format is not essential since we're not adding keys */
                 KeySet::version(trx_params.key_format_), NULL, 0,
-                0, WriteSetNG::MAX_VERSION, DataSet::MAX_VERSION, DataSet::MAX_VERSION,
-                trx_params.max_write_set_size_);
+                0, WriteSetNG::MAX_VERSION, trx_params.data_format_,
+                trx_params.data_format_, trx_params.max_write_set_size_);
 
             handle.opaque = ret;
         }
@@ -1300,10 +1328,12 @@ void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
         break;
     case 5:
         trx_params_.version_ = 3;
+        trx_params_.data_format_ = DataSet::VER1;
         str_proto_ver_ = 1;
         break;
     case 6:
         trx_params_.version_  = 3;
+        trx_params_.data_format_ = DataSet::VER1;
         str_proto_ver_ = 2; // gcs intelligent donor selection.
         // include handling dangling comma in donor string.
         break;
@@ -1311,6 +1341,13 @@ void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
         // Protocol upgrade to handle IST SSL backwards compatibility,
         // no effect to TRX or STR protocols.
         trx_params_.version_ = 3;
+        trx_params_.data_format_ = DataSet::VER1;
+        str_proto_ver_ = 2;
+        break;
+    case 8:
+        // CRC32C data set checksums
+        trx_params_.version_ = 3;
+        trx_params_.data_format_ = DataSet::VER2;
         str_proto_ver_ = 2;
         break;
     default:
@@ -1459,6 +1496,10 @@ galera::ReplicatorSMM::process_conf_change(void*                    recv_ctx,
         {
             if (view_info.view == 1 || !app_wants_st)
             {
+                // cached history belongs to the old state
+                if (state_uuid_ != group_uuid)
+                    gcache_.seqno_reset(to_gu_uuid(group_uuid));
+
                 update_state_uuid (group_uuid);
                 apply_monitor_.set_initial_position(group_seqno);
                 if (co_mode_ != CommitOrder::BYPASS)
@@ -1798,6 +1839,8 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     bool interrupted(false);
 
+    long long const lm_start(gu_time_monotonic());
+
     try
     {
         gu_trace(local_monitor_.enter(lo));
@@ -1813,6 +1856,9 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     if (gu_likely (!interrupted))
     {
+        long long const cert_start(gu_time_monotonic());
+        local_monitor_wait_.insert(cert_start - lm_start);
+
         switch (cert_.append_trx(trx))
         {
         case Certification::TEST_OK:
@@ -1867,6 +1913,8 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
                               trx->global_seqno(),
                               trx->depends_seqno());
 
+        cert_latency_.insert(gu_time_monotonic() - cert_start);
+
         local_monitor_.leave(lo);
     }
     else
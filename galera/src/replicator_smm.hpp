@@ -25,6 +25,7 @@
 #include "gcs_action_source.hpp"
 #include "ist.hpp"
 #include "gu_atomic.hpp"
+#include "gu_latency_histogram.hpp"
 #include "saved_state.hpp"
 #include "gu_debug_sync.hpp"
 
@@ -176,6 +177,7 @@ namespace galera
             static const std::string commit_order;
             static const std::string causal_read_timeout;
             static const std::string max_write_set_size;
+            static const std::string max_monitor_window;
         };
 
         typedef std::pair<std::string, std::string> Default;
@@ -234,11 +236,8 @@ namespace galera
 
             wsrep_seqno_t seqno() const { return seqno_; }
 
-            bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
-            {
-                return (last_left + 1 == seqno_);
-            }
+            // seqno that must be left before entering the monitor
+            wsrep_seqno_t depends_seqno() const { return seqno_ - 1; }
 
 #ifdef GU_DBUG_ON
             void debug_sync(gu::Mutex& mutex)
@@ -270,11 +269,10 @@ namespace galera
 
             wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
 
-            bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
+            wsrep_seqno_t depends_seqno() const
             {
-                return (trx_.is_local() == true ||
-                        last_left >= trx_.depends_seqno());
+                return (trx_.is_local() == true ?
+                        WSREP_SEQNO_UNDEFINED : trx_.depends_seqno());
             }
 
 #ifdef GU_DBUG_ON
@@ -335,8 +333,7 @@ namespace galera
             void lock()   { trx_.lock();   }
             void unlock() { trx_.unlock(); }
             wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
-            bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
+            wsrep_seqno_t depends_seqno() const
             {
                 switch (mode_)
                 {
@@ -344,12 +341,13 @@ namespace galera
                     gu_throw_fatal
                         << "commit order condition called in bypass mode";
                 case OOOC:
-                    return true;
+                    return WSREP_SEQNO_UNDEFINED;
                 case LOCAL_OOOC:
-                    return trx_.is_local();
-                    // in case of remote trx fall through
+                    if (trx_.is_local()) return WSREP_SEQNO_UNDEFINED;
+                    // remote trxs are ordered as in NO_OOOC
+                    // fall through
                 case NO_OOOC:
-                    return (last_left + 1 == trx_.global_seqno());
+                    return (trx_.global_seqno() - 1);
                 }
                 gu_throw_fatal << "invalid commit mode value " << mode_;
             }
@@ -571,6 +569,14 @@ namespace galera
         gu::Atomic<long long> local_replays_;
         gu::Atomic<long long> causal_reads_;
 
+        // per-stage latencies of local and applied trxs
+        gu::LatencyHistogram  repl_latency_;        // replicate -> deliver
+        gu::LatencyHistogram  local_monitor_wait_;
+        gu::LatencyHistogram  cert_latency_;
+        gu::LatencyHistogram  apply_monitor_wait_;
+        gu::LatencyHistogram  apply_latency_;
+        gu::LatencyHistogram  commit_monitor_wait_;
+
         gu::Atomic<long long> preordered_id_; // temporary preordered ID
 
         // non-atomic stats
@@ -25,8 +25,10 @@ const std::string galera::ReplicatorSMM::Param::key_format =
     common_prefix + "key_format";
 const std::string galera::ReplicatorSMM::Param::max_write_set_size =
     common_prefix + "max_ws_size";
+const std::string galera::ReplicatorSMM::Param::max_monitor_window =
+    common_prefix + "max_monitor_window";
 
-int const galera::ReplicatorSMM::MAX_PROTO_VER(7);
+int const galera::ReplicatorSMM::MAX_PROTO_VER(8);
 
 galera::ReplicatorSMM::Defaults::Defaults() : map_()
 {
@@ -39,6 +41,8 @@ galera::ReplicatorSMM::Defaults::Defaults() : map_()
     const int max_write_set_size(galera::WriteSetNG::MAX_SIZE);
     map_.insert(Default(Param::max_write_set_size,
                         gu::to_string(max_write_set_size)));
+    map_.insert(Default(Param::max_monitor_window,
+                        gu::to_string(Monitor<LocalOrder>::DEFAULT_SIZE)));
 }
 
 const galera::ReplicatorSMM::Defaults galera::ReplicatorSMM::defaults;
@@ -166,6 +170,14 @@ galera::ReplicatorSMM::set_param (const std::string& key,
     {
         trx_params_.max_write_set_size_ = gu::from_string<int>(value);
     }
+    else if (key == Param::max_monitor_window)
+    {
+        ssize_t const size(gu::from_string<ssize_t>(value));
+
+        local_monitor_.set_size(size);
+        apply_monitor_.set_size(size);
+        commit_monitor_.set_size(size);
+    }
     else
     {
         log_warn << "parameter '" << key << "' not found";
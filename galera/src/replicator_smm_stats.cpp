@@ -99,6 +99,8 @@ typedef enum status_vars
     STATS_LOCAL_CACHED_DOWNTO,
     STATS_FC_PAUSED_NS,
     STATS_FC_PAUSED_AVG,
+    STATS_FC_THROTTLED_NS,
+    STATS_FC_THROTTLED_AVG,
     STATS_FC_SENT,
     STATS_FC_RECEIVED,
     STATS_CERT_DEPS_DISTANCE,
@@ -146,6 +148,8 @@ static const struct wsrep_stats_var wsrep_stats[STATS_MAX + 1] =
     { "local_cached_downto",      WSREP_VAR_INT64,  { 0 }  },
     { "flow_control_paused_ns",   WSREP_VAR_INT64,  { 0 }  },
     { "flow_control_paused",      WSREP_VAR_DOUBLE, { 0 }  },
+    { "flow_control_throttled_ns",WSREP_VAR_INT64,  { 0 }  },
+    { "flow_control_throttled",   WSREP_VAR_DOUBLE, { 0 }  },
     { "flow_control_sent",        WSREP_VAR_INT64,  { 0 }  },
     { "flow_control_recv",        WSREP_VAR_INT64,  { 0 }  },
     { "cert_deps_distance",       WSREP_VAR_DOUBLE, { 0 }  },
@@ -219,6 +223,8 @@ galera::ReplicatorSMM::stats_get()
         seqno_min != GCS_SEQNO_ILL ? seqno_min : GCS_SEQNO_NIL;
     sv[STATS_FC_PAUSED_NS        ].value._int64  = stats.fc_paused_ns;
     sv[STATS_FC_PAUSED_AVG       ].value._double = stats.fc_paused_avg;
+    sv[STATS_FC_THROTTLED_NS     ].value._int64  = stats.fc_throttled_ns;
+    sv[STATS_FC_THROTTLED_AVG    ].value._double = stats.fc_throttled_avg;
     sv[STATS_FC_SENT             ].value._int64  = stats.fc_sent;
     sv[STATS_FC_RECEIVED         ].value._int64  = stats.fc_received;
 
@@ -261,6 +267,20 @@ galera::ReplicatorSMM::stats_get()
     // Get gcs backend status
     gu::Status status;
     gcs_.get_status(status);
+
+    // Per-stage latencies. Format: "p50/p90/p99/p99.9/max/samples", e.g.
+    // "0.0012/0.0034/0.011/0.025/0.031/123456". The first five fields are
+    // in seconds; percentiles are approximate (within 12.5%, see
+    // gu::LatencyHistogram). samples is the number of measurements since
+    // the last stats reset. All fields are 0 if there were none.
+    // Note: this differs from evs_repl_latency, which is
+    // "min/avg/max/stddev/samples" (gu::Stats).
+    status.insert("repl_latency",           repl_latency_.to_string());
+    status.insert("local_monitor_latency",  local_monitor_wait_.to_string());
+    status.insert("cert_latency",           cert_latency_.to_string());
+    status.insert("apply_monitor_latency",  apply_monitor_wait_.to_string());
+    status.insert("apply_latency",          apply_latency_.to_string());
+    status.insert("commit_monitor_latency", commit_monitor_wait_.to_string());
 #ifdef GU_DBUG_ON
     status.insert("debug_sync_waiters", gu_debug_sync_waiters());
 #endif // GU_DBUG_ON
@@ -351,6 +371,13 @@ galera::ReplicatorSMM::stats_reset()
     commit_monitor_.flush_stats();
 
     cert_.stats_reset();
+
+    repl_latency_.clear();
+    local_monitor_wait_.clear();
+    cert_latency_.clear();
+    apply_monitor_wait_.clear();
+    apply_latency_.clear();
+    commit_monitor_wait_.clear();
 }
 
 void
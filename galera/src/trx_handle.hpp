@@ -43,10 +43,12 @@ namespace galera
             std::string     working_dir_;
             int             version_;
             KeySet::Version key_format_;
+            DataSet::Version data_format_;
             int             max_write_set_size_;
             Params (const std::string& wdir, int ver, KeySet::Version kformat,
                     int max_write_set_size = WriteSetNG::MAX_SIZE) :
                 working_dir_(wdir), version_(ver), key_format_(kformat),
+                data_format_(DataSet::MAX_VERSION),
                 max_write_set_size_(max_write_set_size) {}
         };
 
@@ -709,8 +711,8 @@ namespace galera
                                        store_size - sizeof(WriteSetOut),
                                        0,
                                        WriteSetNG::MAX_VERSION,
-                                       DataSet::MAX_VERSION,
-                                       DataSet::MAX_VERSION,
+                                       params.data_format_,
+                                       params.data_format_,
                                        params.max_write_set_size_);
             }
         }
@@ -6,10 +6,15 @@
 #include "write_set_ng.hpp"
 
 #include "gu_time.h"
+#include "gu_lock.hpp"
 
 #include <gu_macros.hpp>
 
 #include <iomanip>
+#include <deque>
+
+#include <pthread.h>
+#include <unistd.h>
 
 namespace galera
 {
@@ -186,6 +191,132 @@ const char WriteSetOut::unrd_suffix[] = "_unrd";
 const char WriteSetOut::annt_suffix[] = "_annt";
 
 
+/* Threads are started on demand, up to the number of online CPUs, and stay
+ * around for the rest of the process lifetime. */
+class WriteSetIn::CheckPool
+{
+public:
+
+    CheckPool()
+        :
+        mtx_      (),
+        cond_     (),
+        done_cond_(),
+        queue_    (),
+        thds_     (),
+        idle_     (0),
+        stop_     (false)
+    {}
+
+    ~CheckPool()
+    {
+        {
+            gu::Lock lock(mtx_);
+            stop_ = true;
+            cond_.broadcast();
+        }
+
+        for (size_t i(0); i < thds_.size(); ++i) pthread_join(thds_[i], NULL);
+    }
+
+    /* @return false if no worker thread could be started */
+    bool submit (WriteSetIn* const ws)
+    {
+        gu::Lock lock(mtx_);
+
+        if (idle_ <= queue_.size() && thds_.size() < max_threads())
+        {
+            pthread_t thd;
+            int const err(pthread_create(&thd, NULL, run, this));
+
+            if (gu_likely(0 == err))
+            {
+                thds_.push_back(thd);
+            }
+            else
+            {
+                log_warn << "Starting checksum thread failed: " << err
+                         << '(' << ::strerror(err) << ')';
+
+                if (thds_.empty()) return false;
+            }
+        }
+
+        ws->check_done_ = false;
+        queue_.push_back(ws);
+        cond_.signal();
+
+        return true;
+    }
+
+    void wait (const WriteSetIn* const ws)
+    {
+        gu::Lock lock(mtx_);
+
+        while (!ws->check_done_) lock.wait(done_cond_);
+    }
+
+private:
+
+    static size_t max_threads()
+    {
+        long const cpus(sysconf(_SC_NPROCESSORS_ONLN));
+        return (cpus > 0 ? cpus : 1);
+    }
+
+    static void* run (void* arg)
+    {
+        static_cast<CheckPool*>(arg)->work();
+        return NULL;
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            WriteSetIn* ws;
+
+            {
+                gu::Lock lock(mtx_);
+
+                ++idle_;
+                while (queue_.empty() && !stop_) lock.wait(cond_);
+                --idle_;
+
+                if (queue_.empty()) return; // stop_
+
+                ws = queue_.front();
+                queue_.pop_front();
+            }
+
+            ws->checksum();
+
+            gu::Lock lock(mtx_);
+            ws->check_done_ = true;
+            done_cond_.broadcast();
+        }
+    }
+
+    gu::Mutex               mtx_;
+    gu::Cond                cond_;      // wakes up workers
+    gu::Cond                done_cond_; // wakes up waiters
+    std::deque<WriteSetIn*> queue_;
+    std::vector<pthread_t>  thds_;
+    size_t                  idle_;
+    bool                    stop_;
+
+    CheckPool (const CheckPool&);
+    CheckPool& operator= (const CheckPool&);
+};
+
+WriteSetIn::CheckPool WriteSetIn::check_pool_;
+
+void
+WriteSetIn::check_wait() const
+{
+    check_pool_.wait(this);
+}
+
 void
 WriteSetIn::init (ssize_t const st)
 {
@@ -208,18 +339,12 @@ WriteSetIn::init (ssize_t const st)
         if (size_ >= st)
         {
             /* buffer too big, start checksumming in background */
-            int const err(pthread_create (&check_thr_id_, NULL,
-                                          checksum_thread, this));
-
-            if (gu_likely(0 == err))
+            if (gu_likely(check_pool_.submit(this)))
             {
                 check_thr_ = true;
                 return;
             }
 
-            log_warn << "Starting checksum thread failed: " << err
-                     << '(' << ::strerror(err) << ')';
-
             /* fall through to checksum in foreground */
         }
 
@@ -25,8 +25,6 @@
 #include <string>
 #include <iomanip>
 
-#include <pthread.h>
-
 namespace galera
 {
     class WriteSetNG
@@ -512,6 +510,7 @@ namespace galera
             /* annotation set is not allocated unless requested */
             abn_   (base_name_),
             annt_  (NULL),
+            annt_ver_(dver),
             left_  (max_size - keys_.size() - data_.size() - unrd_.size()
                     - header_.size()),
             flags_ (flags)
@@ -538,7 +537,7 @@ namespace galera
         {
             if (NULL == annt_)
             {
-                annt_ = new DataSetOut(NULL, 0, abn_, DataSet::MAX_VERSION);
+                annt_ = new DataSetOut(NULL, 0, abn_, annt_ver_);
                 left_ -= annt_->size();
             }
 
@@ -653,6 +652,7 @@ namespace galera
         DataSetOut          unrd_;
         BaseNameImpl<annt_suffix> abn_;
         DataSetOut*         annt_;
+        DataSet::Version const annt_ver_; // header carries only data set ver.
         ssize_t             left_;
         uint16_t            flags_;
 
@@ -679,8 +679,8 @@ namespace galera
               data_  (),
               unrd_  (),
               annt_  (NULL),
-              check_thr_id_(),
               check_thr_(false),
+              check_done_(false),
               check_ (false)
         {
             init (st);
@@ -693,8 +693,8 @@ namespace galera
               data_  (),
               unrd_  (),
               annt_  (NULL),
-              check_thr_id_(),
               check_thr_(false),
+              check_done_(false),
               check_ (false)
         {}
 
@@ -722,7 +722,7 @@ namespace galera
             if (gu_unlikely(check_thr_))
             {
                 /* checksum was performed in a parallel thread */
-                pthread_join (check_thr_id_, NULL);
+                check_wait();
             }
 
             delete annt_;
@@ -758,7 +758,7 @@ namespace galera
             if (gu_unlikely(check_thr_))
             {
                 /* checksum was performed in a parallel thread */
-                pthread_join (check_thr_id_, NULL);
+                check_wait();
                 check_thr_ = false;
                 checksum_fin();
             }
@@ -798,8 +798,8 @@ namespace galera
         DataSetIn          data_;
         DataSetIn          unrd_;
         DataSetIn*         annt_;
-        pthread_t          check_thr_id_;
         bool mutable       check_thr_;
+        bool               check_done_; // protected by CheckPool mutex
         bool               check_;
 
         static size_t const SIZE_THRESHOLD = 1 << 22; /* 4Mb */
@@ -814,12 +814,12 @@ namespace galera
             }
         }
 
-        static void* checksum_thread (void* arg)
-        {
-            WriteSetIn* ws(reinterpret_cast<WriteSetIn*>(arg));
-            ws->checksum();
-            return NULL;
-        }
+        /* pool of threads shared by all writesets to checksum them in
+         * background */
+        class CheckPool;
+        static CheckPool check_pool_;
+
+        void check_wait() const;
 
         /* late initialization after default constructor */
         void init (ssize_t size_threshold);
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+/* Certification microbenchmark: one thread certifies write sets in order
+ * (as under local monitor) while other threads run read-only certification
+ * tests concurrently (as for BF-aborted and replaying trxs). Sharding does
+ * not parallelize the in-order path itself, it only keeps the concurrent
+ * tests from stalling it, which is what the reported rate reflects.
+ *
+ * Usage: certification_bench [trxs [keys [testers [shards]]]] */
+
+#include "test_cert.hpp"
+
+#include "gu_logger.hpp"
+#include "gu_time.h"
+
+#include <pthread.h>
+
+#include <iostream>
+
+namespace
+{
+    struct BenchCtx
+    {
+        Certification*              cert;
+        TrxHandle::SlavePool*       pool;
+        const std::vector<TestWriteSet*>* wss;
+        gu::Atomic<long>*           done;
+        long                        tests;
+    };
+
+    extern "C" void* bench_tester(void* arg)
+    {
+        BenchCtx* const ctx(static_cast<BenchCtx*>(arg));
+        unsigned int seed(pthread_self());
+        std::vector<gu::byte_t> buf;
+
+        while ((*ctx->done)() == 0)
+        {
+            const TestWriteSet& ws(*(*ctx->wss)[rand_r(&seed) %
+                                                ctx->wss->size()]);
+            TrxHandle* const trx(ws.trx(*ctx->pool, buf));
+            ctx->cert->test(trx, false);
+            trx->unref();
+            ++ctx->tests;
+        }
+
+        return 0;
+    }
+
+    struct BenchResult
+    {
+        double rate;   // certified keys/sec
+        size_t failed; // number of failed certifications
+        long   tests;  // number of concurrent read-only tests
+    };
+
+    BenchResult cert_bench(int const shards, int const testers,
+                           const std::vector<TestWriteSet*>& wss,
+                           long const keys)
+    {
+        TestEnv env(shards);
+        Bufs bufs; // write set buffers must outlive certification
+        Certification cert(env.conf(), env.thd());
+        gu::Atomic<long> done(0);
+
+        cert.assign_initial_position(0, 3);
+
+        std::vector<pthread_t> thds(testers);
+        std::vector<BenchCtx>  ctxs(testers);
+
+        for (int t(0); t < testers; ++t)
+        {
+            BenchCtx const ctx = { &cert, &env.pool(), &wss, &done, 0 };
+            ctxs[t] = ctx;
+            pthread_create(&thds[t], NULL, bench_tester, &ctxs[t]);
+        }
+
+        double const begin(gu_time_monotonic());
+        size_t failed(0);
+
+        for (size_t i(0); i < wss.size(); ++i)
+        {
+            bufs.push_back(Bufs::value_type());
+            TrxHandle* const trx(wss[i]->trx(env.pool(), bufs.back()));
+            Certification::TestResult const res(cert.append_trx(trx));
+            failed += (res == Certification::TEST_FAILED);
+            wsrep_seqno_t const purge(cert.set_trx_committed(trx));
+            if (purge > 0) cert.purge_trxs_upto(purge, false);
+            trx->unref();
+        }
+
+        double const duration((gu_time_monotonic() - begin) * 1.0e-9);
+
+        done = 1;
+
+        long tests(0);
+        for (int t(0); t < testers; ++t)
+        {
+            pthread_join(thds[t], NULL);
+            tests += ctxs[t].tests;
+        }
+
+        BenchResult const ret = { keys / duration, failed, tests };
+
+        std::cout << "shards: "     << shards
+                  << ", testers: "  << testers
+                  << ", trxs: "     << wss.size()
+                  << ", failed: "   << failed
+                  << ", keys/sec: " << ret.rate
+                  << ", tests: "    << tests
+                  << std::endl;
+
+        return ret;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int const n_trx  (argc > 1 ? atoi(argv[1]) : 8192);
+    int const n_keys (argc > 2 ? atoi(argv[2]) : 64);
+    int const testers(argc > 3 ? atoi(argv[3]) : 4);
+    int const shards (argc > 4 ? atoi(argv[4]) : 16);
+
+    if (n_trx <= 0 || n_keys <= 0 || testers < 0 || shards <= 0)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [trxs [keys [testers [shards]]]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<TestWriteSet*> wss;
+    make_workload(wss, n_trx, n_keys, 1 << 20);
+
+    long const keys(long(n_trx) * n_keys);
+    int  const shard_set[] = { 1, shards };
+    int  const tester_set[] = { 0, testers };
+    int  ret(EXIT_SUCCESS);
+
+    /* neither sharding nor concurrent tests may change the verdicts */
+    BenchResult const base(cert_bench(1, 0, wss, keys));
+
+    for (size_t t(0); t < sizeof(tester_set)/sizeof(tester_set[0]); ++t)
+    {
+        for (size_t s(0); s < sizeof(shard_set)/sizeof(shard_set[0]); ++s)
+        {
+            BenchResult const res(cert_bench(shard_set[s], tester_set[t],
+                                             wss, keys));
+            if (res.failed != base.failed)
+            {
+                std::cerr << "shards: " << shard_set[s]
+                          << ", testers: " << tester_set[t]
+                          << ", failed: " << res.failed
+                          << ", expected: " << base.failed << std::endl;
+                ret = EXIT_FAILURE;
+            }
+        }
+    }
+
+    for (size_t i(0); i < wss.size(); ++i) delete wss[i];
+
+    return ret;
+}
@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+#undef NDEBUG
+
+#define __STDC_FORMAT_MACROS
+
+#include "test_cert.hpp"
+
+#include "gu_logger.hpp"
+
+#include <inttypes.h>
+
+#include <sstream>
+#include <set>
+
+#include <check.h>
+
+using namespace galera;
+
+namespace
+{
+    struct Result
+    {
+        Certification::TestResult res;
+        wsrep_seqno_t             depends;
+    };
+
+    void run_workload(int const                         shards,
+                      const std::vector<TestWriteSet*>& wss,
+                      std::vector<Result>&              results)
+    {
+        TestEnv env(shards);
+        Bufs bufs; // write set buffers must outlive certification
+        Certification cert(env.conf(), env.thd());
+
+
+        cert.assign_initial_position(0, 3);
+
+        for (size_t i(0); i < wss.size(); ++i)
+        {
+            bufs.push_back(Bufs::value_type());
+            TrxHandle* const trx(wss[i]->trx(env.pool(), bufs.back()));
+
+            Result r;
+            r.res     = cert.append_trx(trx);
+            r.depends = trx->depends_seqno();
+            results.push_back(r);
+
+            wsrep_seqno_t const purge(cert.set_trx_committed(trx));
+            if (purge > 0) cert.purge_trxs_upto(purge, false);
+
+            trx->unref();
+        }
+    }
+}
+
+START_TEST(cert_basic)
+{
+    wsrep_uuid_t a, b;
+    gu_uuid_generate(reinterpret_cast<gu_uuid_t*>(&a), NULL, 0);
+    gu_uuid_generate(reinterpret_cast<gu_uuid_t*>(&b), NULL, 0);
+
+    Keys x; x.push_back(Keys::value_type("x", EXCLUSIVE));
+    Keys y; y.push_back(Keys::value_type("y", SHARED));
+    Keys z; z.push_back(Keys::value_type("y", EXCLUSIVE));
+
+    TestWriteSet const ws[] =
+    {
+        TestWriteSet(a, 1, 0, 1, x), // no match
+        TestWriteSet(b, 2, 0, 2, x), // conflicts with 1
+        TestWriteSet(b, 3, 1, 3, x), // depends on 1
+        TestWriteSet(a, 4, 1, 4, y), // no match
+        TestWriteSet(a, 5, 3, 5, z)  // exclusive depends on shared 4
+    };
+
+    Certification::TestResult const res[] =
+    {
+        Certification::TEST_OK,
+        Certification::TEST_FAILED,
+        Certification::TEST_OK,
+        Certification::TEST_OK,
+        Certification::TEST_OK
+    };
+
+    wsrep_seqno_t const deps[] = { 0, WSREP_SEQNO_UNDEFINED, 1, 0, 4 };
+
+    int const shards[] = { 1, 2, CertIndexNG::MAX_SHARDS };
+
+    for (size_t s(0); s < sizeof(shards)/sizeof(shards[0]); ++s)
+    {
+        TestEnv env(shards[s]);
+        Bufs bufs; // write set buffers must outlive certification
+        Certification cert(env.conf(), env.thd());
+
+        cert.assign_initial_position(0, 3);
+
+        std::vector<TrxHandle*> trxs;
+
+        for (size_t i(0); i < sizeof(ws)/sizeof(ws[0]); ++i)
+        {
+            bufs.push_back(Bufs::value_type());
+            TrxHandle* const trx(ws[i].trx(env.pool(), bufs.back()));
+            trxs.push_back(trx);
+
+            Certification::TestResult const r(cert.append_trx(trx));
+
+            fail_if(r != res[i], "shards: %d, trx %zu: expected %d, got %d",
+                    shards[s], i, res[i], r);
+            fail_if(trx->depends_seqno() != deps[i],
+                    "shards: %d, trx %zu: expected depends %" PRId64
+                    ", got %" PRId64, shards[s], i, deps[i],
+                    trx->depends_seqno());
+        }
+
+        for (size_t i(0); i < trxs.size(); ++i)
+        {
+            cert.set_trx_committed(trxs[i]);
+            trxs[i]->unref();
+        }
+    }
+}
+END_TEST
+
+START_TEST(cert_sharded_equivalence)
+{
+    std::vector<TestWriteSet*> wss;
+    make_workload(wss, 4096, 8, 512);
+
+    std::vector<Result> base;
+    run_workload(1, wss, base);
+
+    size_t failed(0);
+    for (size_t i(0); i < base.size(); ++i)
+    {
+        failed += (base[i].res == Certification::TEST_FAILED);
+    }
+    /* make sure that the workload is representative */
+    fail_if(0 == failed || base.size() == failed, "failed: %lu",
+            static_cast<unsigned long>(failed));
+    log_info << "cert equivalence: " << failed << " out of " << base.size()
+             << " trxs failed certification";
+
+    int const shards[] = { 4, 16, CertIndexNG::MAX_SHARDS };
+
+    for (size_t s(0); s < sizeof(shards)/sizeof(shards[0]); ++s)
+    {
+        std::vector<Result> res;
+        run_workload(shards[s], wss, res);
+
+        fail_if(res.size() != base.size());
+
+        for (size_t i(0); i < res.size(); ++i)
+        {
+            fail_if(res[i].res != base[i].res,
+                    "shards: %d, trx %zu: expected %d, got %d",
+                    shards[s], i, base[i].res, res[i].res);
+            fail_if(res[i].depends != base[i].depends,
+                    "shards: %d, trx %zu: expected depends %" PRId64
+                    ", got %" PRId64, shards[s], i, base[i].depends,
+                    res[i].depends);
+        }
+    }
+
+    for (size_t i(0); i < wss.size(); ++i) delete wss[i];
+}
+END_TEST
+
+START_TEST(cert_deps_set)
+{
+    CertDepsSet ds;
+    std::multiset<wsrep_seqno_t> ref;
+
+    fail_if(!ds.empty());
+
+    unsigned int seed(1);
+    wsrep_seqno_t seqno(100);
+
+    /* sliding window of last seen seqnos, lagging behind by up to 3000,
+     * which forces the ring to grow */
+    for (int i(0); i < 100000; ++i)
+    {
+        seqno += rand_r(&seed) % 2;
+
+        if (ref.size() < 2000 || rand_r(&seed) % 2)
+        {
+            wsrep_seqno_t const s(seqno - rand_r(&seed) % 3000);
+            ds.insert(s);
+            ref.insert(s);
+        }
+        else
+        {
+            /* erase either the lowest or a random element */
+            std::multiset<wsrep_seqno_t>::iterator it(ref.begin());
+            if (rand_r(&seed) % 2)
+            {
+                std::advance(it, rand_r(&seed) % ref.size());
+            }
+            ds.erase(*it);
+            ref.erase(it);
+        }
+
+        fail_if(ds.size() != ref.size());
+        fail_if(ds.empty() != ref.empty());
+        if (!ref.empty())
+        {
+            fail_if(ds.lowest() != *ref.begin(), "expected %" PRId64
+                    ", got %" PRId64, *ref.begin(), ds.lowest());
+        }
+    }
+}
+END_TEST
+
+START_TEST(cert_deps_set_outliers)
+{
+    CertDepsSet ds;
+    std::multiset<wsrep_seqno_t> ref;
+
+    wsrep_seqno_t seqno(1000000);
+
+    for (wsrep_seqno_t s(seqno); s < seqno + 1000; ++s)
+    {
+        ds.insert(s);
+        ref.insert(s);
+    }
+
+    /* a stale and a distant last seen seqno must not blow up the ring */
+    ds.insert(1);
+    ref.insert(1);
+    ds.insert(seqno + (wsrep_seqno_t(1) << 40));
+    ref.insert(seqno + (wsrep_seqno_t(1) << 40));
+
+    fail_if(ds.capacity() > CertDepsSet::MAX_CAPACITY,
+            "capacity %zu", ds.capacity());
+    fail_if(ds.lowest() != 1, "expected 1, got %" PRId64, ds.lowest());
+    fail_if(ds.count(1) != 1);
+    fail_if(ds.size() != ref.size());
+
+    unsigned int seed(1);
+
+    for (int i(0); i < 100000; ++i)
+    {
+        seqno += rand_r(&seed) % 2;
+
+        if (ref.size() < 2000 || rand_r(&seed) % 2)
+        {
+            wsrep_seqno_t s(seqno - rand_r(&seed) % 3000);
+
+            /* every 100th seqno is far off either way */
+            if (0 == rand_r(&seed) % 100)
+            {
+                s += (rand_r(&seed) % 2 ? 1 : -1) *
+                    wsrep_seqno_t(CertDepsSet::MAX_CAPACITY) *
+                    (1 + rand_r(&seed) % 4);
+            }
+
+            ds.insert(s);
+            ref.insert(s);
+        }
+        else
+        {
+            std::multiset<wsrep_seqno_t>::iterator it(ref.begin());
+            if (rand_r(&seed) % 2)
+            {
+                std::advance(it, rand_r(&seed) % ref.size());
+            }
+            ds.erase(*it);
+            ref.erase(it);
+        }
+
+        fail_if(ds.capacity() > CertDepsSet::MAX_CAPACITY,
+                "capacity %zu", ds.capacity());
+        fail_if(ds.size() != ref.size());
+        if (!ref.empty())
+        {
+            fail_if(ds.lowest() != *ref.begin(), "expected %" PRId64
+                    ", got %" PRId64, *ref.begin(), ds.lowest());
+        }
+    }
+
+    while (!ref.empty())
+    {
+        fail_if(ds.count(*ref.begin()) != ref.count(*ref.begin()));
+        ds.erase(*ref.begin());
+        ref.erase(ref.begin());
+    }
+
+    fail_if(!ds.empty());
+}
+END_TEST
+
+namespace
+{
+    struct CountTrxs
+    {
+        explicit CountTrxs(size_t& n) : n_(n) {}
+        void operator()(TrxHandle*) const { ++n_; }
+        size_t& n_;
+    };
+}
+
+START_TEST(cert_trx_map)
+{
+    TestEnv env(1);
+    CertTrxMap tm;
+
+    fail_if(!tm.empty());
+    fail_if(tm.lowest() != WSREP_SEQNO_UNDEFINED);
+
+    TrxHandle* const trx(TrxHandle::New(env.pool()));
+    size_t purged(0);
+
+    /* every third seqno is missing */
+    for (wsrep_seqno_t s(1); s <= 5000; ++s)
+    {
+        if (s % 3) fail_if(!tm.insert(s, trx));
+    }
+    fail_if(tm.insert(4000, trx), "seqno below the highest accepted");
+    fail_if(tm.size() != 3334, "size %zu", tm.size());
+    fail_if(tm.lowest() != 1);
+    fail_if(tm.find(3) != 0);
+    fail_if(tm.find(4) != trx);
+    fail_if(tm.find(5001) != 0);
+
+    tm.erase_upto(2, CountTrxs(purged));
+    fail_if(purged != 2);
+    fail_if(tm.lowest() != 4, "lowest %" PRId64, tm.lowest());
+    fail_if(tm.size() != 3332);
+
+    tm.erase_upto(5000, CountTrxs(purged));
+    fail_if(purged != 3334);
+    fail_if(!tm.empty());
+    fail_if(tm.lowest() != WSREP_SEQNO_UNDEFINED);
+
+    fail_if(!tm.insert(7, trx));
+    fail_if(tm.lowest() != 7);
+
+    trx->unref();
+}
+END_TEST
+
+/* Checks that memory held by certification index does not grow with the
+ * number of certified write sets: arena segments must be released by purge
+ * even though some keys are referenced again and again. */
+START_TEST(cert_index_memory)
+{
+    int const n_trx(32768), n_keys(8), n_hot(64), shards(4);
+
+    wsrep_uuid_t source;
+    gu_uuid_generate(reinterpret_cast<gu_uuid_t*>(&source), NULL, 0);
+
+    TestEnv env(shards);
+    Bufs bufs; // write set buffers must outlive certification
+    Certification cert(env.conf(), env.thd());
+
+    cert.assign_initial_position(0, 3);
+
+    unsigned int seed(n_trx);
+    size_t       peak(0);
+
+    for (int seqno(1); seqno <= n_trx; ++seqno)
+    {
+        Keys keys;
+
+        std::ostringstream hot;
+        hot << "hot" << rand_r(&seed) % n_hot;
+        keys.push_back(Keys::value_type(hot.str(), EXCLUSIVE));
+
+        for (int k(1); k < n_keys; ++k)
+        {
+            std::ostringstream os;
+            os << seqno << ':' << k;
+            keys.push_back(Keys::value_type(os.str(), EXCLUSIVE));
+        }
+
+        TestWriteSet const ws(source, seqno, seqno - 1, seqno, keys);
+        bufs.push_back(Bufs::value_type());
+        TrxHandle* const trx(ws.trx(env.pool(), bufs.back()));
+
+        fail_if(cert.append_trx(trx) != Certification::TEST_OK);
+
+        wsrep_seqno_t const purge(cert.set_trx_committed(trx));
+        if (purge > 0) cert.purge_trxs_upto(purge, false);
+
+        trx->unref();
+
+        peak = std::max(peak, cert.index_allocated());
+    }
+
+    cert.purge_trxs_upto(n_trx, false);
+
+    size_t const entries_size(size_t(n_trx) * n_keys * sizeof(KeyEntryNG));
+    size_t const min_size(shards * (2 * KeyEntryArena::SEGMENT_SIZE +
+                                    KeyEntryTable::MIN_CAPACITY * 16));
+
+    log_info << "cert index memory: peak " << peak << ", final "
+             << cert.index_allocated() << ", total entries size "
+             << entries_size;
+
+    fail_if(peak * 4 > entries_size, "peak: %zu", peak);
+    fail_if(cert.index_allocated() > min_size, "final: %zu",
+            cert.index_allocated());
+}
+END_TEST
+
+/* Renewing the last live entry of an old arena segment releases that
+ * segment. With a spare segment already kept by the arena it is returned to
+ * the system, so the index must not touch the old entry after that. */
+namespace
+{
+    class TestBaseName : public gu::Allocator::BaseName
+    {
+    public:
+        TestBaseName(const char* name) : str_(name) {}
+        void print(std::ostream& os) const { os << str_; }
+    private:
+        std::string const str_;
+    };
+
+    uintptr_t segment_of(const KeyEntryNG* const ke)
+    {
+        return (reinterpret_cast<uintptr_t>(ke) &
+                ~uintptr_t(KeyEntryArena::SEGMENT_SIZE - 1));
+    }
+}
+
+START_TEST(cert_index_renew)
+{
+    int const n_keys(KeyEntryArena::SEGMENT_SIZE / sizeof(KeyEntryNG) * 3);
+
+    gu::byte_t reserved[1024];
+    TestBaseName const str("cert_index_renew");
+    KeySetOut kso(reserved, sizeof(reserved), str, KeySet::FLAT8A);
+
+    for (int i(0); i < n_keys; ++i)
+    {
+        std::ostringstream os;
+        os << i;
+        std::string const leaf(os.str());
+        TestKey tk(KeySet::FLAT8A, EXCLUSIVE, true, "test", leaf.c_str());
+        kso.append(tk());
+    }
+
+    KeySetOut::GatherVector out;
+    size_t const out_size(kso.gather(out));
+
+    std::vector<gu::byte_t> in;
+    in.reserve(out_size);
+    for (size_t i(0); i < out->size(); ++i)
+    {
+        const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[i].ptr));
+        in.insert(in.end(), ptr, ptr + out[i].size);
+    }
+
+    KeySetIn ksi(kso.version(), &in[0], in.size());
+
+    CertIndexNG idx(1);
+
+    /* fill two segments, A and B, and start the third one, C */
+    std::vector<KeyEntryNG*> seg_a, seg_b;
+    KeyEntryNG* first_c(0);
+    {
+        CertIndexNG::Lock lock(idx, idx.all_shards());
+
+        for (long i(0); 0 == first_c && i < ksi.count(); ++i)
+        {
+            KeyEntryNG* const ke(idx.insert(ksi.next()));
+
+            if (seg_a.empty() || segment_of(ke) == segment_of(seg_a[0]))
+            {
+                seg_a.push_back(ke);
+            }
+            else if (seg_b.empty() || segment_of(ke) == segment_of(seg_b[0]))
+            {
+                seg_b.push_back(ke);
+            }
+            else
+            {
+                first_c = ke;
+            }
+        }
+
+        fail_if(0 == first_c, "inserted less than 3 segments");
+
+        /* B goes to the arena spare segment */
+        for (size_t i(0); i < seg_b.size(); ++i) idx.erase(seg_b[i]);
+
+        for (size_t i(1); i < seg_a.size(); ++i) idx.erase(seg_a[i]);
+    }
+
+    KeySet::KeyPart const kp(seg_a[0]->key());
+    size_t const allocated(idx.allocated());
+    KeyEntryNG* ke;
+    {
+        CertIndexNG::Lock lock(idx, idx.all_shards());
+
+        /* A is freed */
+        ke = idx.renew(seg_a[0]);
+
+        fail_if(segment_of(ke) != segment_of(first_c));
+        fail_if(idx.find(kp) != ke);
+        fail_if(idx.find(first_c->key()) != first_c);
+    }
+
+    fail_if(idx.size() != 2, "index size: %zu", idx.size());
+    fail_if(idx.allocated() + KeyEntryArena::SEGMENT_SIZE != allocated,
+            "allocated: %zu, before: %zu", idx.allocated(), allocated);
+    {
+        CertIndexNG::Lock lock(idx, idx.all_shards());
+
+        idx.erase(ke);
+        idx.erase(first_c);
+    }
+
+    fail_if(!idx.empty());
+}
+END_TEST
+
+Suite* certification_suite()
+{
+    Suite* s = suite_create ("certification");
+    TCase* tc;
+
+    tc = tcase_create ("certification");
+    tcase_add_test  (tc, cert_basic);
+    tcase_add_test  (tc, cert_deps_set);
+    tcase_add_test  (tc, cert_deps_set_outliers);
+    tcase_add_test  (tc, cert_trx_map);
+    tcase_add_test  (tc, cert_sharded_equivalence);
+    tcase_add_test  (tc, cert_index_memory);
+    tcase_add_test  (tc, cert_index_renew);
+    suite_add_tcase (s, tc);
+
+    return s;
+}
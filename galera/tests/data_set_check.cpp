@@ -104,7 +104,8 @@ private:
 };
 
 
-START_TEST (ver0)
+static void
+test_ver (DataSet::Version const ver)
 {
     size_t const MB = 1 << 20;
 
@@ -125,7 +126,7 @@ START_TEST (ver0)
 
     gu::byte_t reserved[1024];
     TestBaseName str("data_set_test");
-    DataSetOut dset_out(reserved, sizeof(reserved), str, DataSet::VER1);
+    DataSetOut dset_out(reserved, sizeof(reserved), str, ver);
 
     size_t offset(dset_out.size());
 
@@ -228,6 +229,38 @@ START_TEST (ver0)
         fail_if (rin != *records[i], "Record %d failed: expected %s, found %s",
                  i, records[i]->c_str(), rin.c_str());
     }
+
+    try
+    {
+        dset_in.checksum();
+    }
+    catch (gu::Exception& e)
+    {
+        fail("%s", e.what());
+    }
+
+    in_buf[in_buf.size() - 1] ^= 1;
+
+    try
+    {
+        dset_in.checksum();
+        fail("payload corruption slipped through");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_if (e.get_errno() != EINVAL);
+    }
+}
+
+START_TEST (ver0)
+{
+    test_ver (DataSet::VER1);
+}
+END_TEST
+
+START_TEST (ver2)
+{
+    test_ver (DataSet::VER2);
 }
 END_TEST
 
@@ -235,6 +268,7 @@ Suite* data_set_suite ()
 {
     TCase* t = tcase_create ("DataSet");
     tcase_add_test (t, ver0);
+    tcase_add_test (t, ver2);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("DataSet");
@@ -20,6 +20,8 @@ extern Suite* trx_handle_suite();
 extern Suite* service_thd_suite();
 extern Suite* ist_suite();
 extern Suite* saved_state_suite();
+extern Suite* certification_suite();
+extern Suite* monitor_suite();
 
 static suite_creator_t suites[] =
 {
@@ -31,6 +33,8 @@ static suite_creator_t suites[] =
     service_thd_suite,
     ist_suite,
     saved_state_suite,
+    certification_suite,
+    monitor_suite,
     0
 };
 
@@ -73,11 +73,7 @@ public:
     void lock() { }
     void unlock() { }
     wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
-    bool condition(wsrep_seqno_t last_entered,
-                   wsrep_seqno_t last_left) const
-    {
-        return (last_left >= trx_.depends_seqno());
-    }
+    wsrep_seqno_t depends_seqno() const { return trx_.depends_seqno(); }
 #ifdef GU_DBUG_ON
     void debug_sync(gu::Mutex&) { }
 #endif // GU_DBUG_ON
@@ -10,9 +10,12 @@
 
 #include "gu_logger.hpp"
 #include "gu_hexdump.hpp"
+#include "gu_time.h"
 
 #include <check.h>
 
+#include <sstream>
+
 using namespace galera;
 
 class TestBaseName : public gu::Allocator::BaseName
@@ -237,10 +240,64 @@ START_TEST (ver0)
 }
 END_TEST
 
+/* Key append microbenchmark: appends a lot of keys to a single key set, like
+ * a bulk UPDATE/DELETE would. Run with 'nofork' to see the numbers in the
+ * log. */
+START_TEST (key_set_bench)
+{
+    KeySet::Version const tk_ver(KeySet::FLAT16A);
+    int const n_keys(1 << 17);
+
+    std::vector<std::string> leafs(n_keys);
+    for (int i(0); i < n_keys; ++i)
+    {
+        std::ostringstream os;
+        os << i;
+        leafs[i] = os.str();
+    }
+
+    gu::byte_t reserved[1024];
+    TestBaseName const str("key_set_bench");
+    KeySetOut kso (reserved, sizeof(reserved), str, tk_ver);
+
+    double const begin(gu_time_monotonic());
+
+    for (int i(0); i < n_keys; ++i)
+    {
+        TestKey tk(tk_ver, EXCLUSIVE, true, "db", "table", leafs[i].c_str());
+        kso.append(tk());
+    }
+
+    double const duration((gu_time_monotonic() - begin) * 1.0e-9);
+
+    /* branch parts are stored only once */
+    fail_if (kso.count() != n_keys + 2, "key count: expected %d, got %d",
+             n_keys + 2, kso.count());
+
+    size_t const size(kso.size());
+
+    /* now every key must be detected as a duplicate */
+    for (int i(n_keys - 1); i >= 0; --i)
+    {
+        TestKey tk(tk_ver, EXCLUSIVE, true, "db", "table", leafs[i].c_str());
+        kso.append(tk());
+    }
+
+    fail_if (kso.count() != n_keys + 2, "key count: expected %d, got %d",
+             n_keys + 2, kso.count());
+    fail_if (kso.size() != size, "Size: %zu, expected: %zu",
+             kso.size(), size);
+
+    log_info << "key set bench: keys: " << n_keys
+             << ", keys/sec: " << (n_keys / duration);
+}
+END_TEST
+
 Suite* key_set_suite ()
 {
     TCase* t = tcase_create ("KeySet");
     tcase_add_test (t, ver0);
+    tcase_add_test (t, key_set_bench);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("KeySet");
@@ -0,0 +1,639 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+#include "../src/monitor.hpp"
+#include "../src/replicator_smm.hpp" // for CommitOrder
+
+#include "gu_atomic.hpp"
+
+#include <check.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    /* Order with explicit dependency: object may enter once the monitor
+     * has left depends seqno */
+    class TestOrder
+    {
+    public:
+
+        TestOrder(wsrep_seqno_t const seqno, wsrep_seqno_t const depends)
+            :
+            seqno_  (seqno),
+            depends_(depends)
+        {}
+
+        void lock()   {}
+        void unlock() {}
+
+        wsrep_seqno_t seqno() const { return seqno_; }
+
+        wsrep_seqno_t depends_seqno() const { return depends_; }
+
+#ifdef GU_DBUG_ON
+        void debug_sync(gu::Mutex&) {}
+#endif // GU_DBUG_ON
+
+    private:
+
+        wsrep_seqno_t const seqno_;
+        wsrep_seqno_t const depends_;
+    };
+
+    typedef galera::Monitor<TestOrder> TestMonitor;
+
+    struct Ctx
+    {
+        Ctx(TestMonitor& mon, wsrep_seqno_t const total, int const dist,
+            int const cancel)
+            :
+            mon_    (mon),
+            next_   (0),
+            total_  (total),
+            dist_   (dist),
+            cancel_ (cancel),
+            inside_ (0),
+            errors_ (0)
+        {}
+
+        TestMonitor&              mon_;
+        gu::Atomic<wsrep_seqno_t> next_;
+        wsrep_seqno_t const       total_;
+        int const                 dist_;   // max dependency distance
+        int const                 cancel_; // self-cancel every cancel_ seqno
+        gu::Atomic<long>          inside_; // objects in critical section
+        gu::Atomic<long>          errors_;
+
+    private:
+
+        Ctx(const Ctx&);
+        void operator=(const Ctx&);
+    };
+
+    extern "C" void* monitor_user(void* arg)
+    {
+        Ctx& ctx(*static_cast<Ctx*>(arg));
+
+        for (wsrep_seqno_t s(ctx.next_.add_and_fetch(1)); s <= ctx.total_;
+             s = ctx.next_.add_and_fetch(1))
+        {
+            /* dependency distance varies between 1 and dist_ */
+            TestOrder to(s, s - 1 - (s * 7919) % ctx.dist_);
+
+            if (ctx.cancel_ > 0 && 0 == s % ctx.cancel_)
+            {
+                ctx.mon_.self_cancel(to);
+                continue;
+            }
+
+            ctx.mon_.enter(to);
+
+            long const inside(ctx.inside_.add_and_fetch(1));
+
+            if (ctx.mon_.last_left() < s - 1 - (s * 7919) % ctx.dist_ ||
+                (1 == ctx.dist_ && inside != 1))
+            {
+                ++ctx.errors_;
+            }
+
+            --ctx.inside_;
+
+            ctx.mon_.leave(to);
+        }
+
+        return 0;
+    }
+
+    void run_monitor_with(Ctx& ctx, int const threads,
+                          void* (*user)(void*))
+    {
+        std::vector<pthread_t> thds(threads);
+
+        for (int t(0); t < threads; ++t)
+        {
+            pthread_create(&thds[t], NULL, user, &ctx);
+        }
+
+        for (int t(0); t < threads; ++t)
+        {
+            pthread_join(thds[t], NULL);
+        }
+    }
+
+    void run_monitor(Ctx& ctx, int const threads)
+    {
+        run_monitor_with(ctx, threads, monitor_user);
+    }
+}
+
+START_TEST(monitor_serial)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    Ctx ctx(mon, 100000, 1, 0);
+    run_monitor(ctx, 8);
+
+    fail_if(ctx.errors_() != 0, "%ld errors", ctx.errors_());
+    fail_if(mon.last_left() != ctx.total_,
+            "last left %lld, expected %lld",
+            (long long)mon.last_left(), (long long)ctx.total_);
+}
+END_TEST
+
+START_TEST(monitor_parallel)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    Ctx ctx(mon, 200000, 16, 11);
+    run_monitor(ctx, 16);
+
+    fail_if(ctx.errors_() != 0, "%ld errors", ctx.errors_());
+    fail_if(mon.last_left() != ctx.total_,
+            "last left %lld, expected %lld",
+            (long long)mon.last_left(), (long long)ctx.total_);
+
+    double oooe, oool, win;
+    mon.get_stats(&oooe, &oool, &win);
+    fail_if(oooe < 0 || oooe > 1);
+    fail_if(oool < 0 || oool > 1);
+}
+END_TEST
+
+START_TEST(monitor_small_window)
+{
+    /* threads run ahead into a full window, slot ring is resized
+     * concurrently with lock-free enters and leaves */
+    TestMonitor mon(256);
+    mon.set_initial_position(0);
+
+    Ctx ctx(mon, 200000, 64, 7);
+    run_monitor(ctx, 32);
+
+    fail_if(ctx.errors_() != 0, "%ld errors", ctx.errors_());
+    fail_if(mon.last_left() != ctx.total_);
+    fail_if(mon.capacity() > mon.size(), "capacity %zd > max window %zd",
+            mon.capacity(), mon.size());
+}
+END_TEST
+
+START_TEST(monitor_resize)
+{
+    TestMonitor mon(1 << 12);
+    mon.set_initial_position(0);
+
+    fail_if(mon.capacity() != TestMonitor::MIN_SIZE);
+    fail_if(!mon.would_block(mon.size()));
+    fail_if(mon.would_block(mon.size() - 1));
+
+    wsrep_seqno_t const top(3000);
+
+    /* hold the window open at seqno 1 */
+    for (wsrep_seqno_t s(2); s <= top; ++s)
+    {
+        TestOrder to(s, -1);
+        mon.enter(to);
+        mon.leave(to);
+    }
+
+    fail_if(mon.last_left() != 0);
+    fail_if(mon.capacity() < top, "capacity %zd", mon.capacity());
+
+    TestOrder to1(1, 0);
+    mon.enter(to1);
+    mon.leave(to1);
+
+    fail_if(mon.last_left() != top);
+
+    /* in order traffic shrinks the ring back */
+    for (wsrep_seqno_t s(top + 1); s <= 20 * top; ++s)
+    {
+        TestOrder to(s, s - 1);
+        mon.enter(to);
+        mon.leave(to);
+    }
+
+    fail_if(mon.capacity() != TestMonitor::MIN_SIZE,
+            "capacity %zd", mon.capacity());
+
+    mon.set_size(TestMonitor::MIN_SIZE);
+    fail_if(!mon.would_block(mon.last_left() + TestMonitor::MIN_SIZE));
+
+    try
+    {
+        mon.set_size(1000);
+        fail("non-power of 2 window size accepted");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_if(e.get_errno() != EINVAL);
+    }
+}
+END_TEST
+
+namespace
+{
+    struct Drainer
+    {
+        Drainer(Ctx& ctx) : ctx_(ctx), drained_(0), errors_(0) {}
+
+        Ctx&          ctx_;
+        long          drained_;
+        long          errors_;
+
+    private:
+
+        Drainer(const Drainer&);
+        void operator=(const Drainer&);
+    };
+
+    extern "C" void* monitor_drainer(void* arg)
+    {
+        Drainer& d(*static_cast<Drainer*>(arg));
+
+        for (wsrep_seqno_t s(d.ctx_.next_()); s < d.ctx_.total_;
+             s = d.ctx_.next_() + 100)
+        {
+            d.ctx_.mon_.drain(s);
+            if (d.ctx_.mon_.last_left() < s) ++d.errors_;
+            ++d.drained_;
+        }
+
+        return 0;
+    }
+}
+
+START_TEST(monitor_drain)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    Ctx ctx(mon, 100000, 8, 13);
+    Drainer d(ctx);
+
+    pthread_t drainer;
+    pthread_create(&drainer, NULL, monitor_drainer, &d);
+
+    run_monitor(ctx, 8);
+
+    pthread_join(drainer, NULL);
+
+    fail_if(ctx.errors_() != 0, "%ld errors", ctx.errors_());
+    fail_if(d.errors_ != 0, "%ld drain errors", d.errors_);
+    fail_if(mon.last_left() != ctx.total_);
+}
+END_TEST
+
+namespace
+{
+    /* Each user takes a chunk of dist_ consecutive seqnos, so that a seqno
+     * entered after a chunk switch lands far ahead of the last entered one */
+    extern "C" void* monitor_chunk_user(void* arg)
+    {
+        Ctx& ctx(*static_cast<Ctx*>(arg));
+
+        for (wsrep_seqno_t c(ctx.next_.fetch_and_add(ctx.dist_));
+             c < ctx.total_; c = ctx.next_.fetch_and_add(ctx.dist_))
+        {
+            wsrep_seqno_t const end(std::min(c + ctx.dist_, ctx.total_));
+
+            for (wsrep_seqno_t s(c + 1); s <= end; ++s)
+            {
+                TestOrder to(s, -1);
+
+                ctx.mon_.enter(to);
+                ctx.mon_.leave(to);
+            }
+        }
+
+        return 0;
+    }
+
+    struct Shrinker
+    {
+        Shrinker(TestMonitor& mon) : mon_(mon), done_(0) {}
+
+        TestMonitor&     mon_;
+        gu::Atomic<int>  done_;
+
+    private:
+
+        Shrinker(const Shrinker&);
+        void operator=(const Shrinker&);
+    };
+
+    extern "C" void* monitor_shrinker(void* arg)
+    {
+        Shrinker& sh(*static_cast<Shrinker*>(arg));
+
+        while (0 == sh.done_())
+        {
+            sh.mon_.set_size(TestMonitor::MIN_SIZE);
+            sh.mon_.set_size(1 << 12);
+
+            sched_yield();
+        }
+
+        return 0;
+    }
+}
+
+START_TEST(monitor_shrink_concurrent)
+{
+    /* ring is shrunk both by the leaving threads and by set_size() while
+     * lock-free enters keep occupying slots far ahead of last entered */
+    TestMonitor mon(1 << 12);
+    mon.set_initial_position(0);
+
+    Ctx      ctx(mon, 1 << 20, 64, 0);
+    Shrinker sh(mon);
+
+    pthread_t shrinker;
+    pthread_create(&shrinker, NULL, monitor_shrinker, &sh);
+
+    run_monitor_with(ctx, 16, monitor_chunk_user);
+
+    sh.done_ = 1;
+    pthread_join(shrinker, NULL);
+
+    fail_if(mon.last_left() != ctx.total_,
+            "last left %lld, expected %lld",
+            (long long)mon.last_left(), (long long)ctx.total_);
+    fail_if(mon.capacity() > mon.size(), "capacity %zd > max window %zd",
+            mon.capacity(), mon.size());
+}
+END_TEST
+
+namespace
+{
+    /* Enters and leaves seqnos one by one without dependencies, so that all
+     * leaves take the lock-free path. Time spent inside varies, so that
+     * the leave lands at different points of a concurrent drain() */
+    extern "C" void* monitor_seq_user(void* arg)
+    {
+        Ctx& ctx(*static_cast<Ctx*>(arg));
+
+        for (wsrep_seqno_t s(ctx.next_.add_and_fetch(1)); s <= ctx.total_;
+             s = ctx.next_.add_and_fetch(1))
+        {
+            TestOrder to(s, -1);
+
+            ctx.mon_.enter(to);
+
+            for (volatile int i((s * 7919) % 256); i > 0; --i) {}
+
+            ctx.mon_.leave(to);
+        }
+
+        return 0;
+    }
+
+    struct FastDrainer
+    {
+        FastDrainer(Ctx& ctx) : ctx_(ctx), errors_(0) {}
+
+        Ctx&  ctx_;
+        long  errors_;
+
+    private:
+
+        FastDrainer(const FastDrainer&);
+        void operator=(const FastDrainer&);
+    };
+
+    /* drains up to the seqno being applied, so that its leave races with
+     * the drainer registering to wait for it */
+    extern "C" void* monitor_fast_drainer(void* arg)
+    {
+        FastDrainer& d(*static_cast<FastDrainer*>(arg));
+
+        for (wsrep_seqno_t s(0); s < d.ctx_.total_;)
+        {
+            s = std::min(d.ctx_.next_(), d.ctx_.total_);
+
+            d.ctx_.mon_.drain(s);
+            if (d.ctx_.mon_.last_left() < s) ++d.errors_;
+        }
+
+        return 0;
+    }
+}
+
+START_TEST(monitor_drain_fast_leave)
+{
+    /* a lock-free leave must never miss the drainer waiting for it, nor
+     * the next enter blocked by drain seqno, otherwise the test hangs */
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    Ctx         ctx(mon, 1 << 19, 1, 0);
+    FastDrainer d(ctx);
+
+    pthread_t drainer;
+    pthread_create(&drainer, NULL, monitor_fast_drainer, &d);
+
+    run_monitor_with(ctx, 1, monitor_seq_user);
+
+    pthread_join(drainer, NULL);
+
+    fail_if(d.errors_ != 0, "%ld drain errors", d.errors_);
+    fail_if(mon.last_left() != ctx.total_,
+            "last left %lld, expected %lld",
+            (long long)mon.last_left(), (long long)ctx.total_);
+}
+END_TEST
+
+namespace
+{
+    struct Interruptee
+    {
+        Interruptee(TestMonitor& mon) : mon_(mon), ret_(0) {}
+
+        TestMonitor& mon_;
+        int          ret_;
+
+    private:
+
+        Interruptee(const Interruptee&);
+        void operator=(const Interruptee&);
+    };
+
+    extern "C" void* monitor_interruptee(void* arg)
+    {
+        Interruptee& i(*static_cast<Interruptee*>(arg));
+        TestOrder    to(2, 1);
+
+        try
+        {
+            i.mon_.enter(to);
+            i.mon_.leave(to);
+        }
+        catch (gu::Exception& e)
+        {
+            i.ret_ = e.get_errno();
+            i.mon_.self_cancel(to);
+        }
+
+        return 0;
+    }
+}
+
+START_TEST(monitor_interrupt)
+{
+    TestMonitor mon;
+    mon.set_initial_position(0);
+
+    /* interrupt before enter */
+    TestOrder to3(3, 2);
+    mon.interrupt(to3);
+
+    Interruptee i(mon);
+    pthread_t   thd;
+    pthread_create(&thd, NULL, monitor_interruptee, &i);
+
+    /* let it block waiting for seqno 1 */
+    usleep(10000);
+
+    TestOrder to2(2, 1);
+    mon.interrupt(to2);
+
+    pthread_join(thd, NULL);
+
+    fail_if(i.ret_ != EINTR, "expected EINTR, got %d", i.ret_);
+
+    try
+    {
+        mon.enter(to3);
+        fail("interrupted enter succeeded");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_if(e.get_errno() != EINTR);
+        mon.self_cancel(to3);
+    }
+
+    fail_if(mon.last_left() != 0);
+
+    TestOrder to1(1, 0);
+    mon.enter(to1);
+    mon.leave(to1);
+
+    fail_if(mon.last_left() != 3, "last left %lld, expected 3",
+            (long long)mon.last_left());
+}
+END_TEST
+
+namespace
+{
+    typedef galera::ReplicatorSMM::CommitOrder CommitOrder;
+    typedef galera::Monitor<CommitOrder>       CommitMonitor;
+
+    struct Committer
+    {
+        Committer(CommitMonitor& mon, galera::TrxHandle* trx)
+            : mon_(mon), trx_(trx), entered_(0) {}
+
+        CommitMonitor&     mon_;
+        galera::TrxHandle* trx_;
+        gu::Atomic<int>    entered_;
+
+    private:
+
+        Committer(const Committer&);
+        void operator=(const Committer&);
+    };
+
+    extern "C" void* monitor_committer(void* arg)
+    {
+        Committer&  c(*static_cast<Committer*>(arg));
+        CommitOrder co(*c.trx_, CommitOrder::LOCAL_OOOC);
+
+        c.mon_.enter(co);
+        c.entered_ = 1;
+        c.mon_.leave(co);
+
+        return 0;
+    }
+}
+
+START_TEST(monitor_local_oooc)
+{
+    /* in LOCAL_OOOC mode local trxs commit out of order, while remote
+     * ones still wait for all preceding seqnos to commit */
+    galera::TrxHandle::LocalPool lp(galera::TrxHandle::LOCAL_STORAGE_SIZE, 4,
+                                    "monitor_local_oooc_lp");
+    galera::TrxHandle::SlavePool sp(sizeof(galera::TrxHandle), 4,
+                                    "monitor_local_oooc_sp");
+    wsrep_uuid_t const uuid = {{1, }};
+
+    galera::TrxHandle* const remote1(galera::TrxHandle::New(sp));
+    galera::TrxHandle* const local2 (galera::TrxHandle::New(
+                                         lp, galera::TrxHandle::Defaults,
+                                         uuid, -1, 1));
+    galera::TrxHandle* const remote3(galera::TrxHandle::New(sp));
+
+    remote1->set_received(NULL, 1, 1);
+    local2->set_received (NULL, 2, 2);
+    remote3->set_received(NULL, 3, 3);
+
+    CommitMonitor mon;
+    mon.set_initial_position(0);
+
+    /* local trx does not wait for seqno 1 */
+    CommitOrder co2(*local2, CommitOrder::LOCAL_OOOC);
+    mon.enter(co2);
+    mon.leave(co2);
+
+    fail_if(mon.last_left() != 0);
+
+    /* remote trx waits for seqno 1 even though seqno 2 has left */
+    Committer c(mon, remote3);
+    pthread_t thd;
+    pthread_create(&thd, NULL, monitor_committer, &c);
+
+    usleep(10000);
+    fail_if(c.entered_() != 0, "remote trx committed out of order");
+
+    CommitOrder co1(*remote1, CommitOrder::LOCAL_OOOC);
+    mon.enter(co1);
+    mon.leave(co1);
+
+    pthread_join(thd, NULL);
+
+    fail_if(c.entered_() != 1);
+    fail_if(mon.last_left() != 3, "last left %lld, expected 3",
+            (long long)mon.last_left());
+
+    remote1->unref();
+    local2->unref();
+    remote3->unref();
+}
+END_TEST
+
+Suite* monitor_suite()
+{
+    Suite* s = suite_create ("monitor");
+    TCase* tc;
+
+    tc = tcase_create ("monitor");
+    tcase_add_test  (tc, monitor_serial);
+    tcase_add_test  (tc, monitor_parallel);
+    tcase_add_test  (tc, monitor_small_window);
+    tcase_add_test  (tc, monitor_resize);
+    tcase_add_test  (tc, monitor_drain);
+    tcase_add_test  (tc, monitor_shrink_concurrent);
+    tcase_add_test  (tc, monitor_drain_fast_leave);
+    tcase_add_test  (tc, monitor_interrupt);
+    tcase_add_test  (tc, monitor_local_oooc);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase (s, tc);
+
+    return s;
+}
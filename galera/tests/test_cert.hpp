@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+/* Certification test environment and workload shared by
+ * certification_check.cpp and certification_bench.cpp */
+
+#ifndef _TEST_CERT_HPP_
+#define _TEST_CERT_HPP_
+
+#include "../src/certification.hpp"
+#include "../src/replicator_smm.hpp"
+
+#include "test_key.hpp"
+
+#include "gu_uuid.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <list>
+#include <set>
+
+using namespace galera;
+
+class TestEnv
+{
+    class GCache_setup
+    {
+    public:
+        GCache_setup(gu::Config& conf) : name_("certification_check.gcache")
+        {
+            conf.set("gcache.name", name_);
+            conf.set("gcache.size", "1M");
+        }
+
+        ~GCache_setup()
+        {
+            unlink(name_.c_str());
+        }
+    private:
+        std::string const name_;
+    };
+
+public:
+
+    TestEnv(int const shards) :
+        conf_   (),
+        init_   (conf_, NULL, NULL),
+        gcache_setup_(conf_),
+        gcache_ (conf_, "."),
+        gcs_    (conf_, gcache_),
+        thd_    (gcs_, gcache_),
+        pool_   (sizeof(TrxHandle), 16, "certification_check")
+    {
+        std::ostringstream os; os << shards;
+        conf_.set(Certification::PARAM_INDEX_SHARDS, os.str());
+    }
+
+    gu::Config&            conf()  { return conf_;  }
+    ServiceThd&            thd()   { return thd_;   }
+    TrxHandle::SlavePool&  pool()  { return pool_;  }
+
+private:
+
+    gu::Config           conf_;
+    ReplicatorSMM::InitConfig init_;
+    GCache_setup         gcache_setup_;
+    gcache::GCache       gcache_;
+    DummyGcs             gcs_;
+    ServiceThd           thd_;
+    TrxHandle::SlavePool pool_;
+};
+
+/* Serialized v3 write set that can be turned into a slave TrxHandle */
+class TestWriteSet
+{
+public:
+
+    TestWriteSet(const wsrep_uuid_t& source,
+                 wsrep_trx_id_t      trx_id,
+                 wsrep_seqno_t       last_seen,
+                 wsrep_seqno_t       seqno,
+                 const std::vector<std::pair<std::string, bool> >& keys)
+        :
+        buf_  (),
+        seqno_(seqno)
+    {
+        WriteSetOut wso(".", trx_id, KeySet::FLAT8A, 0, 0,
+                        WriteSetNG::F_COMMIT, WriteSetNG::VER3);
+
+        for (size_t i(0); i < keys.size(); ++i)
+        {
+            TestKey tk(KeySet::MAX_VERSION, keys[i].second, true,
+                       "test", keys[i].first.c_str());
+            wso.append_key(tk());
+        }
+
+        WriteSetNG::GatherVector out;
+        size_t const out_size(wso.gather(source, 1, trx_id, out));
+        wso.set_last_seen(last_seen);
+
+        buf_.reserve(out_size);
+        for (size_t i(0); i < out->size(); ++i)
+        {
+            const gu::byte_t* ptr(static_cast<const gu::byte_t*>
+                                  (out[i].ptr));
+            buf_.insert (buf_.end(), ptr, ptr + out[i].size);
+        }
+    }
+
+    /* Certification modifies the buffer, so trx gets its own copy
+     * which must outlive it. */
+    TrxHandle* trx(TrxHandle::SlavePool& pool,
+                   std::vector<gu::byte_t>& buf) const
+    {
+        buf = buf_;
+
+        TrxHandle* const ret(TrxHandle::New(pool));
+        ret->unserialize(&buf[0], buf.size(), 0);
+        ret->set_received(&buf[0], seqno_, seqno_);
+        return ret;
+    }
+
+private:
+
+    std::vector<gu::byte_t> buf_;
+    wsrep_seqno_t           seqno_;
+};
+
+typedef std::vector<std::pair<std::string, bool> > Keys;
+typedef std::list<std::vector<gu::byte_t> >        Bufs;
+
+/* Generates a random workload with a lot of conflicts */
+inline void make_workload(std::vector<TestWriteSet*>& wss,
+                   int const n_trx, int const n_keys, int const key_space)
+{
+    wsrep_uuid_t sources[3];
+    for (size_t i(0); i < sizeof(sources)/sizeof(sources[0]); ++i)
+    {
+        gu_uuid_generate(reinterpret_cast<gu_uuid_t*>(&sources[i]),
+                         NULL, 0);
+    }
+
+    unsigned int seed(n_trx);
+
+    for (int seqno(1); seqno <= n_trx; ++seqno)
+    {
+        Keys keys;
+        std::set<int> unique; // same key with different prefixes in one
+                              // write set is not a concern here
+        while (keys.size() < size_t(n_keys))
+        {
+            int const key(rand_r(&seed) % key_space);
+            if (unique.insert(key).second == false) continue;
+
+            std::ostringstream os;
+            os << key;
+            keys.push_back(Keys::value_type(os.str(),
+                                            rand_r(&seed) % 4 == 0 ?
+                                            SHARED : EXCLUSIVE));
+        }
+
+        wsrep_seqno_t const last_seen
+            (std::max<wsrep_seqno_t>(0, seqno - 1 - rand_r(&seed) % 8));
+
+        wss.push_back(new TestWriteSet(sources[rand_r(&seed) % 3],
+                                       seqno, last_seen, seqno, keys));
+    }
+}
+
+#endif /* _TEST_CERT_HPP_ */
@@ -340,11 +340,78 @@ START_TEST (ver3_annotation)
 }
 END_TEST
 
+/* many writesets checksummed in background at once, more than there are
+ * threads in the pool */
+START_TEST (ver3_check_pool)
+{
+    wsrep_uuid_t source;
+    gu_uuid_generate (reinterpret_cast<gu_uuid_t*>(&source), NULL, 0);
+
+    std::string const dir(".");
+    size_t const n_ws(64);
+    size_t const corrupt(n_ws / 2);
+
+    std::vector<std::vector<gu::byte_t> > in(n_ws);
+
+    for (size_t i(0); i < n_ws; ++i)
+    {
+        DataSet::Version const dver(i % 2 ? DataSet::VER1 : DataSet::VER2);
+        WriteSetOut wso (dir, i, KeySet::FLAT8A, 0, 0, 0, WriteSetNG::VER3,
+                         dver, dver);
+
+        TestKey tk(KeySet::MAX_VERSION, EXCLUSIVE, true, "a0");
+        wso.append_key(tk());
+
+        std::vector<gu::byte_t> const data(1 << 16, gu::byte_t(i));
+        wso.append_data (data.data(), data.size(), true);
+
+        WriteSetNG::GatherVector out;
+        size_t const out_size(wso.gather(source, 1, i, out));
+        wso.set_last_seen(1);
+
+        in[i].reserve(out_size);
+        for (size_t j(0); j < out->size(); ++j)
+        {
+            const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[j].ptr));
+            in[i].insert (in[i].end(), ptr, ptr + out[j].size);
+        }
+    }
+
+    in[corrupt][in[corrupt].size() - 1] ^= 1;
+
+    std::vector<WriteSetIn*> wsi(n_ws);
+
+    for (size_t i(0); i < n_ws; ++i)
+    {
+        gu::Buf const in_buf = { in[i].data(),
+                                 static_cast<ssize_t>(in[i].size()) };
+        wsi[i] = new WriteSetIn(in_buf, 2);
+    }
+
+    for (size_t i(0); i < n_ws; ++i)
+    {
+        try
+        {
+            wsi[i]->verify_checksum();
+            fail_if (corrupt == i, "payload corruption slipped through");
+        }
+        catch (gu::Exception& e)
+        {
+            fail_if (corrupt != i, "ws %zu: %s", i, e.what());
+            fail_if (e.get_errno() != EINVAL);
+        }
+
+        delete wsi[i];
+    }
+}
+END_TEST
+
 Suite* write_set_ng_suite ()
 {
     TCase* t = tcase_create ("WriteSet");
     tcase_add_test (t, ver3_basic);
     tcase_add_test (t, ver3_annotation);
+    tcase_add_test (t, ver3_check_pool);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("WriteSet");
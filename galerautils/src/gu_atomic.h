@@ -58,6 +58,12 @@ extern "C" {
 #define gu_atomic_get(ptr, vptr)                        \
     __atomic_load(ptr, vptr, GU_ATOMIC_SYNC_DEFAULT)
 
+// if contents of ptr equal contents of eptr, stores val into ptr and returns
+// true, otherwise stores contents of ptr into eptr and returns false
+#define gu_atomic_compare_and_swap(ptr, eptr, val)                      \
+    __atomic_compare_exchange_n(ptr, eptr, val, false,                  \
+                                GU_ATOMIC_SYNC_DEFAULT, GU_ATOMIC_SYNC_DEFAULT)
+
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8) // use __sync_XXX builtins
 
 #define GU_ATOMIC_SYNC_NONE    0
@@ -83,6 +89,10 @@ extern "C" {
 
 #define gu_atomic_get(ptr, vptr) *vptr = __sync_fetch_and_or(ptr, 0)
 
+#define gu_atomic_compare_and_swap(ptr, eptr, val)                      \
+    (__sync_bool_compare_and_swap(ptr, *(eptr), val) ||                 \
+     (*(eptr) = __sync_fetch_and_or(ptr, 0), false))
+
 #else
 #error "This GCC version does not support 8-byte atomics on this platform. Use GCC >= 4.7.x."
 #endif /* __ATOMIC_RELAXED */
@@ -54,6 +54,14 @@ namespace gu
             return gu_atomic_sub_and_fetch(&i_, i);
         }
 
+        /*! If the value equals expected, replaces it with desired and
+         *  returns true. Otherwise loads the value into expected and
+         *  returns false. */
+        bool compare_and_swap(I& expected, I desired)
+        {
+            return gu_atomic_compare_and_swap(&i_, &expected, desired);
+        }
+
         Atomic<I>& operator++()
         {
             gu_atomic_fetch_and_add(&i_, 1);
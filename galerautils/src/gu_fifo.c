@@ -14,6 +14,7 @@
  */
 
 #define _DEFAULT_SOURCE
+#define _GNU_SOURCE // for adaptive mutex
 
 #include <stdio.h>
 #include <string.h>
@@ -75,8 +76,9 @@ gu_fifo_t *gu_fifo_create (size_t length, size_t item_size)
 
     if (length > 0 && item_size > 0) {
         /* find the best ratio of width and height:
-         * the size of a row array must be equal to that of the row */
-        while (array_len * row_len < length) {
+         * the size of a row array must be equal to that of the row.
+         * One row is always kept free, see fifo_full() */
+        while ((array_len - 1) * row_len < length) {
             if (array_size < row_size) {
                 array_pwr++;
                 array_len = 1 << array_pwr;
@@ -134,7 +136,17 @@ gu_fifo_t *gu_fifo_create (size_t length, size_t item_size)
             ret->item_size   = item_size;
             ret->row_size    = row_size;
             ret->alloc       = alloc_size;
+#ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+            /* critical sections are short, spin a little before sleeping:
+             * with many getters most of them contend on the lock */
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init (&attr);
+            pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+            gu_mutex_init (&ret->lock, &attr);
+            pthread_mutexattr_destroy (&attr);
+#else
             gu_mutex_init (&ret->lock, NULL);
+#endif /* PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP */
             gu_cond_init  (&ret->get_cond, NULL);
             gu_cond_init  (&ret->put_cond, NULL);
         }
@@ -251,13 +263,20 @@ static inline int fifo_unlock_get (gu_fifo_t *q)
     return fifo_unlock(q);
 }
 
+/* Rows are freed when their last item is popped, so tail must never wrap
+ * around into the row of head: one row worth of items is kept free. */
+static inline bool fifo_full (const gu_fifo_t* q)
+{
+    return (q->used + q->col_mask + 1 >= q->length);
+}
+
 /* lock the queue and wait if it is full */
 static inline int fifo_lock_put (gu_fifo_t *q)
 {
     int ret = 0;
 
     fifo_lock(q);
-    while (0 == ret && q->used == q->length && !q->closed) {
+    while (0 == ret && fifo_full(q) && !q->closed) {
         q->put_wait++;
         ret = -gu_cond_wait (&q->put_cond, &q->lock);
     }
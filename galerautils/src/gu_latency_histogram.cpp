@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 Codership Oy <info@codership.com>
+ */
+
+#include "gu_latency_histogram.hpp"
+
+#include <sstream>
+
+gu::LatencyHistogram::LatencyHistogram()
+    :
+    max_(0)
+{
+    for (int i(0); i < BUCKETS; ++i) cnt_[i] = 0;
+}
+
+void gu::LatencyHistogram::clear()
+{
+    for (int i(0); i < BUCKETS; ++i) gu_atomic_fetch_and_and(&cnt_[i], 0);
+
+    gu_atomic_fetch_and_and(&max_, 0);
+}
+
+long long gu::LatencyHistogram::count() const
+{
+    long long ret(0);
+
+    for (int i(0); i < BUCKETS; ++i)
+    {
+        long long c;
+        gu_atomic_get(&cnt_[i], &c);
+        ret += c;
+    }
+
+    return ret;
+}
+
+long long gu::LatencyHistogram::max() const
+{
+    long long ret;
+    gu_atomic_get(&max_, &ret);
+    return ret;
+}
+
+long long gu::LatencyHistogram::bucket_value(int const i)
+{
+    if (i < SUB_NUM) return i;
+
+    int const       shift(i / SUB_NUM - 1);
+    long long const low((static_cast<long long>(SUB_NUM + i % SUB_NUM))
+                        << shift);
+
+    return low + ((1LL << shift) >> 1);
+}
+
+long long gu::LatencyHistogram::percentile(double const p) const
+{
+    long long snap[BUCKETS];
+    long long total(0);
+
+    for (int i(0); i < BUCKETS; ++i)
+    {
+        gu_atomic_get(&cnt_[i], &snap[i]);
+        total += snap[i];
+    }
+
+    if (0 == total) return 0;
+
+    long long target(static_cast<long long>(p * total + 0.5));
+    if (target < 1)     target = 1;
+    if (target > total) target = total;
+
+    long long cumulative(0);
+    int       i(0);
+
+    for (; i < BUCKETS - 1; ++i)
+    {
+        cumulative += snap[i];
+        if (cumulative >= target) break;
+    }
+
+    long long const max(this->max());
+    long long const ret(bucket_value(i));
+
+    return (max > 0 && ret > max) ? max : ret;
+}
+
+std::ostream& gu::operator<<(std::ostream& os, const LatencyHistogram& h)
+{
+    static double const ns(1.0e-9);
+
+    return (os << h.percentile(0.50)  * ns << '/'
+               << h.percentile(0.90)  * ns << '/'
+               << h.percentile(0.99)  * ns << '/'
+               << h.percentile(0.999) * ns << '/'
+               << h.max()             * ns << '/'
+               << h.count());
+}
+
+std::string gu::LatencyHistogram::to_string() const
+{
+    std::ostringstream os;
+    os << *this;
+    return os.str();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 Codership Oy <info@codership.com>
+ */
+
+#ifndef _gu_latency_histogram_hpp_
+#define _gu_latency_histogram_hpp_
+
+#include "gu_atomic.h"
+
+#include <ostream>
+#include <string>
+
+namespace gu
+{
+    /*!
+     * Lock-free histogram of durations in nanoseconds. Buckets are spaced
+     * logarithmically with 4 sub-buckets per power of two, so reported
+     * percentiles are within 12.5% of the real value. Insertion is an atomic
+     * increment of the bucket counter plus a compare-and-swap loop on the
+     * maximum, which only retries while a new maximum is being raced in.
+     * It is meant to be used on hot paths.
+     */
+    class LatencyHistogram
+    {
+    public:
+
+        LatencyHistogram();
+
+        void insert(long long ns)
+        {
+            if (ns < 0) ns = 0;
+
+            gu_atomic_fetch_and_add(&cnt_[bucket(ns)], 1);
+
+            long long max;
+            gu_atomic_get(&max_, &max);
+            while (ns > max &&
+                   !gu_atomic_compare_and_swap(&max_, &max, ns)) {}
+        }
+
+        /*! Concurrent insertions may be lost */
+        void clear();
+
+        long long count() const;
+
+        /*! @return approximate p-th percentile (0 < p <= 1) in nanoseconds,
+         *          0 if empty */
+        long long percentile(double p) const;
+
+        long long max() const;
+
+        std::string to_string() const;
+
+    private:
+
+        LatencyHistogram(const LatencyHistogram&);
+        void operator=(const LatencyHistogram&);
+
+        static int const SUB_BITS = 2;
+        static int const SUB_NUM  = 1 << SUB_BITS;
+        static int const BUCKETS  = (64 - SUB_BITS) * SUB_NUM;
+
+        static int bucket(long long ns)
+        {
+            if (ns < SUB_NUM) return static_cast<int>(ns);
+
+            int const msb(63 - __builtin_clzll(ns));
+            int const sub((ns >> (msb - SUB_BITS)) & (SUB_NUM - 1));
+
+            return (msb - SUB_BITS + 1) * SUB_NUM + sub;
+        }
+
+        /*! @return middle value of the bucket */
+        static long long bucket_value(int i);
+
+        mutable long long cnt_[BUCKETS];
+        mutable long long max_;
+    };
+
+    /*! Prints p50/p90/p99/p99.9/max in seconds and the number of samples */
+    std::ostream& operator<<(std::ostream&, const LatencyHistogram&);
+}
+
+#endif // _gu_latency_histogram_hpp_
@@ -0,0 +1,230 @@
+// Copyright (C) 2015 Codership Oy <info@codership.com>
+
+/**
+ * @file LZ4 block format compressor/decompressor implementation
+ *
+ * Block is a sequence of
+ *   token | [literal length bytes] | literals | offset | [match length bytes]
+ * where token holds literal length in high 4 bits and match length - 4 in
+ * low 4 bits. Value 15 means that more length bytes follow, each adding up to
+ * 255. Offset is 2 bytes little-endian. The last sequence has no match part
+ * and contains at least the last 5 bytes of input.
+ *
+ * $Id$
+ */
+
+#include "gu_lz4.h"
+
+#include "gu_macros.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LZ4_MINMATCH      4
+#define LZ4_LASTLITERALS  5  /* last bytes of input are always literals */
+#define LZ4_MFLIMIT       12 /* last match must start that far from the end */
+#define LZ4_MAX_OFFSET    65535
+#define LZ4_HASH_LOG      12
+#define LZ4_SKIP_TRIGGER  6  /* speeds up skipping of incompressible data */
+
+static GU_FORCE_INLINE uint32_t
+lz4_read32 (const uint8_t* const p)
+{
+    uint32_t ret;
+    memcpy (&ret, p, sizeof(ret));
+    return ret;
+}
+
+static GU_FORCE_INLINE uint32_t
+lz4_hash (uint32_t const seq)
+{
+    return (seq * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+/* writes continuation bytes of a length that did not fit in a token nibble */
+static GU_FORCE_INLINE uint8_t*
+lz4_write_len (uint8_t* op, size_t len)
+{
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* writes a sequence, returns NULL if it does not fit */
+static GU_FORCE_INLINE uint8_t*
+lz4_write_seq (uint8_t* op, uint8_t* const oend,
+               const uint8_t* const lit, size_t const lit_len,
+               size_t const offset, size_t const match_len)
+{
+    /* worst case space: token + length bytes + literals + offset */
+    if (gu_unlikely((size_t)(oend - op) <
+                    1 + lit_len/255 + 1 + lit_len + 2 + match_len/255 + 1))
+        return NULL;
+
+    uint8_t* const token = op++;
+
+    if (lit_len >= 15) {
+        *token = 15 << 4;
+        op = lz4_write_len (op, lit_len - 15);
+    }
+    else {
+        *token = (uint8_t)(lit_len << 4);
+    }
+
+    memcpy (op, lit, lit_len);
+    op += lit_len;
+
+    if (0 == offset) return op; /* last sequence */
+
+    *op++ = (uint8_t)(offset);
+    *op++ = (uint8_t)(offset >> 8);
+
+    if (match_len >= 15) {
+        *token |= 15;
+        op = lz4_write_len (op, match_len - 15);
+    }
+    else {
+        *token |= (uint8_t)match_len;
+    }
+
+    return op;
+}
+
+size_t
+gu_lz4_compress (const void* const src, size_t const src_len,
+                 void* const dst, size_t const dst_len)
+{
+    const uint8_t* const base   = (const uint8_t*)src;
+    const uint8_t* const iend   = base + src_len;
+    const uint8_t*       ip     = base;
+    const uint8_t*       anchor = base;
+    uint8_t*             op     = (uint8_t*)dst;
+    uint8_t* const       oend   = op + dst_len;
+
+    if (src_len > LZ4_MFLIMIT) {
+        const uint8_t* const mflimit    = iend - LZ4_MFLIMIT;
+        const uint8_t* const matchlimit = iend - LZ4_LASTLITERALS;
+        uint32_t table[1 << LZ4_HASH_LOG]; /* positions relative to base */
+        unsigned misses = 0;
+
+        memset (table, 0, sizeof(table));
+
+        while (ip < mflimit) {
+            uint32_t const seq = lz4_read32 (ip);
+            uint32_t const h   = lz4_hash (seq);
+            const uint8_t* ref = base + table[h];
+
+            table[h] = (uint32_t)(ip - base);
+
+            if (ref >= ip || ip - ref > LZ4_MAX_OFFSET ||
+                lz4_read32 (ref) != seq) {
+                ip += 1 + (misses++ >> LZ4_SKIP_TRIGGER);
+                continue;
+            }
+
+            misses = 0;
+
+            /* extend match backwards into pending literals */
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip; --ref;
+            }
+
+            const uint8_t* mp = ip  + LZ4_MINMATCH;
+            const uint8_t* rp = ref + LZ4_MINMATCH;
+
+            while (mp < matchlimit && *mp == *rp) { ++mp; ++rp; }
+
+            op = lz4_write_seq (op, oend, anchor, ip - anchor, ip - ref,
+                                mp - ip - LZ4_MINMATCH);
+            if (gu_unlikely(NULL == op)) return 0;
+
+            ip = anchor = mp;
+
+            /* improves ratio on repetitive data at little cost */
+            if (ip < mflimit) {
+                table[lz4_hash (lz4_read32 (ip - 2))] =
+                    (uint32_t)(ip - 2 - base);
+            }
+        }
+    }
+
+    op = lz4_write_seq (op, oend, anchor, iend - anchor, 0, 0);
+    if (gu_unlikely(NULL == op)) return 0;
+
+    return op - (uint8_t*)dst;
+}
+
+/* reads continuation bytes of a length, returns NULL on input overrun */
+static GU_FORCE_INLINE const uint8_t*
+lz4_read_len (const uint8_t* ip, const uint8_t* const iend, size_t* const len)
+{
+    unsigned b;
+
+    do {
+        if (gu_unlikely(ip >= iend)) return NULL;
+        b = *ip++;
+        *len += b;
+    }
+    while (255 == b);
+
+    return ip;
+}
+
+ssize_t
+gu_lz4_decompress (const void* const src, size_t const src_len,
+                   void* const dst, size_t const dst_len)
+{
+    const uint8_t*       ip   = (const uint8_t*)src;
+    const uint8_t* const iend = ip + src_len;
+    uint8_t*             op   = (uint8_t*)dst;
+    uint8_t* const       oend = op + dst_len;
+
+    while (ip < iend) {
+        unsigned const token = *ip++;
+        size_t         len   = token >> 4;
+
+        if (15 == len && NULL == (ip = lz4_read_len (ip, iend, &len)))
+            return -EINVAL;
+
+        if (gu_unlikely((size_t)(iend - ip) < len ||
+                        (size_t)(oend - op) < len)) return -EINVAL;
+
+        memcpy (op, ip, len);
+        op += len;
+        ip += len;
+
+        if (ip == iend) break; /* last sequence has no match part */
+
+        if (gu_unlikely(iend - ip < 2)) return -EINVAL;
+
+        size_t const offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (gu_unlikely(0 == offset || offset > (size_t)(op - (uint8_t*)dst)))
+            return -EINVAL;
+
+        len = token & 15;
+
+        if (15 == len && NULL == (ip = lz4_read_len (ip, iend, &len)))
+            return -EINVAL;
+
+        len += LZ4_MINMATCH;
+
+        if (gu_unlikely((size_t)(oend - op) < len)) return -EINVAL;
+
+        const uint8_t* ref = op - offset;
+
+        if (gu_likely(offset >= len)) {
+            memcpy (op, ref, len);
+            op += len;
+        }
+        else {
+            /* overlapping match, e.g. a run of repeated bytes */
+            uint8_t* const end = op + len;
+            while (op < end) *op++ = *ref++;
+        }
+    }
+
+    return op - (uint8_t*)dst;
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2015 Codership Oy <info@codership.com>
+
+/**
+ * @file LZ4 block format compressor/decompressor
+ *
+ * Straightforward implementation of the LZ4 block format as documented by
+ * its author Yann Collet: single pass greedy compressor with a small hash
+ * table and a bounds-checked decompressor. Output is compatible with the
+ * reference implementation.
+ *
+ * $Id$
+ */
+
+#ifndef _gu_lz4_h_
+#define _gu_lz4_h_
+
+#include <stddef.h>    // for size_t
+#include <sys/types.h> // for ssize_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! @return maximum size of compressed data for len bytes of input */
+static inline size_t
+gu_lz4_bound (size_t const len)
+{
+    return len + len/255 + 16;
+}
+
+/*!
+ * Compresses src_len bytes from src to dst.
+ *
+ * @return size of compressed data or 0 if it does not fit in dst_len bytes.
+ *         (use dst_len < src_len to skip incompressible data early)
+ */
+extern size_t
+gu_lz4_compress (const void* src, size_t src_len, void* dst, size_t dst_len);
+
+/*!
+ * Decompresses src_len bytes from src to dst.
+ *
+ * @return size of decompressed data or -EINVAL if src is malformed or
+ *         does not fit in dst_len bytes.
+ */
+extern ssize_t
+gu_lz4_decompress (const void* src, size_t src_len, void* dst, size_t dst_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _gu_lz4_h_ */
@@ -47,7 +47,11 @@ RecordSetOutBase::post_append (bool const          new_page,
                                const byte_t* const ptr,
                                ssize_t const       size)
 {
-    check_.append (ptr, size);
+    if (CHECK_CRC32C == check_type_)
+        crc_.append (ptr, size);
+    else
+        check_.append (ptr, size);
+
     post_alloc (new_page, ptr, size);
 }
 
@@ -61,6 +65,7 @@ check_size (RecordSet::CheckType const ct)
     case RecordSet::CHECK_MMH32:  return 4;
     case RecordSet::CHECK_MMH64:  return 8;
     case RecordSet::CHECK_MMH128: return 16;
+    case RecordSet::CHECK_CRC32C: return 4;
 #define MAX_CHECKSUM_SIZE                16
     }
 
@@ -179,8 +184,16 @@ RecordSetOutBase::write_header (byte_t* const buf, ssize_t const size)
     if (check_type_ != CHECK_NONE)
     {
         assert (csize <= size - off);
-        check_.append (buf + hdr_offset, off - hdr_offset); /* append header */
-        check_.gather (buf + off, csize);
+        if (CHECK_CRC32C == check_type_)
+        {
+            crc_.append (buf + hdr_offset, off - hdr_offset);
+            *(reinterpret_cast<uint32_t*>(buf + off)) = htog(crc_.get());
+        }
+        else
+        {
+            check_.append (buf + hdr_offset, off - hdr_offset);
+            check_.gather (buf + off, csize);
+        }
     }
 
     return hdr_offset;
@@ -242,6 +255,7 @@ RecordSetOutBase::RecordSetOutBase (byte_t*                 reserved,
 #endif
     alloc_      (base_name, reserved, reserved_size),
     check_      (),
+    crc_        (),
     bufs_       (),
     prev_stored_(true)
 {
@@ -286,6 +300,7 @@ ver1_check_type (const byte_t* buf, ssize_t const size)
     case RecordSet::CHECK_MMH32:  return RecordSet::CHECK_MMH32;
     case RecordSet::CHECK_MMH64:  return RecordSet::CHECK_MMH64;
     case RecordSet::CHECK_MMH128: return RecordSet::CHECK_MMH128;
+    case RecordSet::CHECK_CRC32C: return RecordSet::CHECK_CRC32C;
     }
 
     gu_throw_error (EPROTO) << "Unsupported RecordSet checksum type: " << ct;
@@ -376,14 +391,27 @@ RecordSetInBase::checksum() const
 
     if (cs > 0) /* checksum records */
     {
-        Hash check;
-
-        check.append (head_ + begin_, size_ - begin_); /* records */
-        check.append (head_, begin_ - cs);             /* header  */
-
         assert(cs <= MAX_CHECKSUM_SIZE);
         byte_t result[MAX_CHECKSUM_SIZE];
-        check.gather<sizeof(result)>(result);
+
+        if (CHECK_CRC32C == check_type_)
+        {
+            CRC32C check;
+
+            check.append (head_ + begin_, size_ - begin_); /* records */
+            check.append (head_, begin_ - cs);             /* header  */
+
+            *(reinterpret_cast<uint32_t*>(result)) = htog(check.get());
+        }
+        else
+        {
+            Hash check;
+
+            check.append (head_ + begin_, size_ - begin_); /* records */
+            check.append (head_, begin_ - cs);             /* header  */
+
+            check.gather<sizeof(result)>(result);
+        }
 
         const byte_t* const stored_checksum(head_ + begin_ - cs);
 
@@ -16,6 +16,7 @@
 #include "gu_vector.hpp"
 #include "gu_alloc.hpp"
 #include "gu_digest.hpp"
+#include "gu_crc.hpp"
 
 #ifdef GU_RSET_CHECK_SIZE
 #  include "gu_throw.hpp"
@@ -42,7 +43,8 @@ public:
         CHECK_NONE   = 0,
         CHECK_MMH32,
         CHECK_MMH64,
-        CHECK_MMH128
+        CHECK_MMH128,
+        CHECK_CRC32C  /* hardware accelerated where available */
     };
 
     /*! return total size of a RecordSet */
@@ -191,6 +193,7 @@ private:
 
     Allocator     alloc_;
     Hash          check_;
+    CRC32C        crc_;    /* used instead of check_ for CHECK_CRC32C */
     Vector<Buf, Allocator::INITIAL_VECTOR_SIZE> bufs_;
     bool          prev_stored_;
 
@@ -8,6 +8,7 @@
 
 #include "gu_uuid.h"
 #include "gu_assert.hpp"
+#include "gu_throw.hpp"
 #include "gu_buffer.hpp"
 #include <iostream>
 
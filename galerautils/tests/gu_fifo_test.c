@@ -205,6 +205,169 @@ START_TEST(gu_fifo_cancel_test)
 }
 END_TEST
 
+#define MT_THREADS 8
+#define MT_ITEMS   100000L
+
+struct mt_ctx
+{
+    gu_fifo_t* q;
+    long       sum;
+    long       count;
+};
+
+static void*
+mt_putter (void* arg)
+{
+    struct mt_ctx* ctx = arg;
+    long i;
+
+    for (i = 1; i <= MT_ITEMS; i++) {
+        long* item = gu_fifo_get_tail (ctx->q);
+        fail_if (NULL == item);
+        *item = i;
+        gu_fifo_push_tail (ctx->q);
+    }
+
+    return NULL;
+}
+
+static void*
+mt_getter (void* arg)
+{
+    struct mt_ctx* ctx = arg;
+    long* item;
+    int   err;
+
+    while ((item = gu_fifo_get_head (ctx->q, &err))) {
+        ctx->sum += *item;
+        ctx->count++;
+        gu_fifo_pop_head (ctx->q);
+    }
+
+    fail_if (-ENODATA != err, "get_head() returned %d", err);
+
+    return NULL;
+}
+
+START_TEST(gu_fifo_mt_test)
+{
+    /* short queue to make putters wait as well */
+    gu_fifo_t* q = gu_fifo_create (1024, sizeof(long));
+    fail_if (q == NULL);
+
+    pthread_t putters[MT_THREADS];
+    pthread_t getters[MT_THREADS];
+    struct mt_ctx pctx[MT_THREADS];
+    struct mt_ctx gctx[MT_THREADS];
+    long i, sum = 0, count = 0;
+
+    for (i = 0; i < MT_THREADS; i++) {
+        gctx[i].q = q; gctx[i].sum = 0; gctx[i].count = 0;
+        pthread_create (&getters[i], NULL, mt_getter, &gctx[i]);
+    }
+
+    for (i = 0; i < MT_THREADS; i++) {
+        pctx[i].q = q;
+        pthread_create (&putters[i], NULL, mt_putter, &pctx[i]);
+    }
+
+    for (i = 0; i < MT_THREADS; i++) pthread_join (putters[i], NULL);
+
+    /* let getters drain the queue before closing it */
+    while (gu_fifo_length (q) > 0) usleep (1000);
+    gu_fifo_close (q);
+
+    for (i = 0; i < MT_THREADS; i++) {
+        pthread_join (getters[i], NULL);
+        sum   += gctx[i].sum;
+        count += gctx[i].count;
+    }
+
+    fail_if (count != MT_THREADS * MT_ITEMS, "got %ld items", count);
+    fail_if (sum != MT_THREADS * MT_ITEMS * (MT_ITEMS + 1) / 2,
+             "sum of items %ld", sum);
+
+    int q_len, q_len_max, q_len_min;
+    double q_len_avg;
+    gu_fifo_stats_get (q, &q_len, &q_len_max, &q_len_min, &q_len_avg);
+    fail_if (0 != q_len);
+    fail_if (q_len_max > 1024);
+    fail_if (q_len_avg < 0.0);
+
+    gu_fifo_destroy (q);
+}
+END_TEST
+
+/* Like gcs recv_q: one thread puts, many getters take items off the queue.
+ * Reports throughput for different numbers of getters. */
+#define BENCH_ITEMS 200000L
+
+static void*
+bench_getter (void* arg)
+{
+    struct mt_ctx* ctx = arg;
+    long* item;
+    int   err;
+
+    while ((item = gu_fifo_get_head (ctx->q, &err))) {
+        ctx->count++;
+        gu_fifo_pop_head (ctx->q);
+    }
+
+    return NULL;
+}
+
+START_TEST(gu_fifo_bench)
+{
+    static int const getters_num[] = { 1, 8, 64 };
+    size_t g;
+
+    for (g = 0; g < sizeof(getters_num)/sizeof(getters_num[0]); g++) {
+        int const      n = getters_num[g];
+        gu_fifo_t*     q = gu_fifo_create (1 << 16, sizeof(long));
+        pthread_t      getters[64];
+        struct mt_ctx  gctx[64];
+        long           i, count = 0;
+        long long      start;
+        double         secs;
+
+        fail_if (q == NULL);
+
+        for (i = 0; i < n; i++) {
+            gctx[i].q = q; gctx[i].count = 0;
+            pthread_create (&getters[i], NULL, bench_getter, &gctx[i]);
+        }
+
+        start = gu_time_monotonic();
+
+        for (i = 0; i < BENCH_ITEMS; i++) {
+            long* item = gu_fifo_get_tail (q);
+            fail_if (item == NULL);
+            *item = i;
+            gu_fifo_push_tail (q);
+        }
+
+        while (gu_fifo_length (q) > 0) sched_yield();
+
+        secs = (gu_time_monotonic() - start) * 1.0e-9;
+
+        gu_fifo_close (q);
+
+        for (i = 0; i < n; i++) {
+            pthread_join (getters[i], NULL);
+            count += gctx[i].count;
+        }
+
+        fail_if (count != BENCH_ITEMS, "got %ld items", count);
+
+        gu_info ("gu_fifo bench: %d getters: %.0f items/sec",
+                 n, BENCH_ITEMS / secs);
+
+        gu_fifo_destroy (q);
+    }
+}
+END_TEST
+
 Suite *gu_fifo_suite(void)
 {
     Suite *s  = suite_create("Galera FIFO functions");
@@ -213,6 +376,8 @@ Suite *gu_fifo_suite(void)
     suite_add_tcase (s, tc);
     tcase_add_test  (tc, gu_fifo_test);
     tcase_add_test  (tc, gu_fifo_cancel_test);
+    tcase_add_test  (tc, gu_fifo_mt_test);
+    tcase_add_test  (tc, gu_fifo_bench);
     return s;
 }
 
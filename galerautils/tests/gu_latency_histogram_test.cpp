@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 Codership Oy <info@codership.com>
+ */
+
+#include "../src/gu_latency_histogram.hpp"
+#include "../src/gu_logger.hpp"
+
+#include "gu_latency_histogram_test.hpp"
+
+using namespace gu;
+
+// percentiles must be within bucket precision of the real value
+static bool close_enough(long long val, long long expected)
+{
+    long long const err(expected/8 + 1);
+    return (val >= expected - err && val <= expected + err);
+}
+
+START_TEST(test_latency_histogram)
+{
+    LatencyHistogram h;
+
+    fail_if(h.count() != 0);
+    fail_if(h.percentile(0.5) != 0);
+
+    // 1us .. 1000us uniformly
+    for (long long i = 1; i <= 1000; ++i)
+    {
+        h.insert(i * 1000);
+    }
+
+    fail_if(h.count() != 1000, "count: %lld", h.count());
+    fail_if(h.max() != 1000000, "max: %lld", h.max());
+
+    fail_if(!close_enough(h.percentile(0.5), 500000),
+            "p50: %lld", h.percentile(0.5));
+    fail_if(!close_enough(h.percentile(0.9), 900000),
+            "p90: %lld", h.percentile(0.9));
+    fail_if(!close_enough(h.percentile(0.99), 990000),
+            "p99: %lld", h.percentile(0.99));
+    fail_if(h.percentile(1.0) > h.max());
+
+    // small values are exact, negative are clamped to 0
+    h.clear();
+    fail_if(h.count() != 0);
+    h.insert(-5);
+    h.insert(3);
+    fail_if(h.percentile(0.5) != 0, "p50: %lld", h.percentile(0.5));
+    fail_if(h.percentile(1.0) != 3, "p100: %lld", h.percentile(1.0));
+
+    // single huge value
+    h.clear();
+    h.insert(1LL << 62);
+    fail_if(h.percentile(0.5) != (1LL << 62));
+
+    log_info << h;
+}
+END_TEST
+
+Suite* gu_latency_histogram_suite()
+{
+    TCase* t = tcase_create ("test_latency_histogram");
+    tcase_add_test (t, test_latency_histogram);
+
+    Suite* s = suite_create ("gu::LatencyHistogram");
+    suite_add_tcase (s, t);
+
+    return s;
+}
@@ -0,0 +1,12 @@
+/*
+ * Copyright (C) 2026 Codership Oy <info@codership.com>
+ */
+
+#ifndef __gu_latency_histogram_test__
+#define __gu_latency_histogram_test__
+
+#include <check.h>
+
+extern Suite *gu_latency_histogram_suite(void);
+
+#endif // __gu_latency_histogram_test__
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015 Codership Oy <info@codership.com>
+ *
+ * $Id$
+ */
+
+#include "../src/gu_lz4.h"
+
+#include "gu_lz4_test.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ref_input \
+    "Galera replicates write sets. Galera replicates write sets. " \
+    "Galera replicates write sets!"
+
+/* ref_input compressed by the reference LZ4 implementation */
+static const unsigned char ref_output[] =
+{
+    0xff, 0x0f, 0x47, 0x61, 0x6c, 0x65, 0x72, 0x61, 0x20, 0x72, 0x65, 0x70,
+    0x6c, 0x69, 0x63, 0x61, 0x74, 0x65, 0x73, 0x20, 0x77, 0x72, 0x69, 0x74,
+    0x65, 0x20, 0x73, 0x65, 0x74, 0x73, 0x2e, 0x20, 0x1e, 0x00, 0x23, 0x50,
+    0x73, 0x65, 0x74, 0x73, 0x21
+};
+
+static void
+roundtrip (const char* const src, size_t const len, size_t* const comp_len)
+{
+    size_t const bound = gu_lz4_bound (len);
+    char* const  comp  = malloc (bound);
+    char* const  back  = malloc (len + 1);
+
+    fail_if (NULL == comp || NULL == back);
+
+    size_t const clen = gu_lz4_compress (src, len, comp, bound);
+    fail_if (0 == clen, "Failed to compress %zu bytes", len);
+    fail_if (clen > bound, "Compressed size %zu exceeds bound %zu", clen, bound);
+
+    ssize_t const dlen = gu_lz4_decompress (comp, clen, back, len);
+    fail_if (dlen != (ssize_t)len, "Decompressed %zd bytes, expected %zu",
+             dlen, len);
+    fail_if (memcmp (src, back, len), "Roundtrip mismatch at length %zu", len);
+
+    if (comp_len) *comp_len = clen;
+
+    free (back);
+    free (comp);
+}
+
+START_TEST (gu_lz4_test_reference)
+{
+    char buf[sizeof(ref_input)];
+
+    ssize_t const ret = gu_lz4_decompress (ref_output, sizeof(ref_output),
+                                           buf, sizeof(buf));
+    fail_if (ret != (ssize_t)strlen(ref_input), "Decompressed %zd bytes", ret);
+    fail_if (memcmp (buf, ref_input, ret));
+
+    size_t clen;
+    roundtrip (ref_input, strlen(ref_input), &clen);
+    fail_if (clen >= strlen(ref_input), "Not compressed: %zu", clen);
+}
+END_TEST
+
+START_TEST (gu_lz4_test_sizes)
+{
+    char   buf[1024];
+    size_t i;
+
+    /* repeated pattern that exercises short and overlapping matches */
+    for (i = 0; i < sizeof(buf); i++) buf[i] = "abcab"[i % 5];
+
+    for (i = 0; i <= 64; i++) roundtrip (buf, i, NULL);
+
+    roundtrip (buf, sizeof(buf), NULL);
+
+    /* run of the same byte - long overlapping match */
+    memset (buf, 'x', sizeof(buf));
+    size_t clen;
+    roundtrip (buf, sizeof(buf), &clen);
+    fail_if (clen > 32, "Run of %zu bytes compressed to %zu",
+             sizeof(buf), clen);
+}
+END_TEST
+
+START_TEST (gu_lz4_test_large)
+{
+    /* bigger than max offset with long literal runs */
+    size_t const len = 300000;
+    char* const  src = malloc (len);
+    size_t       i;
+    unsigned     seed = 1;
+
+    fail_if (NULL == src);
+
+    for (i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        /* text-like data: random words from a small alphabet */
+        src[i] = (i % 1000 < 700) ?
+            "row image "[i % 10] : 'a' + (seed >> 16) % 26;
+    }
+
+    size_t clen;
+    roundtrip (src, len, &clen);
+    fail_if (clen >= len);
+
+    free (src);
+}
+END_TEST
+
+START_TEST (gu_lz4_test_incompressible)
+{
+    size_t const len = 4096;
+    char* const  src = malloc (len);
+    char* const  dst = malloc (len);
+    size_t       i;
+    unsigned     seed = 7;
+
+    fail_if (NULL == src || NULL == dst);
+
+    for (i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        src[i] = seed >> 16;
+    }
+
+    /* does not fit in the space of the original */
+    fail_if (0 != gu_lz4_compress (src, len, dst, len));
+
+    /* but still must be decodable */
+    roundtrip (src, len, NULL);
+
+    free (dst);
+    free (src);
+}
+END_TEST
+
+START_TEST (gu_lz4_test_malformed)
+{
+    char buf[sizeof(ref_input)];
+
+    /* truncated input */
+    fail_if (-EINVAL != gu_lz4_decompress (ref_output, sizeof(ref_output) - 1,
+                                           buf, sizeof(buf)));
+    /* output does not fit */
+    fail_if (-EINVAL != gu_lz4_decompress (ref_output, sizeof(ref_output),
+                                           buf, strlen(ref_input) - 1));
+
+    /* offset beyond the beginning of output */
+    static const unsigned char bad_offset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    fail_if (-EINVAL != gu_lz4_decompress (bad_offset, sizeof(bad_offset),
+                                           buf, sizeof(buf)));
+
+    /* zero offset */
+    static const unsigned char zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    fail_if (-EINVAL != gu_lz4_decompress (zero_offset, sizeof(zero_offset),
+                                           buf, sizeof(buf)));
+
+    /* length continuation bytes missing */
+    static const unsigned char no_len[] = { 0xf0, 0xff };
+    fail_if (-EINVAL != gu_lz4_decompress (no_len, sizeof(no_len),
+                                           buf, sizeof(buf)));
+}
+END_TEST
+
+Suite *gu_lz4_suite(void)
+{
+    Suite *s  = suite_create("LZ4 block format");
+    TCase *tc = tcase_create("gu_lz4");
+
+    suite_add_tcase (s, tc);
+    tcase_add_test  (tc, gu_lz4_test_reference);
+    tcase_add_test  (tc, gu_lz4_test_sizes);
+    tcase_add_test  (tc, gu_lz4_test_large);
+    tcase_add_test  (tc, gu_lz4_test_incompressible);
+    tcase_add_test  (tc, gu_lz4_test_malformed);
+
+    return s;
+}
@@ -6,15 +6,20 @@
 #include "gcache_bh.hpp"
 
 #include <gu_logger.hpp>
+#include <gu_uuid.hpp>
+#include <gu_time.h>
 
 #include <cerrno>
 #include <unistd.h>
+#include <algorithm>
 
 namespace gcache
 {
     void
     GCache::reset()
     {
+        arenas_flush();
+
         mem.reset();
         rb.reset();
         ps.reset();
@@ -34,8 +39,55 @@ namespace gcache
 #endif
     }
 
+    /* arenas are used only if the ring buffer can spare them without
+     * noticeable loss of capacity */
+    static ssize_t
+    arena_size_for (ssize_t const rb_size, int const arenas)
+    {
+        static ssize_t const max_size(1 << 20);
+        static ssize_t const min_size(1 << 16);
+
+        ssize_t const size(std::min(max_size, rb_size / (arenas * 8)));
+
+        return (size >= min_size ? size : 0);
+    }
+
     void
-    GCache::constructor_common() {}
+    GCache::constructor_common()
+    {
+        int const err(pthread_key_create(&arena_key, NULL));
+
+        if (err) gu_throw_error(err) << "Failed to create arena key";
+
+        /* history recovered from the ring buffer is all released */
+        if (!seqno2ptr.empty())
+        {
+            seqno_max      = seqno2ptr.index_back();
+            seqno_released = seqno_max;
+        }
+    }
+
+    bool
+    GCache::recover (const gu_uuid_t& gid, int64_t const seqno)
+    {
+        {
+            gu::Lock lock(mtx);
+
+            if (!seqno2ptr.empty() && seqno >= 0 && rb.gid() == gid &&
+                seqno2ptr.index_back() == seqno)
+            {
+                log_info << "Keeping recovered GCache history " << gid
+                         << ':' << seqno2ptr.index_front() << '-' << seqno;
+                return true;
+            }
+
+            rb.set_gid(gid);
+        }
+
+        reset();
+
+        return false;
+    }
 
     GCache::GCache (gu::Config& cfg, const std::string& data_dir)
         :
@@ -56,7 +108,12 @@ namespace gcache
         frees     (0),
         seqno_locked(SEQNO_NONE),
         seqno_max   (SEQNO_NONE),
-        seqno_released(0)
+        seqno_released(0),
+        arena_size  (arena_size_for(rb.size(), ARENAS)),
+        arena_key   (),
+        arena_next  (0),
+        arenas      (),
+        arenas_trimmed(gu_time_monotonic())
 #ifndef NDEBUG
         ,buf_tracker()
 #endif
@@ -66,6 +123,9 @@ namespace gcache
 
     GCache::~GCache ()
     {
+        arenas_flush();
+        pthread_key_delete(arena_key);
+
         gu::Lock lock(mtx);
         log_debug << "\n" << "GCache mallocs : " << mallocs
                   << "\n" << "GCache reallocs: " << reallocs
@@ -12,14 +12,15 @@
 #include <gu_types.hpp>
 #include <gu_lock.hpp> // for gu::Mutex and gu::Cond
 #include <gu_config.hpp>
+#include <gu_atomic.hpp>
 
 #include <string>
 #include <iostream>
-#include <map>
 #ifndef NDEBUG
 #include <set>
 #endif
 #include <stdint.h>
+#include <pthread.h>
 
 namespace gcache
 {
@@ -34,7 +35,8 @@ namespace gcache
 
         /*!
          * Creates a new gcache file in "gcache.name" conf parameter or
-         * in data_dir. If file already exists, it gets overwritten.
+         * in data_dir. If file already exists and was closed cleanly,
+         * history stored in it is recovered, otherwise it gets overwritten.
          */
         GCache (gu::Config& cfg, const std::string& data_dir);
 
@@ -46,6 +48,16 @@ namespace gcache
         /* Resets storage */
         void  reset();
 
+        /*!
+         * Keeps history recovered on startup if it belongs to gid and ends
+         * at seqno, otherwise resets storage.
+         * @return true if recovered history was kept
+         */
+        bool  recover (const gu_uuid_t& gid, int64_t seqno);
+
+        /*! UUID of the history cached buffers belong to */
+        const gu_uuid_t& gid() const { return rb.gid(); }
+
         /* Memory allocation functions */
         void* malloc  (int size);
         void  free    (void* ptr);
@@ -55,9 +67,9 @@ namespace gcache
 
         /*!
          * Reinitialize seqno sequence (after SST or such)
-         * Clears seqno->ptr map // and sets seqno_min to seqno.
+         * Clears seqno->ptr map and starts history gid.
          */
-        void  seqno_reset (/*int64_t seqno*/);
+        void  seqno_reset (const gu_uuid_t& gid);
 
         /*!
          * Assign sequence number to buffer pointed to by ptr
@@ -78,7 +90,7 @@ namespace gcache
         {
             gu::Lock lock(mtx);
             if (gu_likely(!seqno2ptr.empty()))
-                return seqno2ptr.begin()->first;
+                return seqno2ptr.index_front();
             else
                 return -1;
         }
@@ -211,9 +223,7 @@ namespace gcache
         gu::Mutex       mtx;
         gu::Cond        cond;
 
-        typedef std::map<int64_t, const void*>  seqno2ptr_t;
-        typedef seqno2ptr_t::iterator           seqno2ptr_iter_t;
-        typedef std::pair<int64_t, const void*> seqno2ptr_pair_t;
+        typedef Seqno2Ptr seqno2ptr_t;
         seqno2ptr_t     seqno2ptr;
 
         MemStore        mem;
@@ -228,6 +238,58 @@ namespace gcache
         int64_t         seqno_max;
         int64_t         seqno_released;
 
+        /* Front end to the ring buffer allocator. Threads are spread over
+         * arenas, each holding a ring buffer area to carve small buffers
+         * from and a batch of unordered buffers to be freed, both under
+         * the arena lock. The cache lock is taken only to refill the area
+         * and to release the batch. Arenas of threads that went idle are
+         * released on the next refill after ARENA_IDLE, all arenas are
+         * released when the ring buffer runs out of space. */
+        static int       const ARENAS      = 8;
+        static int       const ARENA_BATCH = 32;
+        static long long const ARENA_IDLE  = 1000000000LL; // 1 sec
+
+        class Arena
+        {
+        public:
+
+            Arena() : mtx(), filler(0), pending(), pending_num(0), mallocs(0),
+                      idle(false)
+            {}
+
+            gu::Mutex     mtx;
+            BufferHeader* filler;    // unused part of the reserved area
+            BufferHeader* pending[ARENA_BATCH]; // buffers to be freed
+            int           pending_num;
+            long long     mallocs;
+            bool          idle;      // not used since the last trim
+
+        private:
+
+            Arena (const Arena&);
+            Arena& operator = (const Arena&);
+        };
+
+        ssize_t   const arena_size; // 0 if arenas are not used
+        pthread_key_t   arena_key;
+        gu::Atomic<int> arena_next;
+        Arena           arenas[ARENAS];
+        long long       arenas_trimmed; // time of the last trim
+
+        Arena& arena();
+
+        void*  arena_malloc  (int size);
+
+        /* frees pending buffers and optionally returns unused area,
+         * must be called under both arena and cache locks */
+        void   arena_release (Arena& a, bool filler);
+
+        void   arenas_flush  ();
+
+        /* releases arenas that were not used for ARENA_IDLE,
+         * must be called without locks */
+        void   arenas_trim   ();
+
 
 #ifndef NDEBUG
         std::set<const void*> buf_tracker;
@@ -4,6 +4,8 @@
 
 #include "GCache.hpp"
 
+#include <gu_time.h>
+
 #include <cassert>
 
 namespace gcache
@@ -11,18 +13,17 @@ namespace gcache
     bool
     GCache::discard_seqno (int64_t seqno)
     {
-        for (seqno2ptr_t::iterator i = seqno2ptr.begin();
-             i != seqno2ptr.end() && i->first <= seqno;)
+        while (!seqno2ptr.empty() && seqno2ptr.index_front() <= seqno)
         {
-            BufferHeader* bh(ptr2BH (i->second));
+            BufferHeader* bh(ptr2BH (seqno2ptr.front()));
 
             if (gu_likely(BH_is_released(bh)))
             {
-                assert (bh->seqno_g == i->first);
+                assert (bh->seqno_g == seqno2ptr.index_front());
                 assert (bh->seqno_g <= seqno);
                 assert (bh->seqno_g <= seqno_released);
 
-                seqno2ptr.erase (i++); // post ++ is significant!
+                seqno2ptr.pop_front();
 
                 bh->seqno_g = SEQNO_ILL; // will never be reused
 
@@ -45,17 +46,176 @@ namespace gcache
         return true;
     }
 
+    GCache::Arena&
+    GCache::arena()
+    {
+        void* const idx(pthread_getspecific(arena_key));
+
+        if (gu_likely(0 != idx))
+        {
+            return arenas[reinterpret_cast<intptr_t>(idx) - 1];
+        }
+
+        /* first call from this thread, assign arenas round robin */
+        intptr_t const i(arena_next.fetch_and_add(1) % ARENAS);
+
+        pthread_setspecific(arena_key, reinterpret_cast<void*>(i + 1));
+
+        return arenas[i];
+    }
+
+    void
+    GCache::arena_release (Arena& a, bool const filler)
+    {
+        for (int i(0); i < a.pending_num; ++i) free_common(a.pending[i]);
+
+        a.pending_num = 0;
+
+        if (filler && 0 != a.filler)
+        {
+            BH_release(a.filler);
+            rb.free(a.filler);
+            a.filler = 0;
+        }
+
+        mallocs += a.mallocs;
+        a.mallocs = 0;
+    }
+
+    void
+    GCache::arenas_flush ()
+    {
+        for (int i(0); i < ARENAS; ++i)
+        {
+            gu::Lock lock(arenas[i].mtx);
+            gu::Lock cache_lock(mtx);
+            arena_release(arenas[i], true);
+        }
+    }
+
+    void
+    GCache::arenas_trim ()
+    {
+        {
+            gu::Lock lock(mtx);
+
+            long long const now(gu_time_monotonic());
+
+            if (now - arenas_trimmed < ARENA_IDLE) return;
+
+            arenas_trimmed = now;
+        }
+
+        for (int i(0); i < ARENAS; ++i)
+        {
+            Arena&   a(arenas[i]);
+            gu::Lock lock(a.mtx);
+
+            if (a.idle && (0 != a.filler || a.pending_num > 0))
+            {
+                gu::Lock cache_lock(mtx);
+                arena_release(a, true);
+            }
+
+            a.idle = true;
+        }
+    }
+
+    void*
+    GCache::arena_malloc (int const size)
+    {
+        BufferHeader* bh(0);
+        bool          refilled(false);
+
+        {
+            Arena&   a(arena());
+            gu::Lock lock(a.mtx);
+
+            a.idle = false;
+
+            if (gu_likely(0 != a.filler))
+            {
+                bh = RingBuffer::carve(a.filler, size);
+            }
+
+            if (gu_unlikely(0 == bh))
+            {
+                gu::Lock cache_lock(mtx);
+
+                arena_release(a, true);
+
+                void* const area(rb.malloc(arena_size));
+
+                if (0 != area)
+                {
+                    a.filler = ptr2BH(area);
+                    bh = RingBuffer::carve(a.filler, size);
+                    assert(0 != bh);
+                    refilled = true;
+                }
+            }
+
+            if (gu_likely(0 != bh)) ++a.mallocs;
+        }
+
+        if (gu_unlikely(0 == bh))
+        {
+            /* ring buffer is full, other arenas may be holding its space */
+            arenas_flush();
+            return 0;
+        }
+
+        /* idle threads would keep their arenas forever otherwise */
+        if (gu_unlikely(refilled)) arenas_trim();
+
+        void* const ptr(bh + 1);
+#ifndef NDEBUG
+        gu::Lock lock(mtx);
+        buf_tracker.insert (ptr);
+#endif
+        return ptr;
+    }
+
     void*
     GCache::malloc (int size)
     {
         size += sizeof(BufferHeader);
 
+        bool flushed(false);
+
+        /* Reading mem_size without lock is benign: it only chooses which
+         * store is tried first. */
+        if (size <= arena_size / 4 && 0 == params.mem_size())
+        {
+            void* const ptr(arena_malloc(size));
+
+            if (gu_likely(0 != ptr)) return ptr;
+
+            flushed = true; // arena_malloc() fails only after flushing
+        }
+
+        void* ptr(0);
+
+        if (arena_size > 0 && !flushed)
+        {
+            {
+                gu::Lock lock(mtx);
+
+                ptr = mem.malloc(size);
+
+                if (0 == ptr) ptr = rb.malloc(size);
+            }
+
+            /* arenas may be holding the ring buffer space, don't spill to
+             * the page store before they give it back */
+            if (0 == ptr) arenas_flush();
+        }
+
         gu::Lock lock(mtx);
-        void*    ptr;
 
         mallocs++;
 
-        ptr = mem.malloc(size);
+        if (0 == ptr) ptr = mem.malloc(size);
 
         if (0 == ptr) ptr = rb.malloc(size);
 
@@ -124,6 +284,26 @@ namespace gcache
         if (gu_likely(0 != ptr))
         {
             BufferHeader* const bh(ptr2BH(ptr));
+
+            /* unordered buffers are released in batches. Ordered ones must
+             * be released in order, so they go straight to free_common() */
+            if (arena_size > 0 && SEQNO_NONE == bh->seqno_g)
+            {
+                Arena&   a(arena());
+                gu::Lock lock(a.mtx);
+
+                a.idle = false;
+                a.pending[a.pending_num] = bh;
+
+                if (++a.pending_num == ARENA_BATCH)
+                {
+                    gu::Lock cache_lock(mtx);
+                    arena_release(a, false);
+                }
+
+                return;
+            }
+
             gu::Lock      lock(mtx);
 
             free_common (bh);
@@ -8,6 +8,7 @@
 
 #include <cerrno>
 #include <cassert>
+#include <algorithm>
 
 #include <sched.h> // sched_yeild()
 
@@ -15,14 +16,19 @@ namespace gcache
 {
     /*!
      * Reinitialize seqno sequence (after SST or such)
-     * Clears seqno->ptr map // and sets seqno_min to seqno.
+     * Clears seqno->ptr map and starts history gid.
      */
     void
-    GCache::seqno_reset ()
+    GCache::seqno_reset (const gu_uuid_t& gid)
     {
+        arenas_flush();
+
         gu::Lock lock(mtx);
 
+        rb.set_gid(gid);
+
         seqno_released = SEQNO_NONE;
+        seqno_max      = SEQNO_NONE;
 
         if (gu_unlikely(seqno2ptr.empty())) return;
 
@@ -51,20 +57,17 @@ namespace gcache
 
         if (gu_likely(seqno_g > seqno_max))
         {
-            seqno2ptr.insert (seqno2ptr.end(), seqno2ptr_pair_t(seqno_g, ptr));
+            seqno2ptr.insert (seqno_g, ptr);
             seqno_max = seqno_g;
         }
         else
         {
             // this should never happen. seqnos should be assinged in TO.
-            const std::pair<seqno2ptr_iter_t, bool>& res(
-                seqno2ptr.insert (seqno2ptr_pair_t(seqno_g, ptr)));
-
-            if (false == res.second)
+            if (false == seqno2ptr.insert (seqno_g, ptr))
             {
                 gu_throw_fatal <<"Attempt to reuse the same seqno: " << seqno_g
                                <<". New ptr = " << ptr << ", previous ptr = "
-                               << res.first->second;
+                               << seqno2ptr.find(seqno_g);
             }
         }
 
@@ -99,9 +102,8 @@ namespace gcache
 
             assert(seqno >= seqno_released);
 
-            seqno2ptr_iter_t it(seqno2ptr.upper_bound(seqno_released));
-
-            if (gu_unlikely(it == seqno2ptr.end()))
+            if (gu_unlikely(seqno2ptr.empty() ||
+                            seqno2ptr.index_back() <= seqno_released))
             {
                 /* This means that there are no element with
                  * seqno following seqno_released - and this should not
@@ -122,7 +124,10 @@ namespace gcache
             batch_size += (new_gap >= old_gap) * min_batch_size;
             old_gap = new_gap;
 
-            int64_t const start(it->first - 1);
+            /* first seqno following seqno_released */
+            int64_t idx(std::max(seqno_released + 1, seqno2ptr.index_front()));
+
+            int64_t const start(idx - 1);
             int64_t const end  (seqno - start >= 2*batch_size ?
                                 start + batch_size : seqno);
 #if 0
@@ -130,27 +135,33 @@ namespace gcache
                      << " buffers, batch_size: " << batch_size
                      << ", end: " << end;
 #endif
-            for (;(loop = (it != seqno2ptr.end())) && it->first <= end;)
+            /* free_common() below may erase elements from the front of
+             * seqno2ptr, so index_back() must be re-checked on every step */
+            for (;(loop = (!seqno2ptr.empty() &&
+                           idx <= seqno2ptr.index_back())) && idx <= end;
+                 ++idx)
             {
-                assert(it->first != SEQNO_NONE);
-                BufferHeader* const bh(ptr2BH(it->second));
-                assert (bh->seqno_g == it->first);
+                const void* const ptr(seqno2ptr.find(idx));
+
+                if (gu_unlikely(0 == ptr)) continue;
+
+                BufferHeader* const bh(ptr2BH(ptr));
+                assert (bh->seqno_g == idx);
 #ifndef NDEBUG
-                if (!(seqno_released + 1 == it->first ||
+                if (!(seqno_released + 1 == idx ||
                       seqno_released == SEQNO_NONE))
                 {
                     log_info << "seqno_released: " << seqno_released
-                             << "; it->first: " << it->first
-                             << "; seqno2ptr.begin: " <<seqno2ptr.begin()->first
+                             << "; idx: " << idx
+                             << "; seqno2ptr.front: "
+                             << seqno2ptr.index_front()
                              << "\nstart: " << start << "; end: " << end
                              << " batch_size: " << batch_size << "; gap: "
                              << new_gap << "; seqno_max: " << seqno_max;
-                    assert(seqno_released + 1 == it->first ||
+                    assert(seqno_released + 1 == idx ||
                            seqno_released == SEQNO_NONE);
                 }
 #endif
-                ++it; /* free_common() below may erase current element,
-                       * so advance iterator before calling free_common()*/
                 if (gu_likely(!BH_is_released(bh))) free_common(bh);
             }
 
@@ -169,7 +180,7 @@ namespace gcache
     {
         gu::Lock lock(mtx);
 
-        if (seqno2ptr.find(seqno_g) == seqno2ptr.end()) throw gu::NotFound();
+        if (0 == seqno2ptr.find(seqno_g)) throw gu::NotFound();
 
         if (seqno_locked != SEQNO_NONE)
         {
@@ -192,17 +203,15 @@ namespace gcache
         {
             gu::Lock lock(mtx);
 
-            seqno2ptr_iter_t p = seqno2ptr.find(seqno_g);
+            ptr = seqno2ptr.find(seqno_g);
 
-            if (p != seqno2ptr.end())
+            if (0 != ptr)
             {
                 if (seqno_locked != SEQNO_NONE)
                 {
                     cond.signal();
                 }
                 seqno_locked = seqno_g;
-
-                ptr = p->second;
             }
             else
             {
@@ -232,9 +241,9 @@ namespace gcache
         {
             gu::Lock lock(mtx);
 
-            seqno2ptr_iter_t p = seqno2ptr.find(start);
+            const void* p(seqno2ptr.find(start));
 
-            if (p != seqno2ptr.end())
+            if (0 != p)
             {
                 if (seqno_locked != SEQNO_NONE)
                 {
@@ -244,12 +253,10 @@ namespace gcache
                 seqno_locked = start;
 
                 do {
-                    assert (p->first == (start + found));
-                    assert (p->second);
-                    v[found].set_ptr(p->second);
+                    v[found].set_ptr(p);
                 }
-                while (++found < max && ++p != seqno2ptr.end() &&
-                       p->first == (start + found));
+                while (++found < max &&
+                       0 != (p = seqno2ptr.find(start + found)));
                 /* the latter condition ensures seqno continuty, #643 */
             }
         }
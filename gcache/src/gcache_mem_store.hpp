@@ -9,17 +9,16 @@
 
 #include "gcache_memops.hpp"
 #include "gcache_bh.hpp"
+#include "gcache_seqno2ptr.hpp"
 
 #include <string>
 #include <set>
-#include <map>
 
 namespace gcache
 {
     class MemStore : public MemOps
     {
-        typedef std::map<int64_t, const void*> seqno2ptr_t;
-        typedef seqno2ptr_t::iterator          seqno2ptr_iter_t;
+        typedef Seqno2Ptr seqno2ptr_t;
 
     public:
 
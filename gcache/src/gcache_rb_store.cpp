@@ -8,8 +8,11 @@
 
 #include <gu_logger.hpp>
 #include <gu_throw.hpp>
+#include <gu_uuid.hpp>
 
 #include <cassert>
+#include <cstdio>
+#include <map>
 
 namespace gcache
 {
@@ -40,7 +43,7 @@ namespace gcache
     RingBuffer::constructor_common() {}
 
     RingBuffer::RingBuffer (const std::string& name, ssize_t size,
-                            std::map<int64_t, const void*> & seqno2ptr)
+                            Seqno2Ptr& seqno2ptr)
     :
         fd_        (name, check_size(size)),
         mmap_      (fd_),
@@ -59,32 +62,206 @@ namespace gcache
         size_trail_(0),
 //        mallocs_   (0),
 //        reallocs_  (0),
-        seqno2ptr_ (seqno2ptr)
+        seqno2ptr_ (seqno2ptr),
+        gid_       (GU_UUID_NIL)
     {
         constructor_common ();
-        BH_clear (BH_cast(next_));
+
+        if (!recover()) reset();
+
+        /* until clean shutdown the contents can't be trusted */
+        write_header (false);
+        mmap_.sync();
     }
 
     RingBuffer::~RingBuffer ()
     {
         open_ = false;
+        write_header (false);
+        mmap_.sync();
+        write_header (true);
         mmap_.sync();
         mmap_.unmap();
     }
 
+    void
+    RingBuffer::write_header (bool const synced)
+    {
+        int64_t seqno_min(SEQNO_NONE);
+        int64_t seqno_max(SEQNO_NONE);
+
+        if (!seqno2ptr_.empty())
+        {
+            seqno_min = seqno2ptr_.index_front();
+            seqno_max = seqno2ptr_.index_back();
+        }
+
+        header_[HDR_VERSION]   = VERSION;
+        header_[HDR_SYNCED]    = synced;
+        header_[HDR_SIZE]      = mmap_.size;
+        header_[HDR_FIRST]     = first_ - start_;
+        header_[HDR_NEXT]      = next_  - start_;
+        header_[HDR_SEQNO_MIN] = seqno_min;
+        header_[HDR_SEQNO_MAX] = seqno_max;
+        ::memcpy (header_ + HDR_GID, &gid_, sizeof(gid_));
+
+        ::memset (preamble_, 0, PREAMBLE_LEN);
+        ::snprintf (preamble_, PREAMBLE_LEN,
+                    "* GCache ring buffer storage: do not edit *\n"
+                    "Version: %lld\nGID: " GU_UUID_FORMAT "\n"
+                    "Seqno: %lld - %lld\nSynced: %d\n",
+                    static_cast<long long>(VERSION), GU_UUID_ARGS(&gid_),
+                    static_cast<long long>(seqno_min),
+                    static_cast<long long>(seqno_max), int(synced));
+    }
+
+    /* Rebuilds buffer chain and seqno map from a cleanly closed file.
+     * Returns false if there is nothing to recover or the file fails
+     * validation. */
+    bool
+    RingBuffer::recover ()
+    {
+        if (0 == header_[HDR_VERSION]) return false; // new file
+
+        if (header_[HDR_VERSION] != VERSION || header_[HDR_SYNCED] != 1 ||
+            header_[HDR_SIZE] != int64_t(mmap_.size))
+        {
+            log_info << "Ring buffer '" << fd_.name() << "' was not closed "
+                     << "cleanly or has changed size, discarding contents.";
+            return false;
+        }
+
+        int64_t const first_off(header_[HDR_FIRST]);
+        int64_t const next_off (header_[HDR_NEXT]);
+        ssize_t const bh_size  (sizeof(BufferHeader));
+
+        if (first_off < 0 || first_off > end_ - start_ - bh_size ||
+            next_off  < 0 || next_off  > end_ - start_ - bh_size)
+        {
+            log_warn << "Ring buffer '" << fd_.name() << "': corrupt header: "
+                     << "first: " << first_off << ", next: " << next_off;
+            return false;
+        }
+
+        uint8_t* const first(start_ + first_off);
+        uint8_t* const next (start_ + next_off);
+        BufferHeader const* const nbh(BH_cast(next));
+
+        if (first == next) return false; // empty
+
+        if (nbh->size != 0 || nbh->seqno_g != 0 || nbh->store != 0)
+        {
+            log_warn << "Ring buffer '" << fd_.name()
+                     << "': next buffer header is not clear";
+            return false;
+        }
+
+        typedef std::map<int64_t, const void*> recovered_t;
+
+        recovered_t seqno2ptr;
+        ssize_t     trail(0);
+        uint8_t*    limit(first < next ? next : end_ - bh_size);
+
+        for (uint8_t* p(first); p != next;)
+        {
+            BufferHeader* const bh(BH_cast(p));
+
+            if (0 == bh->size && 0 == trail && first > next)
+            {
+                /* rollover */
+                trail = end_ - p;
+                p     = start_;
+                limit = next;
+                continue;
+            }
+
+            int64_t const seqno_g(bh->seqno_g);
+            bool    const seqno_ok(seqno_g > 0 || SEQNO_NONE == seqno_g ||
+                                   SEQNO_ILL == seqno_g);
+
+            if (bh->size < bh_size || bh->size > limit - p ||
+                bh->store != BUFFER_IN_RB || !seqno_ok ||
+                (seqno_g > 0 &&
+                 !seqno2ptr.insert(std::make_pair(seqno_g, bh + 1)).second))
+            {
+                log_warn << "Ring buffer '" << fd_.name()
+                         << "': corrupt buffer header at offset "
+                         << (p - start_) << ": " << bh;
+                return false;
+            }
+
+            p += bh->size;
+        }
+
+        if (seqno2ptr.empty() ||
+            seqno2ptr.rbegin()->first != header_[HDR_SEQNO_MAX])
+        {
+            return false;
+        }
+
+        /* IST needs continuous history, keep only the last continuous range
+         * of seqnos */
+        recovered_t::reverse_iterator r(seqno2ptr.rbegin());
+        int64_t                       seqno_min(r->first);
+
+        for (++r; r != seqno2ptr.rend() && r->first + 1 == seqno_min; ++r)
+        {
+            seqno_min = r->first;
+        }
+
+        first_      = first;
+        next_       = next;
+        size_used_  = 0;
+        size_free_  = size_cache_;
+        size_trail_ = trail;
+        max_used_   = (first > next ? end_ : next + bh_size) -
+            static_cast<uint8_t*>(mmap_.ptr);
+        ::memcpy (&gid_, header_ + HDR_GID, sizeof(gid_));
+
+        for (uint8_t* p(first); p != next;)
+        {
+            BufferHeader* const bh(BH_cast(p));
+
+            if (0 == bh->size) { p = start_; continue; }
+
+            bh->ctx   = this;
+            bh->flags = BUFFER_RELEASED; // nobody holds it after restart
+
+            if (bh->seqno_g >= seqno_min)
+            {
+                seqno2ptr_.insert (bh->seqno_g, bh + 1);
+                size_free_ -= bh->size;
+            }
+            else
+            {
+                bh->seqno_g = SEQNO_ILL;
+            }
+
+            p += bh->size;
+        }
+
+        assert_sizes();
+
+        log_info << "Recovered "
+                 << (seqno2ptr_.index_back() - seqno_min + 1) << " buffers ("
+                 << (size_cache_ - size_free_) << " bytes) from ring buffer '"
+                 << fd_.name() << "', history " << gid_ << ':'
+                 << seqno_min << '-' << seqno2ptr_.index_back();
+
+        return true;
+    }
+
     /* discard all seqnos preceeding and including seqno */
     bool
     RingBuffer::discard_seqno (int64_t seqno)
     {
-        for (seqno2ptr_t::iterator i = seqno2ptr_.begin();
-             i != seqno2ptr_.end() && i->first <= seqno;)
+        while (!seqno2ptr_.empty() && seqno2ptr_.index_front() <= seqno)
         {
-            seqno2ptr_t::iterator j(i); ++i;
-            BufferHeader* const bh (ptr2BH (j->second));
+            BufferHeader* const bh (ptr2BH (seqno2ptr_.front()));
 
             if (gu_likely (BH_is_released(bh)))
             {
-                seqno2ptr_.erase (j);
+                seqno2ptr_.pop_front();
                 bh->seqno_g = SEQNO_ILL;  // will never be accessed by seqno
 
                 switch (bh->store)
@@ -345,17 +522,19 @@ namespace gcache
          * end of released buffers chain. */
         BufferHeader* bh(0);
 
-        for (seqno2ptr_t::reverse_iterator r(seqno2ptr_.rbegin());
-             r != seqno2ptr_.rend(); ++r)
+        for (int64_t s(seqno2ptr_.empty() ? 0 : seqno2ptr_.index_back());
+             s > 0 && s >= seqno2ptr_.index_front(); --s)
         {
-            BufferHeader* const b(ptr2BH(r->second));
+            const void* const ptr(seqno2ptr_.find(s));
+            if (0 == ptr) continue;
+
+            BufferHeader* const b(ptr2BH(ptr));
             if (BUFFER_IN_RB == b->store)
             {
 #ifndef NDEBUG
                 if (!BH_is_released(b))
                 {
-                    log_fatal << "Buffer "
-                              << reinterpret_cast<const void*>(r->second)
+                    log_fatal << "Buffer " << ptr
                               << ", seqno_g " << b->seqno_g << ", seqno_d "
                               << b->seqno_d << " is not released.";
                     assert(0);
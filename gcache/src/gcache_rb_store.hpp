@@ -9,12 +9,13 @@
 
 #include "gcache_memops.hpp"
 #include "gcache_bh.hpp"
+#include "gcache_seqno2ptr.hpp"
 
 #include <gu_fdesc.hpp>
 #include <gu_mmap.hpp>
+#include <gu_uuid.h>
 
 #include <string>
-#include <map>
 #include <stdint.h>
 
 namespace gcache
@@ -23,8 +24,13 @@ namespace gcache
     {
     public:
 
+        /*!
+         * Opens ring buffer file. If the file was closed cleanly and its
+         * size did not change, buffers ordered at shutdown are recovered
+         * into seqno2ptr, otherwise the contents are discarded.
+         */
         RingBuffer (const std::string& name, ssize_t size,
-                    std::map<int64_t, const void*>& seqno2ptr);
+                    Seqno2Ptr& seqno2ptr);
 
         ~RingBuffer ();
 
@@ -34,6 +40,40 @@ namespace gcache
 
         void* realloc (void* ptr, int size);
 
+        /*!
+         * Splits buffer of size bytes off the front of filler - a buffer
+         * obtained by malloc() to sub-allocate from - and moves filler past
+         * it. Does not touch ring buffer state, so the owner of the filler
+         * needs no ring buffer lock. Unused filler space is returned by
+         * releasing and freeing the filler as usual.
+         *
+         * @return buffer header or 0 if the filler is too small
+         */
+        static BufferHeader* carve (BufferHeader*& filler, ssize_t const size)
+        {
+            assert (size >= ssize_t(sizeof(BufferHeader)));
+            assert (!BH_is_released(filler));
+            assert (SEQNO_NONE == filler->seqno_g);
+
+            /* filler must keep room for its own header */
+            if (filler->size < size + ssize_t(sizeof(BufferHeader))) return 0;
+
+            BufferHeader* const bh  (filler);
+            BufferHeader* const rest(BH_cast(reinterpret_cast<uint8_t*>(bh)
+                                             + size));
+            rest->size    = bh->size - size;
+            rest->seqno_g = SEQNO_NONE;
+            rest->seqno_d = SEQNO_ILL;
+            rest->flags   = 0;
+            rest->store   = BUFFER_IN_RB;
+            rest->ctx     = bh->ctx;
+
+            bh->size = size;
+            filler   = rest;
+
+            return bh;
+        }
+
         void  discard (BufferHeader* const bh)
         {
             assert (BH_is_released(bh));
@@ -57,6 +97,11 @@ namespace gcache
 
         void print (std::ostream& os) const;
 
+        /*! UUID of the history stored in the buffer */
+        const gu_uuid_t& gid() const { return gid_; }
+
+        void  set_gid (const gu_uuid_t& gid) { gid_ = gid; }
+
         static ssize_t pad_size()
         {
             RingBuffer* rb(0);
@@ -108,6 +153,21 @@ namespace gcache
         static ssize_t const PREAMBLE_LEN = 1024;
         static ssize_t const HEADER_LEN = 32;
 
+        /* binary header layout, int64_t words */
+        enum
+        {
+            HDR_VERSION,
+            HDR_SYNCED,    // 1 if the file was closed cleanly
+            HDR_SIZE,      // size of the file
+            HDR_FIRST,     // offset of first_ from start_
+            HDR_NEXT,      // offset of next_  from start_
+            HDR_SEQNO_MIN,
+            HDR_SEQNO_MAX,
+            HDR_GID        // 2 words
+        };
+
+        static int64_t const VERSION = 1;
+
         gu::FileDescriptor fd_;
         gu::MMap           mmap_;
         bool               open_;
@@ -125,12 +185,17 @@ namespace gcache
         ssize_t            size_used_;
         ssize_t            size_trail_;
 
-        typedef std::map<int64_t, const void*> seqno2ptr_t;
+        typedef Seqno2Ptr seqno2ptr_t;
 
         seqno2ptr_t&    seqno2ptr_;
+        gu_uuid_t       gid_;
 
         BufferHeader*   get_new_buffer (ssize_t size);
 
+        bool            recover ();
+
+        void            write_header (bool synced);
+
         void            constructor_common();
 
         RingBuffer(const gcache::RingBuffer&);
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+/*! @file seqno to buffer pointer index */
+
+#ifndef _gcache_seqno2ptr_hpp_
+#define _gcache_seqno2ptr_hpp_
+
+#include "SeqnoNone.hpp"
+
+#include <gu_assert.h>
+#include <gu_macros.h>
+
+#include <deque>
+#include <stdint.h>
+
+namespace gcache
+{
+    /*!
+     * Since seqnos are dense, this is a deque of buffer pointers indexed by
+     * (seqno - index_front()). Missing seqnos are represented by 0 pointers.
+     * Front and back elements are never 0, so empty() means no seqnos.
+     */
+    class Seqno2Ptr
+    {
+    public:
+
+        Seqno2Ptr() : ptrs_(), begin_(SEQNO_NONE) {}
+
+        bool    empty() const { return ptrs_.empty(); }
+
+        void    clear() { ptrs_.clear(); }
+
+        /*! first seqno in the index */
+        int64_t index_front() const { assert(!empty()); return begin_; }
+
+        /*! last seqno in the index */
+        int64_t index_back() const
+        {
+            assert(!empty());
+            return begin_ + ptrs_.size() - 1;
+        }
+
+        const void* front() const { return ptrs_.front(); }
+        const void* back()  const { return ptrs_.back();  }
+
+        /*! @return buffer pointer or 0 if seqno is not in the index */
+        const void* find (int64_t const seqno) const
+        {
+            if (seqno < begin_ || seqno - begin_ >= int64_t(ptrs_.size()))
+            {
+                return 0;
+            }
+
+            return ptrs_[seqno - begin_];
+        }
+
+        /*! @return false if seqno is already in the index */
+        bool insert (int64_t const seqno, const void* const ptr)
+        {
+            assert (seqno > 0);
+            assert (0 != ptr);
+
+            if (gu_unlikely(empty()))
+            {
+                begin_ = seqno;
+                ptrs_.push_back(ptr);
+                return true;
+            }
+
+            int64_t const end(begin_ + ptrs_.size());
+
+            if (gu_likely(seqno == end))
+            {
+                ptrs_.push_back(ptr);
+            }
+            else if (seqno > end)
+            {
+                ptrs_.insert(ptrs_.end(), seqno - end, 0);
+                ptrs_.push_back(ptr);
+            }
+            else if (seqno < begin_)
+            {
+                ptrs_.insert(ptrs_.begin(), begin_ - seqno - 1, 0);
+                ptrs_.push_front(ptr);
+                begin_ = seqno;
+            }
+            else
+            {
+                const void*& p(ptrs_[seqno - begin_]);
+                if (0 != p) return false;
+                p = ptr;
+            }
+
+            return true;
+        }
+
+        void pop_front()
+        {
+            assert(!empty());
+
+            do
+            {
+                ptrs_.pop_front();
+                ++begin_;
+            }
+            while (!ptrs_.empty() && 0 == ptrs_.front());
+        }
+
+        void erase (int64_t const seqno)
+        {
+            assert(0 != find(seqno));
+
+            if (seqno == begin_)
+            {
+                pop_front();
+                return;
+            }
+
+            ptrs_[seqno - begin_] = 0;
+
+            while (0 == ptrs_.back()) ptrs_.pop_back();
+        }
+
+    private:
+
+        std::deque<const void*> ptrs_;
+        int64_t                 begin_;
+    };
+}
+
+#endif /* _gcache_seqno2ptr_hpp_ */
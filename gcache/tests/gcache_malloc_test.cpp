@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 Codership Oy <info@codership.com>
+ */
+
+#include "GCache.hpp"
+#include "gcache_bh.hpp"
+#include "gcache_malloc_test.hpp"
+
+#include <gu_config.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+using namespace gcache;
+
+static std::string const rb_name("malloc_test");
+static ssize_t const     rb_size(8 << 20);
+
+struct MallocCtx
+{
+    MallocCtx(GCache& gc) : gc_(gc), errors_(0) {}
+
+    GCache&          gc_;
+    gu::Atomic<long> errors_;
+
+private:
+
+    MallocCtx(const MallocCtx&);
+    void operator=(const MallocCtx&);
+};
+
+/* keeps a window of live unordered buffers of varying size, so that arena
+ * areas get carved, refilled and pending frees accumulate */
+extern "C" void* malloc_user(void* arg)
+{
+    MallocCtx& ctx(*static_cast<MallocCtx*>(arg));
+
+    static int const window(16);
+    void*            bufs[window] = { 0, };
+    unsigned int     seed(reinterpret_cast<uintptr_t>(&seed));
+
+    for (int i(0); i < 20000; ++i)
+    {
+        void*& buf(bufs[i % window]);
+
+        if (0 != buf) ctx.gc_.free(buf);
+
+        int const size(16 + rand_r(&seed) % 2000);
+
+        buf = ctx.gc_.malloc(size);
+
+        if (0 == buf) { ++ctx.errors_; continue; }
+
+        memset(buf, i, size);
+    }
+
+    for (int i(0); i < window; ++i) if (0 != bufs[i]) ctx.gc_.free(bufs[i]);
+
+    return 0;
+}
+
+START_TEST(reclaim)
+{
+    gu::Config conf;
+    GCache::register_params(conf);
+    conf.set("gcache.name", rb_name);
+    conf.set("gcache.size", "8M");
+
+    unlink(rb_name.c_str());
+
+    {
+        GCache    gc(conf, "");
+        MallocCtx ctx(gc);
+
+        static int const threads(8);
+        pthread_t        thds[threads];
+
+        for (int t(0); t < threads; ++t)
+        {
+            pthread_create(&thds[t], NULL, malloc_user, &ctx);
+        }
+
+        for (int t(0); t < threads; ++t)
+        {
+            pthread_join(thds[t], NULL);
+        }
+
+        fail_if(ctx.errors_() != 0, "%ld failed allocations", ctx.errors_());
+
+        /* exited threads left their arenas holding ring buffer areas and
+         * pending frees, whole ring buffer must still be reclaimable
+         * without spilling to the page store */
+        for (int i(0); i < 8; ++i)
+        {
+            void* const buf(gc.malloc(rb_size / 2 - 4096));
+            fail_if(0 == buf, "iteration %d", i);
+
+            fail_if(ptr2BH(buf)->store != BUFFER_IN_RB,
+                    "iteration %d: buffer in store %d", i,
+                    int(ptr2BH(buf)->store));
+
+            gc.free(buf);
+        }
+    }
+
+    unlink(rb_name.c_str());
+}
+END_TEST
+
+Suite* gcache_malloc_suite()
+{
+    Suite* ts = suite_create("gcache::malloc");
+    TCase* tc = tcase_create("test");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, reclaim);
+    suite_add_tcase(ts, tc);
+
+    return ts;
+}
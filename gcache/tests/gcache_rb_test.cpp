@@ -8,6 +8,12 @@
 #include "gcache_bh.hpp"
 #include "gcache_rb_test.hpp"
 
+#include <gu_uuid.hpp>
+
+#include <vector>
+
+#include <unistd.h>
+
 using namespace gcache;
 
 START_TEST(test1)
@@ -16,7 +22,7 @@ START_TEST(test1)
     ssize_t const bh_size = sizeof(gcache::BufferHeader);
     ssize_t const rb_size (4 + 2*bh_size);
 
-    std::map<int64_t, const void*> s2p;
+    Seqno2Ptr s2p;
     RingBuffer rb(rb_name, rb_size, s2p);
 
     fail_if (rb.size() != rb_size, "Expected %zd, got %zd", rb_size, rb.size());
@@ -83,6 +89,156 @@ START_TEST(test1)
 }
 END_TEST
 
+START_TEST(carve)
+{
+    std::string const rb_name = "rb_test";
+    ssize_t const bh_size (sizeof(gcache::BufferHeader));
+    ssize_t const rb_size (4096);
+    ssize_t const area_size(1024);
+    ssize_t const buf_size (100);
+
+    Seqno2Ptr  s2p;
+    RingBuffer rb(rb_name, rb_size, s2p);
+
+    void* const area(rb.malloc(area_size));
+    fail_if (NULL == area);
+
+    BufferHeader* filler(ptr2BH(area));
+    std::vector<BufferHeader*> bufs;
+
+    for (BufferHeader* bh(RingBuffer::carve(filler, buf_size)); bh != 0;
+         bh = RingBuffer::carve(filler, buf_size))
+    {
+        fail_if (bh->size != buf_size);
+        fail_if (BH_next(bh) != filler);
+        fail_if (BH_is_released(bh));
+        fail_if (bh->seqno_g != SEQNO_NONE);
+        bufs.push_back(bh);
+    }
+
+    /* filler keeps room for its header */
+    fail_if (ssize_t(bufs.size()) != (area_size - bh_size) / buf_size,
+             "carved %zu buffers", bufs.size());
+    fail_if (filler->size != area_size - buf_size * ssize_t(bufs.size()));
+    fail_if (filler->store != BUFFER_IN_RB);
+    fail_if (BH_is_released(filler));
+
+    for (size_t i(0); i < bufs.size(); ++i)
+    {
+        BH_release(bufs[i]);
+        rb.free(bufs[i]);
+    }
+
+    BH_release(filler);
+    rb.free(filler);
+
+    /* all carved space must be reclaimed when the ring wraps around */
+    for (int i(0); i < 8; ++i)
+    {
+        void* const buf(rb.malloc(rb_size / 2));
+        fail_if (NULL == buf, "iteration %d", i);
+        BH_release(ptr2BH(buf));
+        rb.free(ptr2BH(buf));
+    }
+}
+END_TEST
+
+/* allocates, orders and releases buffer like GCache does */
+static void
+rb_put (RingBuffer& rb, Seqno2Ptr& s2p,
+        int64_t const seqno, ssize_t const size)
+{
+    void* const buf(rb.malloc(size + sizeof(BufferHeader)));
+    fail_if (NULL == buf);
+    memset (buf, seqno, size);
+
+    BufferHeader* const bh(ptr2BH(buf));
+    if (seqno > 0)
+    {
+        bh->seqno_g = seqno;
+        bh->seqno_d = seqno - 1;
+        s2p.insert(seqno, buf);
+    }
+
+    BH_release(bh);
+    rb.free(bh);
+}
+
+START_TEST(recovery)
+{
+    std::string const rb_name = "rb_recover";
+    ssize_t const rb_size (1 << 16);
+    ssize_t const buf_size(500);
+
+    gu_uuid_t gid;
+    gu_uuid_generate(&gid, 0, 0);
+
+    unlink(rb_name.c_str());
+
+    {
+        Seqno2Ptr s2p;
+        RingBuffer rb(rb_name, rb_size, s2p);
+        fail_if (!s2p.empty());
+
+        /* wrap the ring around and leave a gap in seqnos at 150 */
+        for (int64_t s(1); s <= 200; ++s)
+        {
+            rb_put (rb, s2p, 150 == s ? SEQNO_NONE : s, buf_size + s);
+        }
+
+        /* unreleased buffer at shutdown */
+        fail_if (NULL == rb.malloc(buf_size + sizeof(BufferHeader)));
+
+        rb.set_gid(gid);
+    }
+
+    {
+        Seqno2Ptr s2p;
+        RingBuffer rb(rb_name, rb_size, s2p);
+
+        fail_if (rb.gid() != gid);
+        fail_if (s2p.index_front() != 151);
+        fail_if (s2p.index_back() != 200);
+
+        for (int64_t s(151); s <= 200; ++s)
+        {
+            const void* const ptr(s2p.find(s));
+            fail_if (0 == ptr, "seqno %lld not recovered", (long long)s);
+
+            const BufferHeader* const bh(ptr2BH(ptr));
+            const uint8_t*      const data(static_cast<const uint8_t*>(ptr));
+
+            fail_if (bh->seqno_g != s);
+            fail_if (bh->seqno_d != s - 1);
+            fail_if (!BH_is_released(bh));
+            fail_if (bh->size != ssize_t(buf_size + s + sizeof(BufferHeader)));
+            fail_if (data[0] != uint8_t(s));
+            fail_if (data[buf_size + s - 1] != uint8_t(s));
+        }
+
+        /* recovered buffers get discarded as the ring turns over */
+        for (int64_t s(201); s <= 400; ++s)
+        {
+            rb_put (rb, s2p, s, buf_size + s % 200);
+        }
+
+        fail_if (s2p.index_front() <= 200);
+        fail_if (s2p.index_back() != 400);
+    }
+
+    {
+        /* changed file size invalidates contents */
+        Seqno2Ptr s2p;
+        RingBuffer rb(rb_name, 2 * rb_size, s2p);
+
+        fail_if (!s2p.empty());
+        fail_if (rb.gid() != GU_UUID_NIL);
+    }
+
+    unlink(rb_name.c_str());
+}
+END_TEST
+
 Suite* gcache_rb_suite()
 {
     Suite* ts = suite_create("gcache::RbStore");
@@ -90,6 +246,8 @@ Suite* gcache_rb_suite()
 
     tcase_set_timeout(tc, 60);
     tcase_add_test(tc, test1);
+    tcase_add_test(tc, carve);
+    tcase_add_test(tc, recovery);
     suite_add_tcase(ts, tc);
 
     return ts;
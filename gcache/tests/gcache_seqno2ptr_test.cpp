@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 Codership Oy <info@codership.com>
+ */
+
+#include "gcache_seqno2ptr.hpp"
+#include "gcache_seqno2ptr_test.hpp"
+
+using namespace gcache;
+
+START_TEST(test1)
+{
+    Seqno2Ptr s2p;
+    int       bufs[16];
+
+    fail_if (!s2p.empty());
+    fail_if (0 != s2p.find(1));
+
+    fail_if (!s2p.insert(5, &bufs[5]));
+    fail_if (s2p.index_front() != 5);
+    fail_if (s2p.index_back()  != 5);
+
+    /* dense append */
+    fail_if (!s2p.insert(6, &bufs[6]));
+    /* gap at the back */
+    fail_if (!s2p.insert(9, &bufs[9]));
+    /* gap at the front */
+    fail_if (!s2p.insert(2, &bufs[2]));
+
+    fail_if (s2p.index_front() != 2);
+    fail_if (s2p.index_back()  != 9);
+    fail_if (s2p.front() != &bufs[2]);
+    fail_if (s2p.back()  != &bufs[9]);
+
+    fail_if (0 != s2p.find(1));
+    fail_if (0 != s2p.find(3));
+    fail_if (0 != s2p.find(7));
+    fail_if (0 != s2p.find(10));
+    fail_if (s2p.find(6) != &bufs[6]);
+
+    /* fill the gap, duplicate is refused */
+    fail_if (!s2p.insert(3, &bufs[3]));
+    fail_if (s2p.insert(3, &bufs[4]));
+    fail_if (s2p.find(3) != &bufs[3]);
+
+    /* popping front skips the gap */
+    s2p.pop_front();
+    fail_if (s2p.index_front() != 3);
+    s2p.pop_front();
+    fail_if (s2p.index_front() != 5);
+
+    /* erasing back trims the gap */
+    s2p.erase(9);
+    fail_if (s2p.index_back() != 6);
+
+    s2p.erase(6);
+    s2p.erase(5);
+    fail_if (!s2p.empty());
+
+    fail_if (!s2p.insert(11, &bufs[11]));
+    fail_if (s2p.index_front() != 11);
+    fail_if (s2p.index_back()  != 11);
+
+    s2p.clear();
+    fail_if (!s2p.empty());
+}
+END_TEST
+
+Suite* gcache_seqno2ptr_suite()
+{
+    Suite* ts = suite_create("gcache::Seqno2Ptr");
+    TCase* tc = tcase_create("test");
+
+    tcase_add_test(tc, test1);
+    suite_add_tcase(ts, tc);
+
+    return ts;
+}
@@ -13,6 +13,8 @@
 #include "gcache_mem_test.hpp"
 #include "gcache_rb_test.hpp"
 #include "gcache_page_test.hpp"
+#include "gcache_seqno2ptr_test.hpp"
+#include "gcache_malloc_test.hpp"
 
 extern "C" {
 #include <check.h>
@@ -25,6 +27,8 @@ static suite_creator_t suites[] =
     gcache_mem_suite,
     gcache_rb_suite,
     gcache_page_suite,
+    gcache_seqno2ptr_suite,
+    gcache_malloc_suite,
     0
 };
 
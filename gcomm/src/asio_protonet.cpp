@@ -26,7 +26,11 @@ gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
     gcomm::Protonet(conf, "asio", version),
     mutex_(),
     poll_until_(gu::datetime::Date::max()),
+    socket_io_service_(),
+    socket_io_work_(0),
+    io_threads_(),
     io_service_(),
+    dispatch_strand_(io_service_),
     timer_(io_service_),
 #ifdef HAVE_ASIO_SSL_HPP
     ssl_context_(io_service_, asio::ssl::context::sslv23),
@@ -55,11 +59,81 @@ gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
         gu::ssl_prepare_context(conf_, ssl_context_);
     }
 #endif // HAVE_ASIO_SSL_HPP
+
+    const int io_threads(conf.get<int>(gcomm::Conf::SocketIoThreads, 0));
+    if (io_threads < 0)
+    {
+        gu_throw_error(EINVAL) << "invalid value " << io_threads
+                               << " for " << gcomm::Conf::SocketIoThreads;
+    }
+    conf.set(gcomm::Conf::SocketIoThreads, io_threads);
+
+    start_io_threads(io_threads);
 }
 
 gcomm::AsioProtonet::~AsioProtonet()
 {
+    stop_io_threads();
+}
+
+void* gcomm::AsioProtonet::run_io_thread(void* arg)
+{
+    AsioProtonet* const net(static_cast<AsioProtonet*>(arg));
+
+    while (true)
+    {
+        try
+        {
+            net->socket_io_service_.run();
+            break; // stopped
+        }
+        catch (std::exception& e)
+        {
+            log_error << "exception in socket I/O thread: " << e.what();
+        }
+    }
+
+    return 0;
+}
+
+void gcomm::AsioProtonet::start_io_threads(int n)
+{
+    if (n == 0) return;
+
+    // keeps threads running while there are no sockets
+    socket_io_work_ = new asio::io_service::work(socket_io_service_);
+
+    for (int i(0); i < n; ++i)
+    {
+        gu_thread_t thd;
+        int const err(gu_thread_create(&thd, 0, &run_io_thread, this));
+        if (err != 0)
+        {
+            stop_io_threads();
+            gu_throw_error(err) << "failed to start socket I/O thread";
+        }
+        io_threads_.push_back(thd);
+    }
+
+    log_info << "started " << n << " socket I/O threads";
+}
+
+void gcomm::AsioProtonet::stop_io_threads()
+{
+    delete socket_io_work_;
+    socket_io_work_ = 0;
 
+    if (io_threads_.empty()) return;
+
+    socket_io_service_.stop();
+
+    for (std::vector<gu_thread_t>::iterator i(io_threads_.begin());
+         i != io_threads_.end(); ++i)
+    {
+        gu_thread_join(*i, 0);
+    }
+
+    io_threads_.clear();
 }
 
 void gcomm::AsioProtonet::enter()
@@ -95,6 +169,18 @@ gcomm::Acceptor* gcomm::AsioProtonet::acceptor(const gu::URI& uri)
     return new AsioTcpAcceptor(*this, uri);
 }
 
+gcomm::NetHeader gcomm::AsioProtonet::net_header(const Datagram& dg) const
+{
+    NetHeader hdr(static_cast<uint32_t>(dg.len()), version_);
+
+    if (checksum_ != NetHeader::CS_NONE)
+    {
+        hdr.set_crc32(crc32(checksum_, dg), checksum_);
+    }
+
+    return hdr;
+}
+
 
 
 gu::datetime::Period handle_timers_helper(gcomm::Protonet&            pnet,
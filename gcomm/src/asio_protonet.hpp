@@ -36,6 +36,22 @@ public:
     void enter();
     void leave();
     size_t mtu() const { return mtu_; }
+    NetHeader net_header(const Datagram& dg) const;
+
+    //!
+    // Service which runs socket I/O handlers: either the event loop
+    // io_service or a separate one run by socket I/O threads.
+    //
+    asio::io_service& socket_io_service()
+    {
+        return (socket_io_threads() ? socket_io_service_ : io_service_);
+    }
+
+    //!
+    // Whether socket I/O handlers run in socket I/O threads. If not, they
+    // pass socket events to the protocol stack directly.
+    //
+    bool socket_io_threads() const { return (io_threads_.empty() == false); }
 
 #ifdef HAVE_ASIO_SSL_HPP
     std::string get_ssl_password() const;
@@ -50,9 +66,20 @@ private:
 
     void handle_wait(const asio::error_code& ec);
 
+    static void* run_io_thread(void* arg);
+    void start_io_threads(int n);
+    void stop_io_threads();
+
     gu::RecursiveMutex          mutex_;
     gu::datetime::Date          poll_until_;
+    // Declared before io_service_ so that sockets referenced by handlers
+    // pending in io_service_ are destroyed while their service still exists.
+    asio::io_service            socket_io_service_;
+    asio::io_service::work*     socket_io_work_;
+    std::vector<gu_thread_t>    io_threads_;
     asio::io_service            io_service_;
+    // Serializes socket events on their way to the protocol stack
+    asio::io_service::strand    dispatch_strand_;
     asio::deadline_timer        timer_;
 #ifdef HAVE_ASIO_SSL_HPP
     asio::ssl::context          ssl_context_;
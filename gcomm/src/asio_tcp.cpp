@@ -6,20 +6,63 @@
 #include "gcomm/util.hpp"
 #include "gcomm/common.hpp"
 
+#include <algorithm>
+
 
 #define FAILED_HANDLER(_e) failed_handler(_e, __FUNCTION__, __LINE__)
 
+// Receive buffer size in MTU sized messages. A single read may pick up
+// several messages which are then dispatched in one read_handler() call.
+static const size_t RecvBufMtus = 4;
+
+// Batches of received messages posted to the event loop per socket. Reading
+// from the socket pauses when this many are waiting to be dispatched and
+// resumes when the event loop has drained them.
+static const size_t RecvMaxBatches = 4;
+
+namespace
+{
+    // Without socket I/O threads socket handlers and calls from protocol
+    // stack are serialized by Protonet critical section, same way as the
+    // rest of the event loop. With them it is the socket strand and mutex
+    // which do that and critical section is entered only to dispatch.
+    class SocketCritical
+    {
+    public:
+        SocketCritical(gcomm::AsioProtonet& net)
+            :
+            net_    (net),
+            entered_(net.socket_io_threads() == false)
+        {
+            if (entered_ == true) net_.enter();
+        }
+
+        ~SocketCritical() { if (entered_ == true) net_.leave(); }
+
+    private:
+        SocketCritical(const SocketCritical&);
+        void operator=(const SocketCritical&);
+
+        gcomm::AsioProtonet& net_;
+        bool const           entered_;
+    };
+}
+
 gcomm::AsioTcpSocket::AsioTcpSocket(AsioProtonet& net, const gu::URI& uri)
     :
     Socket       (uri),
     net_         (net),
-    socket_      (net.io_service_),
+    socket_      (net.socket_io_service()),
+    strand_      (net.socket_io_service()),
+    mutex_       (),
 #ifdef HAVE_ASIO_SSL_HPP
     ssl_socket_  (0),
 #endif /* HAVE_ASIO_SSL_HPP */
     send_q_      (),
-    recv_buf_    (net_.mtu() + NetHeader::serial_size_),
+    recv_buf_    (RecvBufMtus*(net_.mtu() + NetHeader::serial_size_)),
     recv_offset_ (0),
+    recv_batches_(0),
+    recv_paused_ (false),
     state_       (S_CLOSED),
     local_addr_  (),
     remote_addr_ ()
@@ -52,19 +95,102 @@ void gcomm::AsioTcpSocket::failed_handler(const asio::error_code& ec,
                   << " remote endpoint " << remote_addr();
     } catch (...) { }
 
-    const State prev_state(state());
-
-    if (state() != S_CLOSED)
+    State prev_state;
     {
-        state_ = S_FAILED;
+        gu::Lock lock(mutex_);
+        prev_state = state_;
+        if (state_ != S_CLOSED)
+        {
+            state_ = S_FAILED;
+        }
     }
 
     if (prev_state != S_FAILED && prev_state != S_CLOSED)
     {
-        net_.dispatch(id(), Datagram(), ProtoUpMeta(ec.value()));
+        post_event(ec.value());
+    }
+}
+
+bool gcomm::AsioTcpSocket::post_recv(const DatagramsPtr& dgs)
+{
+    assert(net_.socket_io_threads() == true);
+
+    bool paused;
+    {
+        gu::Lock lock(mutex_);
+        ++recv_batches_;
+        paused = recv_paused_ = (recv_batches_ >= RecvMaxBatches);
+    }
+
+    net_.dispatch_strand_.post(boost::bind(&AsioTcpSocket::dispatch_recv,
+                                           shared_from_this(), dgs));
+    return (paused == false);
+}
+
+void gcomm::AsioTcpSocket::post_event(int err)
+{
+    if (net_.socket_io_threads() == true)
+    {
+        net_.dispatch_strand_.post(boost::bind(&AsioTcpSocket::dispatch_event,
+                                               shared_from_this(), err));
+    }
+    else
+    {
+        dispatch_event(err);
+    }
+}
+
+void gcomm::AsioTcpSocket::dispatch_recv(const DatagramsPtr& dgs)
+{
+    Critical<AsioProtonet> crit(net_);
+
+    for (std::vector<Datagram>::const_iterator i(dgs->begin());
+         i != dgs->end() && dispatch_dg(*i) == true; ++i) { }
+
+    bool resume(false);
+    {
+        gu::Lock lock(mutex_);
+        --recv_batches_;
+        if (recv_paused_ == true && recv_batches_ == 0)
+        {
+            recv_paused_ = false;
+            resume       = true;
+        }
+    }
+
+    if (resume == true)
+    {
+        strand_.post(boost::bind(&AsioTcpSocket::start_receive,
+                                 shared_from_this()));
     }
 }
 
+bool gcomm::AsioTcpSocket::dispatch_dg(const Datagram& dg)
+{
+    // protocol may close the socket while handling previous message
+    const State s(state());
+    if (s != S_CONNECTED && s != S_CLOSING)
+    {
+        log_debug << "dropping received messages for " << id()
+                  << " state " << s;
+        return false;
+    }
+    net_.dispatch(id(), dg, ProtoUpMeta());
+    return true;
+}
+
+void gcomm::AsioTcpSocket::dispatch_event(int err)
+{
+    Critical<AsioProtonet> crit(net_);
+
+    if (state() == S_CLOSED)
+    {
+        log_debug << "dropping event " << err << " for closed " << id();
+        return;
+    }
+    net_.dispatch(id(), Datagram(), ProtoUpMeta(err));
+}
+
 #ifdef HAVE_ASIO_SSL_HPP
 void gcomm::AsioTcpSocket::handshake_handler(const asio::error_code& ec)
 {
@@ -92,15 +218,15 @@ void gcomm::AsioTcpSocket::handshake_handler(const asio::error_code& ec)
              << " local endpoint " << local_addr()
              << " cipher: " << gu::cipher(*ssl_socket_)
              << " compression: " << gu::compression(*ssl_socket_);
-    state_ = S_CONNECTED;
-    net_.dispatch(id(), Datagram(), ProtoUpMeta(ec.value()));
-    async_receive();
+    set_state(S_CONNECTED);
+    post_event(ec.value());
+    start_receive();
 }
 #endif /* HAVE_ASIO_SSL_HPP */
 
 void gcomm::AsioTcpSocket::connect_handler(const asio::error_code& ec)
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
 
     try
     {
@@ -124,9 +250,10 @@ void gcomm::AsioTcpSocket::connect_handler(const asio::error_code& ec)
                           << local_addr();
                 ssl_socket_->async_handshake(
                     asio::ssl::stream<asio::ip::tcp::socket>::client,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                shared_from_this(),
-                                asio::placeholders::error)
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::handshake_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error))
                     );
             }
             else
@@ -137,9 +264,9 @@ void gcomm::AsioTcpSocket::connect_handler(const asio::error_code& ec)
                 log_debug << "socket " << id() << " connected, remote endpoint "
                           << remote_addr() << " local endpoint "
                           << local_addr();
-                state_ = S_CONNECTED;
-                net_.dispatch(id(), Datagram(), ProtoUpMeta(ec.value()));
-                async_receive();
+                set_state(S_CONNECTED);
+                post_event(ec.value());
+                start_receive();
 
 #ifdef HAVE_ASIO_SSL_HPP
             }
@@ -167,17 +294,21 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
                   asio::ip::tcp::resolver::query::flags(0));
         asio::ip::tcp::resolver::iterator i(resolver.resolve(query));
 
+        // connect handler may run in socket I/O thread as soon as
+        // connect is initiated
+        set_state(S_CONNECTING);
+
 #ifdef HAVE_ASIO_SSL_HPP
         if (uri.get_scheme() == gu::scheme::ssl)
         {
             ssl_socket_ = new asio::ssl::stream<asio::ip::tcp::socket>(
-                net_.io_service_, net_.ssl_context_
+                net_.socket_io_service(), net_.ssl_context_
             );
 
             ssl_socket_->lowest_layer().async_connect(
-                *i, boost::bind(&AsioTcpSocket::connect_handler,
-                                shared_from_this(),
-                                asio::placeholders::error)
+                *i, strand_.wrap(boost::bind(&AsioTcpSocket::connect_handler,
+                                             shared_from_this(),
+                                             asio::placeholders::error))
             );
         }
         else
@@ -192,13 +323,13 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
                     0);
                 socket_.bind(ep);
             }
-            socket_.async_connect(*i, boost::bind(&AsioTcpSocket::connect_handler,
+            socket_.async_connect(*i, strand_.wrap(
+                                      boost::bind(&AsioTcpSocket::connect_handler,
                                                   shared_from_this(),
-                                                  asio::placeholders::error));
+                                                  asio::placeholders::error)));
 #ifdef HAVE_ASIO_SSL_HPP
         }
 #endif /* HAVE_ASIO_SSL_HPP */
-        state_ = S_CONNECTING;
     }
     catch (asio::system_error& e)
     {
@@ -211,17 +342,28 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
 
 void gcomm::AsioTcpSocket::close()
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
 
-    if (state() == S_CLOSED || state() == S_CLOSING) return;
+    gu::Lock lock(mutex_);
 
-    log_debug << "closing " << id() << " state " << state()
+    if (state_ == S_CLOSED || state_ == S_CLOSING) return;
+
+    log_debug << "closing " << id() << " state " << state_
               << " send_q size " << send_q_.size();
 
-    if (send_q_.empty() == true || state() != S_CONNECTED)
+    if (send_q_.empty() == true || state_ != S_CONNECTED)
     {
-        close_socket();
         state_ = S_CLOSED;
+        if (net_.socket_io_threads() == true)
+        {
+            // socket may be in use by a handler running in socket I/O thread
+            strand_.post(boost::bind(&AsioTcpSocket::close_socket,
+                                     shared_from_this()));
+        }
+        else
+        {
+            close_socket();
+        }
     }
     else
     {
@@ -233,12 +375,14 @@ void gcomm::AsioTcpSocket::close()
 void gcomm::AsioTcpSocket::write_handler(const asio::error_code& ec,
                                          size_t bytes_transferred)
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
 
-    if (state() != S_CONNECTED && state() != S_CLOSING)
+    const State prev_state(state());
+
+    if (prev_state != S_CONNECTED && prev_state != S_CLOSING)
     {
         log_debug << "write handler for " << id()
-                  << " state " << state();
+                  << " state " << prev_state;
 #ifdef HAVE_ASIO_SSL_HPP
         if (ec.category() == asio::error::get_ssl_category())
         {
@@ -251,41 +395,46 @@ void gcomm::AsioTcpSocket::write_handler(const asio::error_code& ec,
 
     if (!ec)
     {
-        gcomm_assert(send_q_.empty() == false);
-        gcomm_assert(send_q_.front().len() >= bytes_transferred);
-
-        while (send_q_.empty() == false &&
-               bytes_transferred >= send_q_.front().len())
+        bool more;
+        bool closing(false);
         {
-            const Datagram& dg(send_q_.front());
-            bytes_transferred -= dg.len();
-            send_q_.pop_front();
+            gu::Lock lock(mutex_);
+
+            gcomm_assert(send_q_.empty() == false);
+            gcomm_assert(send_q_.front().len() <= bytes_transferred);
+
+            while (send_q_.empty() == false &&
+                   bytes_transferred >= send_q_.front().len())
+            {
+                const Datagram& dg(send_q_.front());
+                bytes_transferred -= dg.len();
+                send_q_.pop_front();
+            }
+            gcomm_assert(bytes_transferred == 0);
+
+            more = (send_q_.empty() == false);
+            if (more == false && state_ == S_CLOSING)
+            {
+                closing = true;
+                state_  = S_CLOSED;
+            }
         }
-        gcomm_assert(bytes_transferred == 0);
 
-        if (send_q_.empty() == false)
+        if (more == true)
         {
-            const Datagram& dg(send_q_.front());
-            boost::array<asio::const_buffer, 2> cbs;
-            cbs[0] = asio::const_buffer(dg.header()
-                                        + dg.header_offset(),
-                                        dg.header_len());
-            cbs[1] = asio::const_buffer(&dg.payload()[0],
-                                        dg.payload().size());
-            write_one(cbs);
+            write_send_q();
         }
-        else if (state_ == S_CLOSING)
+        else if (closing == true)
         {
             log_debug << "deferred close of " << id();
             close_socket();
-            state_ = S_CLOSED;
         }
     }
-    else if (state_ == S_CLOSING)
+    else if (prev_state == S_CLOSING)
     {
         log_debug << "deferred close of " << id() << " error " << ec;
         close_socket();
-        state_ = S_CLOSED;
+        set_state(S_CLOSED);
     }
     else
     {
@@ -296,21 +445,24 @@ void gcomm::AsioTcpSocket::write_handler(const asio::error_code& ec,
 
 int gcomm::AsioTcpSocket::send(const Datagram& dg)
 {
-    Critical<AsioProtonet> crit(net_);
+    return send(dg, net_.net_header(dg));
+}
 
-    if (state() != S_CONNECTED)
-    {
-        return ENOTCONN;
-    }
 
-    NetHeader hdr(static_cast<uint32_t>(dg.len()), net_.version_);
+int gcomm::AsioTcpSocket::send(const Datagram& dg, const NetHeader& hdr)
+{
+    SocketCritical crit(net_);
+
+    gu::Lock lock(mutex_);
 
-    if (net_.checksum_ != NetHeader::CS_NONE)
+    if (state_ != S_CONNECTED)
     {
-        hdr.set_crc32(crc32(net_.checksum_, dg), net_.checksum_);
+        return ENOTCONN;
     }
 
-    send_q_.push_back(dg); // makes copy of dg
+    assert(hdr.len() == dg.len());
+
+    send_q_.push_back(dg); // copies dg header, payload is shared
     Datagram& priv_dg(send_q_.back());
 
     priv_dg.set_header_offset(priv_dg.header_offset() -
@@ -322,13 +474,15 @@ int gcomm::AsioTcpSocket::send(const Datagram& dg)
 
     if (send_q_.size() == 1)
     {
-        boost::array<asio::const_buffer, 2> cbs;
-        cbs[0] = asio::const_buffer(priv_dg.header()
-                                    + priv_dg.header_offset(),
-                                    priv_dg.header_len());
-        cbs[1] = asio::const_buffer(&priv_dg.payload()[0],
-                                    priv_dg.payload().size());
-        write_one(cbs);
+        if (net_.socket_io_threads() == true)
+        {
+            strand_.post(boost::bind(&AsioTcpSocket::write_send_q,
+                                     shared_from_this()));
+        }
+        else
+        {
+            start_write();
+        }
     }
     return 0;
 }
@@ -337,7 +491,7 @@ int gcomm::AsioTcpSocket::send(const Datagram& dg)
 void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
                                         const size_t bytes_transferred)
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
 
     if (ec)
     {
@@ -352,85 +506,112 @@ void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
         return;
     }
 
-    if (state() != S_CONNECTED && state() != S_CLOSING)
+    const State s(state());
+    if (s != S_CONNECTED && s != S_CLOSING)
     {
         log_debug << "read handler for " << id()
-                  << " state " << state();
+                  << " state " << s;
         return;
     }
 
     recv_offset_ += bytes_transferred;
 
-    while (recv_offset_ >= NetHeader::serial_size_)
+    // Pass all complete messages in the buffer to the protocol stack in the
+    // order they were received and move the incomplete tail to the front
+    // only once they are all done. Without socket I/O threads they are
+    // dispatched right here, otherwise collected in one batch for the
+    // dispatch strand.
+    const bool   batch(net_.socket_io_threads());
+    DatagramsPtr dgs(batch == true ? new std::vector<Datagram>() : 0);
+    size_t       begin(0);
+
+    while (recv_offset_ - begin >= NetHeader::serial_size_)
     {
         NetHeader hdr;
         try
         {
-            unserialize(&recv_buf_[0], recv_buf_.size(), 0, hdr);
+            unserialize(&recv_buf_[0], recv_buf_.size(), begin, hdr);
         }
         catch (gu::Exception& e)
         {
+            if (batch == true && dgs->empty() == false) (void)post_recv(dgs);
             FAILED_HANDLER(asio::error_code(e.get_errno(),
                                             asio::error::system_category));
             return;
         }
-        if (recv_offset_ >= hdr.len() + NetHeader::serial_size_)
+
+        const size_t msg_len(NetHeader::serial_size_ + hdr.len());
+
+        if (recv_offset_ - begin < msg_len)
+        {
+            break;
+        }
+
+        const gu::byte_t* const pl(&recv_buf_[0] + begin
+                                   + NetHeader::serial_size_);
+        Datagram dg(gu::SharedBuffer(new gu::Buffer(pl, pl + hdr.len())));
+
+        if (net_.checksum_ != NetHeader::CS_NONE)
         {
-            Datagram dg(
-                gu::SharedBuffer(
-                    new gu::Buffer(&recv_buf_[0] + NetHeader::serial_size_,
-                                   &recv_buf_[0] + NetHeader::serial_size_
-                                   + hdr.len())));
-            if (net_.checksum_ != NetHeader::CS_NONE)
-            {
 #ifdef TEST_NET_CHECKSUM_ERROR
-                long rnd(rand());
-                if (rnd % 10000 == 0)
-                {
-                    hdr.set_crc32(net_.checksum_, static_cast<uint32_t>(rnd));
-                }
+            long rnd(rand());
+            if (rnd % 10000 == 0)
+            {
+                hdr.set_crc32(net_.checksum_, static_cast<uint32_t>(rnd));
+            }
 #endif /* TEST_NET_CHECKSUM_ERROR */
 
-                if (check_cs (hdr, dg))
+            if (check_cs (hdr, dg))
+            {
+                log_warn << "checksum failed, hdr: len=" << hdr.len()
+                         << " has_crc32="  << hdr.has_crc32()
+                         << " has_crc32c=" << hdr.has_crc32c()
+                         << " crc32=" << hdr.crc32();
+                if (batch == true && dgs->empty() == false)
                 {
-                    log_warn << "checksum failed, hdr: len=" << hdr.len()
-                             << " has_crc32="  << hdr.has_crc32()
-                             << " has_crc32c=" << hdr.has_crc32c()
-                             << " crc32=" << hdr.crc32();
-                    FAILED_HANDLER(asio::error_code(
-                                       EPROTO,
-                                       asio::error::system_category));
-                    return;
+                    (void)post_recv(dgs);
                 }
+                FAILED_HANDLER(asio::error_code(
+                                   EPROTO,
+                                   asio::error::system_category));
+                return;
             }
-            ProtoUpMeta um;
-            net_.dispatch(id(), dg, um);
-            recv_offset_ -= NetHeader::serial_size_ + hdr.len();
+        }
+        begin += msg_len;
 
-            if (recv_offset_ > 0)
-            {
-                memmove(&recv_buf_[0],
-                        &recv_buf_[0] + NetHeader::serial_size_ + hdr.len(),
-                        recv_offset_);
-            }
+        if (batch == true)
+        {
+            dgs->push_back(dg);
         }
-        else
+        else if (dispatch_dg(dg) == false)
         {
-            break;
+            return;
         }
     }
 
-    boost::array<asio::mutable_buffer, 1> mbs;
-    mbs[0] = asio::mutable_buffer(&recv_buf_[0] + recv_offset_,
-                                  recv_buf_.size() - recv_offset_);
-    read_one(mbs);
+    if (begin > 0)
+    {
+        recv_offset_ -= begin;
+
+        if (recv_offset_ > 0)
+        {
+            memmove(&recv_buf_[0], &recv_buf_[0] + begin, recv_offset_);
+        }
+    }
+
+    // the last batch to drain re-arms the read if there are too many
+    if (batch == false || dgs->empty() == true || post_recv(dgs) == true)
+    {
+        start_receive();
+    }
 }
 
 size_t gcomm::AsioTcpSocket::read_completion_condition(
     const asio::error_code& ec,
     const size_t bytes_transferred)
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
+
     if (ec)
     {
 #ifdef HAVE_ASIO_SSL_HPP
@@ -444,10 +625,11 @@ size_t gcomm::AsioTcpSocket::read_completion_condition(
         return 0;
     }
 
-    if (state() != S_CONNECTED && state() != S_CLOSING)
+    const State s(state());
+    if (s != S_CONNECTED && s != S_CLOSING)
     {
         log_debug << "read completion condition for " << id()
-                  << " state " << state();
+                  << " state " << s;
         return 0;
     }
 
@@ -477,13 +659,35 @@ size_t gcomm::AsioTcpSocket::read_completion_condition(
 
 void gcomm::AsioTcpSocket::async_receive()
 {
-    Critical<AsioProtonet> crit(net_);
+    SocketCritical crit(net_);
 
     gcomm_assert(state() == S_CONNECTED);
 
+    if (net_.socket_io_threads() == true)
+    {
+        strand_.post(boost::bind(&AsioTcpSocket::start_receive,
+                                 shared_from_this()));
+    }
+    else
+    {
+        start_receive();
+    }
+}
+
+void gcomm::AsioTcpSocket::start_receive()
+{
+    const State s(state());
+    if (s != S_CONNECTED && s != S_CLOSING)
+    {
+        log_debug << "not starting receive for " << id()
+                  << " state " << s;
+        return;
+    }
+
     boost::array<asio::mutable_buffer, 1> mbs;
 
-    mbs[0] = asio::mutable_buffer(&recv_buf_[0], recv_buf_.size());
+    mbs[0] = asio::mutable_buffer(&recv_buf_[0] + recv_offset_,
+                                  recv_buf_.size() - recv_offset_);
     read_one(mbs);
 }
 
@@ -515,10 +719,11 @@ void gcomm::AsioTcpSocket::read_one(boost::array<asio::mutable_buffer, 1>& mbs)
                                shared_from_this(),
                                asio::placeholders::error,
                                asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
     }
     else
     {
@@ -528,36 +733,80 @@ void gcomm::AsioTcpSocket::read_one(boost::array<asio::mutable_buffer, 1>& mbs)
                                shared_from_this(),
                                asio::placeholders::error,
                                asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
 #ifdef HAVE_ASIO_SSL_HPP
     }
 #endif /* HAVE_ASIO_SSL_HPP */
 }
 
 
-void gcomm::AsioTcpSocket::write_one(
-    const boost::array<asio::const_buffer, 2>& cbs)
+// Limits for coalescing queued datagrams into a single write. Asio passes
+// at most 64 buffers to one writev() call, each datagram takes two.
+static const size_t WriteMaxBuffers = 64;
+static const size_t WriteMaxBytes   = 1 << 17;
+
+void gcomm::AsioTcpSocket::write_send_q()
+{
+    gu::Lock lock(mutex_);
+
+    if (state_ != S_CONNECTED && state_ != S_CLOSING)
+    {
+        log_debug << "write send_q for " << id() << " state " << state_;
+        return;
+    }
+
+    start_write();
+}
+
+void gcomm::AsioTcpSocket::start_write()
 {
+    gcomm_assert(send_q_.empty() == false);
+
+    // Datagrams stay in send_q_ until write_handler() pops them, deque
+    // push_back() done meanwhile does not move them.
+    std::vector<asio::const_buffer> cbs;
+    cbs.reserve(std::min(WriteMaxBuffers, 2*send_q_.size()));
+
+    size_t bytes(0);
+    for (std::deque<Datagram>::const_iterator i(send_q_.begin());
+         i != send_q_.end() && cbs.size() + 2 <= WriteMaxBuffers &&
+             (bytes == 0 || bytes + i->len() <= WriteMaxBytes);
+         ++i)
+    {
+        const Datagram& dg(*i);
+        cbs.push_back(asio::const_buffer(dg.header() + dg.header_offset(),
+                                         dg.header_len()));
+        if (dg.payload().empty() == false)
+        {
+            cbs.push_back(asio::const_buffer(&dg.payload()[0],
+                                             dg.payload().size()));
+        }
+        bytes += dg.len();
+    }
+
 #ifdef HAVE_ASIO_SSL_HPP
     if (ssl_socket_ != 0)
     {
         async_write(*ssl_socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
     }
     else
     {
 #endif /* HAVE_ASIO_SSL_HPP */
         async_write(socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
 #ifdef HAVE_ASIO_SSL_HPP
     }
 #endif /* HAVE_ASIO_SSL_HPP */
@@ -678,19 +927,20 @@ void gcomm::AsioTcpAcceptor::accept_handler(
                           << s->id() << " connected, remote endpoint "
                           << s->remote_addr() << " local endpoint "
                           << s->local_addr();
+                s->set_state(Socket::S_CONNECTING);
                 s->ssl_socket_->async_handshake(
                     asio::ssl::stream<asio::ip::tcp::socket>::server,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                s->shared_from_this(),
-                                asio::placeholders::error));
-                s->state_ = Socket::S_CONNECTING;
+                    s->strand_.wrap(
+                        boost::bind(&AsioTcpSocket::handshake_handler,
+                                    s->shared_from_this(),
+                                    asio::placeholders::error)));
             }
             else
             {
 #endif /* HAVE_ASIO_SSL_HP */
                 s->socket_.set_option(asio::ip::tcp::no_delay(true));
                 gu::set_fd_options(s->socket_);
-                s->state_ = Socket::S_CONNECTED;
+                s->set_state(Socket::S_CONNECTED);
 #ifdef HAVE_ASIO_SSL_HPP
             }
 #endif /* HAVE_ASIO_SSL_HPP */
@@ -710,7 +960,7 @@ void gcomm::AsioTcpAcceptor::accept_handler(
         {
             new_socket->ssl_socket_ =
                 new asio::ssl::stream<asio::ip::tcp::socket>(
-                    net_.io_service_, net_.ssl_context_);
+                    net_.socket_io_service(), net_.ssl_context_);
             acceptor_.async_accept(new_socket->ssl_socket_->lowest_layer(),
                                    boost::bind(&AsioTcpAcceptor::accept_handler,
                                                this,
@@ -758,7 +1008,7 @@ void gcomm::AsioTcpAcceptor::listen(const gu::URI& uri)
         {
             new_socket->ssl_socket_ =
                 new asio::ssl::stream<asio::ip::tcp::socket>(
-                    net_.io_service_, net_.ssl_context_);
+                    net_.socket_io_service(), net_.ssl_context_);
             acceptor_.async_accept(new_socket->ssl_socket_->lowest_layer(),
                                    boost::bind(&AsioTcpAcceptor::accept_handler,
                                                this,
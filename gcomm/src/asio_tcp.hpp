@@ -8,8 +8,11 @@
 #include "socket.hpp"
 #include "asio_protonet.hpp"
 
+#include "gu_lock.hpp"
+
 #include <boost/bind.hpp>
 #include <boost/array.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <vector>
 #include <deque>
@@ -21,6 +24,16 @@ namespace gcomm
 }
 
 // TCP Socket implementation
+//
+// Socket I/O handlers may run in socket I/O threads (see
+// Conf::SocketIoThreads), they are serialized by the per socket strand.
+// Received messages and socket events are then passed to the protocol
+// stack by handlers posted to AsioProtonet dispatch strand, which run in
+// the event loop thread in Protonet critical section. Without socket I/O
+// threads handlers run in the event loop thread and pass them directly.
+// Socket state, send queue and received batch count are protected by the
+// socket mutex which must never be held while entering Protonet critical
+// section.
 
 class gcomm::AsioTcpSocket :
     public gcomm::Socket,
@@ -39,6 +52,7 @@ public:
     void write_handler(const asio::error_code& ec,
                        size_t bytes_transferred);
     int send(const Datagram& dg);
+    int send(const Datagram& dg, const NetHeader& hdr);
     size_t read_completion_condition(
         const asio::error_code& ec,
         const size_t bytes_transferred);
@@ -48,18 +62,38 @@ public:
     size_t mtu() const;
     std::string local_addr() const;
     std::string remote_addr() const;
-    State state() const { return state_; }
+    State state() const { gu::Lock lock(mutex_); return state_; }
     SocketId id() const { return &socket_; }
 private:
     friend class gcomm::AsioTcpAcceptor;
 
+    typedef boost::shared_ptr<std::vector<Datagram> > DatagramsPtr;
+
     AsioTcpSocket(const AsioTcpSocket&);
     void operator=(const AsioTcpSocket&);
 
+    void set_state(State state) { gu::Lock lock(mutex_); state_ = state; }
+    void start_receive();
     void read_one(boost::array<asio::mutable_buffer, 1>& mbs);
-    void write_one(const boost::array<asio::const_buffer, 2>& cbs);
+    // write out as many queued datagrams as fit in one scatter-gather
+    // write, must be called only when there is no write in progress
+    void write_send_q();
+    // same as write_send_q(), must be called with mutex_ locked
+    void start_write();
     void close_socket();
 
+    // pass received datagrams and socket events to the protocol stack,
+    // post_recv() hands a batch over to the dispatch strand and is used
+    // only with socket I/O threads, it returns false if reading must pause
+    // until the posted batches are dispatched
+    bool post_recv(const DatagramsPtr& dgs);
+    void post_event(int err);
+    void dispatch_recv(const DatagramsPtr& dgs);
+    void dispatch_event(int err);
+    // must be called in Protonet critical section, returns false if the
+    // socket is not connected anymore and the message was dropped
+    bool dispatch_dg(const Datagram& dg);
+
     // call to assign local/remote addresses at the point where it
     // is known that underlying socket is live
     void assign_local_addr();
@@ -67,12 +101,16 @@ private:
 
     AsioProtonet&                             net_;
     asio::ip::tcp::socket                     socket_;
+    asio::io_service::strand                  strand_;
+    gu::Mutex                                 mutex_;
 #ifdef HAVE_ASIO_SSL_HPP
     asio::ssl::stream<asio::ip::tcp::socket>* ssl_socket_;
 #endif // HAVE_ASIO_SSL_HPP
     std::deque<Datagram>                      send_q_;
     std::vector<gu::byte_t>                   recv_buf_;
     size_t                                    recv_offset_;
+    size_t                                    recv_batches_; // not dispatched
+    bool                                      recv_paused_;
     State                                     state_;
     // Querying addresses from failed socket does not work,
     // so need to maintain copy for diagnostics logging
@@ -132,15 +132,16 @@ void gcomm::AsioUdpSocket::close()
 }
 
 int gcomm::AsioUdpSocket::send(const Datagram& dg)
+{
+    return send(dg, net_.net_header(dg));
+}
+
+int gcomm::AsioUdpSocket::send(const Datagram& dg, const NetHeader& hdr)
 {
     Critical<AsioProtonet> crit(net_);
     boost::array<asio::const_buffer, 3> cbs;
-    NetHeader hdr(dg.len(), net_.version_);
 
-    if (net_.checksum_ != NetHeader::CS_NONE)
-    {
-        hdr.set_crc32(crc32(net_.checksum_, dg), net_.checksum_);
-    }
+    assert(hdr.len() == dg.len());
 
     gu::byte_t buf[NetHeader::serial_size_];
     serialize(hdr, buf, sizeof(buf), 0);
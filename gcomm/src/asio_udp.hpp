@@ -26,6 +26,7 @@ public:
     void connect(const gu::URI& uri);
     void close();
     int send(const Datagram& dg);
+    int send(const Datagram& dg, const NetHeader& hdr);
     void read_handler(const asio::error_code&, size_t);
     void async_receive();
     size_t mtu() const;
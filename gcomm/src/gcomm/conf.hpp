@@ -63,6 +63,16 @@ namespace gcomm
          */
         static std::string const SocketChecksum;
 
+        /*!
+         * @brief Number of threads for socket I/O ("socket.io_threads")
+         *
+         * If non-zero, TCP socket reads, writes, message framing and
+         * checksum verification are done by that many threads and
+         * received messages are passed to the protocol stack through
+         * a queue. 0 - all socket I/O is done by the event loop thread.
+         */
+        static std::string const SocketIoThreads;
+
         /*!
          * @brief GMCast scheme for transport URI ("gmcast")
          */
@@ -124,6 +124,15 @@ public:
 
     virtual size_t mtu() const = 0;
 
+    //!
+    // Network header for datagram, including checksum if it is enabled
+    //
+    // @param dg Datagram to be sent
+    //
+    // @return Header to pass to Socket::send()
+    //
+    virtual NetHeader net_header(const Datagram& dg) const = 0;
+
 protected:
 
     std::deque<Protostack*> protos_;
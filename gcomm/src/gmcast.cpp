@@ -1204,10 +1204,11 @@ gu::datetime::Date gcomm::GMCast::handle_timers()
 }
 
 
-void send(gcomm::Socket* s, gcomm::Datagram& dg)
+void send(gcomm::Socket* s, const gcomm::Datagram& dg,
+          const gcomm::NetHeader& hdr)
 {
     int err;
-    if ((err = s->send(dg)) != 0)
+    if ((err = s->send(dg, hdr)) != 0)
     {
         log_debug << "failed to send to " << s->remote_addr()
                   << ": (" << err << ") " << strerror(err);
@@ -1231,6 +1232,7 @@ void gcomm::GMCast::relay(const Message& msg,
     if (msg.flags() & Message::F_RELAY)
     {
         gu_trace(push_header(relay_msg, relay_dg));
+        const NetHeader hdr(pnet().net_header(relay_dg));
         for (SegmentMap::iterator i(segment_map_.begin());
              i != segment_map_.end(); ++i)
         {
@@ -1239,7 +1241,7 @@ void gcomm::GMCast::relay(const Message& msg,
             {
                 if ((*j)->id() != exclude_id)
                 {
-                    send(*j, relay_dg);
+                    send(*j, relay_dg, hdr);
                 }
             }
         }
@@ -1252,10 +1254,11 @@ void gcomm::GMCast::relay(const Message& msg,
             // nodes in local segment that are not directly reachable
             relay_msg.set_flags(relay_msg.flags() | Message::F_RELAY);
             gu_trace(push_header(relay_msg, relay_dg));
+            const NetHeader hdr(pnet().net_header(relay_dg));
             for (std::set<Socket*>::iterator ri(relay_set_.begin());
                  ri != relay_set_.end(); ++ri)
             {
-                send(*ri, relay_dg);
+                send(*ri, relay_dg, hdr);
             }
             gu_trace(pop_header(relay_msg, relay_dg));
             relay_msg.set_flags(relay_msg.flags() & ~Message::F_RELAY);
@@ -1269,10 +1272,11 @@ void gcomm::GMCast::relay(const Message& msg,
 
         // Relay to local segment
         gu_trace(push_header(relay_msg, relay_dg));
+        const NetHeader hdr(pnet().net_header(relay_dg));
         Segment& segment(segment_map_[segment_]);
         for (Segment::iterator i(segment.begin()); i != segment.end(); ++i)
         {
-            send(*i, relay_dg);
+            send(*i, relay_dg, hdr);
         }
     }
     else
@@ -1453,10 +1457,11 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
     {
         msg.set_flags(msg.flags() | Message::F_RELAY);
         gu_trace(push_header(msg, dg));
+        const NetHeader hdr(pnet().net_header(dg));
         for (std::set<Socket*>::iterator ri(relay_set_.begin());
              ri != relay_set_.end(); ++ri)
         {
-            send(*ri, dg);
+            send(*ri, dg, hdr);
         }
         gu_trace(pop_header(msg, dg));
         msg.set_flags(msg.flags() & ~Message::F_RELAY);
@@ -1479,7 +1484,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
                 relay_set_.find(segment[target_idx]) == relay_set_.end())
             {
                 gu_trace(push_header(msg, dg));
-                send(segment[target_idx], dg);
+                send(segment[target_idx], dg, pnet().net_header(dg));
                 gu_trace(pop_header(msg, dg));
             }
         }
@@ -1487,6 +1492,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
         {
             msg.set_flags(msg.flags() & ~Message::F_SEGMENT_RELAY);
             gu_trace(push_header(msg, dg));
+            const NetHeader hdr(pnet().net_header(dg));
             for (Segment::iterator i(segment.begin());
                  i != segment.end(); ++i)
             {
@@ -1494,7 +1500,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
                 if (relay_set_.empty() == true ||
                     relay_set_.find(*i) == relay_set_.end())
                 {
-                    send(*i, dg);
+                    send(*i, dg, hdr);
                 }
             }
             gu_trace(pop_header(msg, dg));
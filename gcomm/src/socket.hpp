@@ -57,6 +57,13 @@ public:
     virtual void close() = 0;
 
     virtual int send(const Datagram& dg) = 0;
+
+    //!
+    // Send datagram with network header prepared by Protonet::net_header()
+    // for the same datagram. Allows to compute checksum only once when
+    // the datagram is sent to several sockets.
+    //
+    virtual int send(const Datagram& dg, const NetHeader& hdr) = 0;
     virtual void async_receive() = 0;
 
     virtual size_t mtu() const = 0;
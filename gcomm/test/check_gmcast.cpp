@@ -46,7 +46,7 @@ START_TEST(test_gmcast_multicast)
 END_TEST
 
 
-START_TEST(test_gmcast_w_user_messages)
+namespace
 {
     class User : public Toplay
     {
@@ -154,11 +154,15 @@ START_TEST(test_gmcast_w_user_messages)
             return tp_->listen_addr();
         }
     };
+}
 
+static void gmcast_w_user_messages(int const io_threads)
+{
     log_info << "START";
     gu::Config conf;
     gu::ssl_register_params(conf);
     gcomm::Conf::register_params(conf);
+    conf.set(gcomm::Conf::SocketIoThreads, io_threads);
     mark_point();
     auto_ptr<Protonet> pnet(Protonet::create(conf));
     mark_point();
@@ -250,7 +254,19 @@ START_TEST(test_gmcast_w_user_messages)
     u4.stop();
 
     pnet->event_loop(0);
+}
+
+START_TEST(test_gmcast_w_user_messages)
+{
+    gmcast_w_user_messages(0);
+}
+END_TEST
 
+
+// socket I/O and message framing in separate threads
+START_TEST(test_gmcast_w_user_messages_io_threads)
+{
+    gmcast_w_user_messages(2);
 }
 END_TEST
 
@@ -435,6 +451,11 @@ Suite* gmcast_suite()
     tcase_set_timeout(tc, 30);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_gmcast_w_user_messages_io_threads");
+    tcase_add_test(tc, test_gmcast_w_user_messages_io_threads);
+    tcase_set_timeout(tc, 30);
+    suite_add_tcase(s, tc);
+
     if (run_all_tests == true)
     {
         // not run by default, hard coded port
@@ -96,10 +96,20 @@ static bool const GCS_FC_CONT = false;
 struct gcs_fc_event
 {
     uint32_t conf_id; // least significant part of configuraiton seqno
-    uint32_t stop;    // boolean value
+    uint32_t stop;    // 0 - CONT, 1 - STOP, N > 1 - STOP, but replication
+                      // can go on at N - 1 actions/s (rate-based FC)
 }
 __attribute__((__packed__));
 
+/* Upper bound on the rate advertised in FC_STOP (actions/s) */
+static uint32_t const GCS_FC_RATE_MAX = 1 << 30;
+
+/* Longest interval between sends before pacing degrades into pause */
+static long long const GCS_FC_PACE_MAX = 100000000LL; // 0.1s
+
+/* How often a stopped node re-evaluates its advertised rate */
+static long long const GCS_FC_ADVERTISE = 200000000LL; // 0.2s
+
 struct gcs_conn
 {
     long  my_idx;
@@ -146,6 +156,14 @@ struct gcs_conn
     long         stats_fc_sent;       // FC stats counters
     long         stats_fc_received;   //
     gcs_fc_t     stfc; // state transfer FC object
+    gcs_fc_meter_t fc_meter;          // slave queue processing rate
+    gcs_fc_pacer_t fc_pacer;          // paces replication in rate-based FC
+    gcs_fc_rates_t fc_rates;          // rates advertised by members
+    double       fc_min_rate;         // slowest rate advertised with STOPs
+    uint32_t     fc_stop;             // value of the FC_STOP being sent
+    long long    fc_advertised;       // when fc_stop was last evaluated
+    bool         fc_paused;           // sm paused by rate-based FC
+    bool         stop_hard;           // sent STOP does not advertise rate
 
     /* #603, #606 join control */
     bool        volatile need_to_join;
@@ -175,10 +193,14 @@ struct gcs_repl_act
     struct gcs_action*   action;
     gu_mutex_t           wait_mutex;
     gu_cond_t            wait_cond;
+    long                 send_ret; // set if sent by another thread and failed
+    bool                 collected;// set if taken over by another thread
     gcs_repl_act(const struct gu_buf* a_act_in, struct gcs_action* a_action)
       :
         act_in(a_act_in),
-        action(a_action)
+        action(a_action),
+        send_ret(0),
+        collected(false)
     { }
 };
 
@@ -223,6 +245,13 @@ enomem:
     return rc;
 }
 
+static void
+_set_core_compress (gcs_conn_t* conn)
+{
+    gcs_core_set_compress (conn->core, conn->params.compress ?
+                           conn->params.compress_min_size : 0);
+}
+
 /* Creates a group connection handle */
 gcs_conn_t*
 gcs_create (gu_config_t* const conf, gcache_t* const gcache,
@@ -257,6 +286,8 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
         goto core_create_failed;
     }
 
+    _set_core_compress (conn);
+
     conn->repl_q = gcs_fifo_lite_create (GCS_MAX_REPL_THREADS,
                                          sizeof (struct gcs_repl_act*));
     if (!conn->repl_q) {
@@ -287,6 +318,10 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
     conn->local_act_id = GCS_SEQNO_FIRST;
     conn->global_seqno = 0;
     conn->fc_offset    = 0;
+    conn->fc_min_rate  = 0.0;
+    conn->fc_advertised= 0;
+    conn->fc_paused    = false;
+    conn->stop_hard    = false;
     conn->timeout      = GU_TIME_ETERNITY;
     conn->gcache       = gcache;
     conn->max_fc_state = conn->params.sync_donor ?
@@ -294,6 +329,10 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
 
     gu_mutex_init (&conn->fc_lock, NULL);
 
+    gcs_fc_meter_init (&conn->fc_meter, gu_time_monotonic());
+    gcs_fc_pacer_init (&conn->fc_pacer, gu_time_monotonic());
+    gcs_fc_rates_init (&conn->fc_rates);
+
     return conn; // success
 
 sm_create_failed:
@@ -365,19 +404,43 @@ gcs_check_error (long err, const char* warning)
 }
 
 static inline long
-gcs_send_fc_event (gcs_conn_t* conn, bool stop)
+gcs_send_fc_event (gcs_conn_t* conn, uint32_t stop)
 {
-    struct gcs_fc_event fc  = { htogl(conn->conf_id), stop };
+    struct gcs_fc_event fc  = { htogl(conn->conf_id), htogl(stop) };
     return gcs_core_send_fc (conn->core, &fc, sizeof(fc));
 }
 
+/* Rate-based FC: value of FC_STOP which advertises the rate this node can
+ * still accept actions at. To be called under slave queue lock. */
+static inline uint32_t
+gcs_fc_rate_stop (gcs_conn_t* conn)
+{
+    if (!conn->params.fc_rate) return GCS_FC_STOP;
+
+    double const rate(gcs_fc_meter_rate (&conn->fc_meter,
+                                         gu_time_monotonic()));
+    double const accept(gcs_fc_drain_rate (rate, conn->queue_len,
+                                           conn->lower_limit +
+                                           conn->fc_offset));
+
+    gu_debug ("FC: processing rate: %.1f/s, queue drain ETA: %.3fs, "
+              "advertised rate: %.1f/s", rate,
+              rate > 0.0 ? conn->queue_len / rate : -1.0, accept);
+
+    if (accept < 1.0) return GCS_FC_STOP;
+
+    return (accept < GCS_FC_RATE_MAX ? uint32_t(accept) : GCS_FC_RATE_MAX) + 1;
+}
+
 /* To be called under slave queue lock. Returns true if FC_STOP must be sent */
 static inline bool
 gcs_fc_stop_begin (gcs_conn_t* conn)
 {
     long err = 0;
 
-    bool ret = (conn->stop_count <= 0                                     &&
+    /* in rate-based FC others may still be replicating despite STOPs from
+     * other members, so slave queue can grow further */
+    bool ret = ((conn->stop_count <= 0 || conn->params.fc_rate)          &&
                 conn->stop_sent  <= 0                                     &&
                 conn->queue_len  >  (conn->upper_limit + conn->fc_offset) &&
                 conn->state      <= conn->max_fc_state                    &&
@@ -388,6 +451,12 @@ gcs_fc_stop_begin (gcs_conn_t* conn)
             abort();
     }
 
+    if (ret) {
+        conn->fc_stop       = gcs_fc_rate_stop (conn);
+        conn->stop_hard     = (GCS_FC_STOP == conn->fc_stop);
+        conn->fc_advertised = gu_time_monotonic();
+    }
+
     conn->stop_sent += ret;
 
     return ret;
@@ -397,12 +466,12 @@ gcs_fc_stop_begin (gcs_conn_t* conn)
 static inline long
 gcs_fc_stop_end (gcs_conn_t* conn)
 {
-    long ret;
+    long ret = 0;
 
     gu_debug ("SENDING FC_STOP (local seqno: %lld, fc_offset: %ld)",
               conn->local_act_id, conn->fc_offset);
 
-    ret = gcs_send_fc_event (conn, GCS_FC_STOP);
+    ret = gcs_send_fc_event (conn, conn->fc_stop);
 
     if (ret >= 0) {
         ret = 0;
@@ -410,6 +479,7 @@ gcs_fc_stop_end (gcs_conn_t* conn)
     }
     else {
         conn->stop_sent--;
+        conn->stop_hard = false;
         assert (conn->stop_sent >= 0);
     }
 
@@ -420,6 +490,88 @@ gcs_fc_stop_end (gcs_conn_t* conn)
     return ret;
 }
 
+/* Rate-based FC: whether the rate others pace to has to be updated */
+static inline bool
+gcs_fc_rate_changed (uint32_t const sent, uint32_t const now)
+{
+    if ((GCS_FC_STOP == sent) != (GCS_FC_STOP == now)) return true;
+
+    uint32_t const diff(sent > now ? sent - now : now - sent);
+
+    return (diff > sent / 10);
+}
+
+/* Rate-based FC: to be called under slave queue lock while STOP is in effect.
+ * Periodically re-evaluates the rate this node can accept actions at, and
+ * replaces it with a full STOP if the queue keeps on growing despite others
+ * pacing to the advertised rate. Returns the new value of FC_STOP to be sent,
+ * 0 if advertised rate stays. */
+static inline uint32_t
+gcs_fc_advertise_begin (gcs_conn_t* conn)
+{
+    /* in JOINER state STOP belongs to state transfer FC */
+    if (!conn->params.fc_rate                ||
+        conn->stop_sent != 1                 ||
+        GCS_CONN_JOINER == conn->state       ||
+        conn->state     >  conn->max_fc_state) return 0;
+
+    long long const now(gu_time_monotonic());
+    bool const escalate(conn->queue_len >
+                        (2 * conn->upper_limit + conn->fc_offset));
+
+    if (!escalate && now - conn->fc_advertised < GCS_FC_ADVERTISE) return 0;
+
+    conn->fc_advertised = now;
+
+    uint32_t const ret(escalate ? GCS_FC_STOP : gcs_fc_rate_stop (conn));
+
+    if (!gcs_fc_rate_changed (conn->fc_stop, ret)) return 0;
+
+    long const err(gu_mutex_lock (&conn->fc_lock));
+
+    if (gu_unlikely(err)) {
+        gu_fatal ("Mutex lock failed: %d (%s)", err, strerror(err));
+        abort();
+    }
+
+    conn->stop_sent++; // the new STOP is followed by CONT for the old one
+
+    return ret;
+}
+
+/* Complement to gcs_fc_advertise_begin(). New STOP goes before CONT, so that
+ * others' stop_count does not drop to 0 in between. Older nodes just count
+ * one STOP and one CONT, newer ones take the rate from the latest STOP. */
+static inline long
+gcs_fc_advertise_end (gcs_conn_t* conn, uint32_t const stop)
+{
+    gu_debug ("SENDING FC_STOP %u (was %u, local seqno: %lld)",
+              stop, conn->fc_stop, conn->local_act_id);
+
+    long ret = gcs_send_fc_event (conn, stop);
+
+    if (gu_likely(ret >= 0)) {
+        conn->fc_stop   = stop;
+        conn->stop_hard = (GCS_FC_STOP == stop);
+        conn->stats_fc_sent++;
+
+        ret = gcs_send_fc_event (conn, GCS_FC_CONT);
+        // if CONT failed, both STOPs stay in effect and will take two CONTs
+        conn->stop_sent -= (ret >= 0);
+    }
+    else {
+        conn->stop_sent--; // the old STOP stays in effect
+    }
+
+    gu_mutex_unlock (&conn->fc_lock);
+
+    if (ret > 0) ret = 0;
+
+    ret = gcs_check_error (ret, "Failed to re-advertise FC_STOP rate");
+
+    return ret;
+}
+
 /* To be called under slave queue lock. Returns true if FC_CONT must be sent */
 static inline bool
 gcs_fc_cont_begin (gcs_conn_t* conn)
@@ -457,7 +609,7 @@ gcs_fc_cont_end (gcs_conn_t* conn)
 
     ret = gcs_send_fc_event (conn, GCS_FC_CONT);
 
-    if (gu_likely (ret >= 0)) { ret = 0; }
+    if (gu_likely (ret >= 0)) { ret = 0; conn->stop_hard = false; }
 
     conn->stop_sent += (ret != 0); // fix count in case of error
 
@@ -590,19 +742,24 @@ _release_flow_control (gcs_conn_t* conn)
 {
     int err = 0;
 
-    if (gu_unlikely(err = gu_mutex_lock (&conn->fc_lock))) {
-        gu_fatal ("Mutex lock failed: %d (%s)", err, strerror(err));
-        abort();
-    }
+    do {
+        if (gu_unlikely(err = gu_mutex_lock (&conn->fc_lock))) {
+            gu_fatal ("Mutex lock failed: %d (%s)", err, strerror(err));
+            abort();
+        }
 
-    if (conn->stop_sent) {
-        assert (1 == conn->stop_sent);
-        conn->stop_sent--;
-        err = gcs_fc_cont_end (conn);
-    }
-    else {
-        gu_mutex_unlock (&conn->fc_lock);
+        if (conn->stop_sent) {
+            /* 2 if CONT after rate re-advertisement failed */
+            assert (conn->stop_sent <= 2);
+            conn->stop_sent--;
+            err = gcs_fc_cont_end (conn);
+        }
+        else {
+            gu_mutex_unlock (&conn->fc_lock);
+            break;
+        }
     }
+    while (!err);
 
     return err;
 }
@@ -690,6 +847,7 @@ _release_sst_flow_control (gcs_conn_t* conn)
         if (conn->stop_sent > 0) {
             ret = gcs_send_fc_event (conn, GCS_FC_CONT);
             conn->stop_sent -= (ret >= 0);
+            conn->stop_hard  = (conn->stop_sent > 0);
         }
     }
     while (ret < 0 && -EAGAIN == ret); // we need to send CONT here at all costs
@@ -754,11 +912,56 @@ _set_fc_limits (gcs_conn_t* conn)
              conn->lower_limit, conn->upper_limit);
 }
 
+/*! Rate-based flow control: paces replication to the slowest rate advertised
+ *  by the members that sent STOP, pauses if any of them requested full STOP
+ *  or the rate is too low to pace to. The slowest rate may go up as well:
+ *  stopped members re-advertise their rate as they catch up. */
+static void
+gcs_handle_flow_rate (gcs_conn_t* conn, long const sender_idx,
+                      uint32_t const stop)
+{
+    double const rate(gcs_fc_rates_update (&conn->fc_rates, sender_idx, stop));
+
+    if (conn->stop_count > 0) {
+        /* STOP not attributed to any member counts as full STOP */
+        conn->fc_min_rate = rate > 0.0 ? rate : 0.0;
+
+        /* our share of the advertised rate */
+        long const senders(conn->params.fc_master_slave ? 1 : conn->memb_num);
+        long long const interval(conn->fc_min_rate >= 1.0 ?
+                                 senders * 1.0e9 / conn->fc_min_rate :
+                                 GU_TIME_ETERNITY);
+
+        if (interval <= GCS_FC_PACE_MAX) {
+            gcs_fc_pacer_set (&conn->fc_pacer, interval);
+
+            if (conn->fc_paused) {
+                gcs_sm_continue (conn->sm); // slowest member picked up
+                conn->fc_paused = false;
+            }
+        }
+        else if (!conn->fc_paused) {
+            gcs_fc_pacer_set (&conn->fc_pacer, 0);
+            gcs_sm_pause (conn->sm);
+            conn->fc_paused = true;
+        }
+    }
+    else if (0 == conn->stop_count) {
+        gcs_fc_pacer_set (&conn->fc_pacer, 0);
+
+        if (conn->fc_paused) {
+            gcs_sm_continue (conn->sm); // last CONT request
+            conn->fc_paused = false;
+        }
+    }
+}
+
 /*! Handles flow control events
  *  (this is frequent, so leave it inlined) */
 static inline void
 gcs_handle_flow_control (gcs_conn_t*                conn,
-                         const struct gcs_fc_event* fc)
+                         const struct gcs_fc_event* fc,
+                         long const                 sender_idx)
 {
     if (gtohl(fc->conf_id) != (uint32_t)conn->conf_id) {
         // obsolete fc request
@@ -768,7 +971,10 @@ gcs_handle_flow_control (gcs_conn_t*                conn,
     conn->stop_count += ((fc->stop != 0) << 1) - 1; // +1 if !0, -1 if 0
     conn->stats_fc_received += (fc->stop != 0);
 
-    if (1 == conn->stop_count) {
+    if (conn->params.fc_rate) {
+        gcs_handle_flow_rate (conn, sender_idx, gtohl(fc->stop));
+    }
+    else if (1 == conn->stop_count) {
         gcs_sm_pause (conn->sm);    // first STOP request
     }
     else if (0 == conn->stop_count) {
@@ -829,8 +1035,16 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
         if (!gu_mutex_lock (&conn->fc_lock)) {
             conn->stop_sent   = 0;
             conn->stop_count  = 0;
+            conn->stop_hard   = false;
+            conn->fc_paused   = false;
             conn->conf_id     = conf->conf_id;
             conn->memb_num    = conf->memb_num;
+            conn->fc_min_rate = 0.0;
+
+            if (gcs_fc_rates_reset (&conn->fc_rates, conn->memb_num)) {
+                gu_fatal ("Failed to allocate flow control rates table.");
+                abort();
+            }
 
             _set_fc_limits (conn);
 
@@ -845,6 +1059,7 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
 
         // need to wake up send monitor if it was paused during CC
         gcs_sm_continue(conn->sm);
+        gcs_fc_pacer_set (&conn->fc_pacer, 0);
     }
     gu_fifo_release (conn->recv_q);
 
@@ -1000,7 +1215,8 @@ gcs_handle_actions (gcs_conn_t*          conn,
     switch (rcvd->act.type) {
     case GCS_ACT_FLOW:
         assert (sizeof(struct gcs_fc_event) == rcvd->act.buf_len);
-        gcs_handle_flow_control (conn, (const gcs_fc_event*)rcvd->act.buf);
+        gcs_handle_flow_control (conn, (const gcs_fc_event*)rcvd->act.buf,
+                                 rcvd->sender_idx);
         break;
     case GCS_ACT_CONF:
         gcs_handle_act_conf (conn, rcvd->act.buf);
@@ -1072,6 +1288,7 @@ _check_recv_queue_growth (gcs_conn_t* conn, ssize_t size)
         if (conn->stop_sent <= 0) {
             if ((ret = gcs_send_fc_event (conn, GCS_FC_STOP)) >= 0) {
                 conn->stop_sent++;
+                conn->stop_hard = true;
                 ret = 0;
             }
             else {
@@ -1273,6 +1490,8 @@ static void *gcs_recv_thread (void *arg)
 
                 conn->queue_len = gu_fifo_length (conn->recv_q) + 1;
                 bool send_stop  = gcs_fc_stop_begin (conn);
+                uint32_t const advertise
+                    (send_stop ? 0 : gcs_fc_advertise_begin (conn));
 
                 // release queue
                 GCS_FIFO_PUSH_TAIL (conn, rcvd.act.buf_len);
@@ -1288,6 +1507,13 @@ static void *gcs_recv_thread (void *arg)
                               ret, strerror(-ret));
                     break;
                 }
+
+                if (gu_unlikely(advertise) &&
+                    (ret = gcs_fc_advertise_end (conn, advertise))) {
+                    gu_error ("gcs_fc_advertise() returned %d: %s",
+                              ret, strerror(-ret));
+                    break;
+                }
             }
             else {
                 assert (GCS_CONN_CLOSED == conn->state);
@@ -1473,6 +1699,8 @@ long gcs_destroy (gcs_conn_t *conn)
     /* This must not last for long */
     while (gu_mutex_destroy (&conn->fc_lock));
 
+    gcs_fc_rates_free (&conn->fc_rates);
+
     _cleanup_params (conn);
 
     gu_free (conn);
@@ -1480,6 +1708,22 @@ long gcs_destroy (gcs_conn_t *conn)
     return 0;
 }
 
+/* Rate-based flow control: waits for the next send slot.
+ * To be called from within send monitor. */
+static inline void
+gcs_fc_throttle (gcs_conn_t* conn)
+{
+    long long const delay(gcs_fc_pacer_delay (&conn->fc_pacer,
+                                              gu_time_monotonic()));
+
+    if (gu_unlikely(delay > 0)) {
+        struct timespec const period = { time_t(delay / 1000000000LL),
+                                         long(delay % 1000000000LL) };
+        nanosleep (&period, NULL);
+        conn->fc_pacer.throttled_ns += delay;
+    }
+}
+
 /* Puts action in the send queue and returns */
 long gcs_sendv (gcs_conn_t*          const conn,
                 const struct gu_buf* const act_bufs,
@@ -1499,6 +1743,10 @@ long gcs_sendv (gcs_conn_t*          const conn,
 
     if (!(ret = gcs_sm_enter (conn->sm, &tmp_cond, scheduled, true)))
     {
+        if (conn->params.fc_rate && GCS_ACT_TORDERED == act_type) {
+            gcs_fc_throttle (conn);
+        }
+
         while ((GCS_CONN_OPEN >= conn->state) &&
                (ret = gcs_core_send (conn->core, act_bufs,
                                      act_size, act_type)) == -ERESTART);
@@ -1524,6 +1772,143 @@ gcs_seqno_t gcs_caused(gcs_conn_t* conn)
     return gcs_core_caused(conn->core);
 }
 
+/*! Checks if action can be replicated in a group with other actions */
+static inline bool
+_repl_groupable (gcs_conn_t* const conn, const struct gcs_action* const act)
+{
+    return (conn->params.max_repl_group > 1                   &&
+            GCS_ACT_TORDERED == act->type                      &&
+            act->size <= conn->params.max_packet_size          &&
+            gcs_core_group_protocol_version (conn->core) >= 2);
+}
+
+/*! Checks if slave queue allows to replicate one more TO action
+ *  (in rate-based FC the queue is allowed to grow up to the point
+ *  of escalation to full STOP) */
+static inline bool
+_repl_queue_ok (const gcs_conn_t* const conn)
+{
+    return (conn->upper_limit * (1 + conn->params.fc_rate) >= conn->queue_len);
+}
+
+/*! Wakes up the thread of an action that was collected but not sent */
+static void
+_repl_act_fail (struct gcs_repl_act* const repl_act, long const err)
+{
+    assert (err < 0);
+
+    gu_mutex_lock   (&repl_act->wait_mutex);
+    repl_act->send_ret = err;
+    gu_cond_signal  (&repl_act->wait_cond);
+    gu_mutex_unlock (&repl_act->wait_mutex);
+}
+
+/*!
+ * Collects actions of the threads queued in send monitor right behind
+ * the leader (which is already in repl_q) and sends them all in one message.
+ * Collected actions are added to repl_q after the leader's one in the same
+ * order they are sent, so recv thread matches them as usual. Each of them
+ * is subject to the same slave queue check as the leader and takes its own
+ * slot in rate-based flow control.
+ *
+ * @return leader action send status as gcs_core_send() does
+ */
+static long
+_repl_send_group (gcs_conn_t* const conn, struct gcs_repl_act* const leader)
+{
+    void* group[GCS_MAX_REPL_GROUP];
+
+    group[0] = leader;
+
+    long num = 1 + gcs_sm_collect (conn->sm, group + 1,
+                                   conn->params.max_repl_group - 1);
+    long pushed;
+    long err = 0;
+
+    for (pushed = 1; pushed < num; ++pushed) {
+        if (gu_unlikely(!_repl_queue_ok (conn))) {
+            err = -EAGAIN;
+            break;
+        }
+
+        struct gcs_repl_act** const act_ptr = (struct gcs_repl_act**)
+            gcs_fifo_lite_get_tail (conn->repl_q);
+
+        if (gu_unlikely(NULL == act_ptr)) { /* repl_q closed */
+            err = -ENOTCONN;
+            break;
+        }
+
+        *act_ptr = static_cast<struct gcs_repl_act*>(group[pushed]);
+        gcs_fifo_lite_push_tail (conn->repl_q);
+    }
+
+    for (long i = pushed; i < num; ++i) {
+        _repl_act_fail (static_cast<struct gcs_repl_act*>(group[i]), err);
+    }
+
+    num = pushed;
+
+    /* leader has already waited for its own slot */
+    if (conn->params.fc_rate && num > 1) {
+        gcs_fc_pacer_reserve (&conn->fc_pacer, gu_time_monotonic(), num - 1);
+    }
+
+    const struct gu_buf* bufs [GCS_MAX_REPL_GROUP];
+    size_t               sizes[GCS_MAX_REPL_GROUP];
+
+    for (long i = 0; i < num; ++i) {
+        struct gcs_repl_act* const repl_act =
+            static_cast<struct gcs_repl_act*>(group[i]);
+        bufs[i]  = repl_act->act_in;
+        sizes[i] = repl_act->action->size;
+    }
+
+    long ret;
+    long sent = 0; /* number of actions in group that were sent */
+
+    while ((ret = gcs_core_send_group (conn->core, bufs, sizes, num)) ==
+           -ERESTART) {}
+
+    if (gu_likely(ret >= 0)) {
+        sent = num;
+    }
+    else if (-EPROTONOSUPPORT == ret || -EMSGSIZE == ret) {
+        /* group protocol changed since the check, send one by one */
+        for (sent = 0; sent < num; ++sent) {
+            while ((ret = gcs_core_send (conn->core, bufs[sent], sizes[sent],
+                                         GCS_ACT_TORDERED)) == -ERESTART) {}
+            if (ret < 0) break;
+        }
+    }
+
+    if (gu_unlikely(sent < num)) {
+        assert (ret < 0);
+
+        gu_warn ("Send action group of %ld returned %ld (%s), %ld sent",
+                 num, ret, strerror(-ret), sent);
+
+        /* unsent items are at the tail of the queue, they will never be
+         * delivered */
+        for (long i = num - 1; i >= sent; --i) {
+            if (!gcs_fifo_lite_remove (conn->repl_q)) {
+                gu_fatal ("Failed to remove unsent item from repl_q");
+                assert(0);
+                ret = -ENOTRECOVERABLE;
+            }
+
+            if (i > 0) {
+                _repl_act_fail (static_cast<struct gcs_repl_act*>(group[i]),
+                                ret);
+            }
+        }
+    }
+
+    if (sent > 0) ret = leader->action->size;
+
+    return ret;
+}
+
 /* Puts action in the send queue and returns after it is replicated */
 long gcs_replv (gcs_conn_t*          const conn,      //!<in
                 const struct gu_buf* const act_in,    //!<in
@@ -1554,20 +1939,28 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
         // 1. serializes gcs_core_send() access between gcs_repl() and
         //    gcs_send()
         // 2. avoids race with gcs_close() and gcs_destroy()
-        if (!(ret = gcs_sm_enter (conn->sm, &repl_act.wait_cond, scheduled, true)))
-        {
-            struct gcs_repl_act** act_ptr;
+        bool const groupable(_repl_groupable (conn, act));
 
 //#ifndef NDEBUG
-            const void* const orig_buf = act->buf;
+        const void* const orig_buf = act->buf;
 //#endif
 
+        if (!(ret = gcs_sm_enter_ctx (conn->sm, &repl_act.wait_cond, scheduled,
+                                      true, groupable ? &repl_act : NULL,
+                                      &repl_act.collected)))
+        {
+            struct gcs_repl_act** act_ptr;
+
+            if (conn->params.fc_rate && GCS_ACT_TORDERED == act->type) {
+                gcs_fc_throttle (conn);
+            }
+
             // some hack here to achieve one if() instead of two:
             // ret = -EAGAIN part is a workaround for #569
             // if (conn->state >= GCS_CONN_CLOSE) or (act_ptr == NULL)
             // ret will be -ENOTCONN
             if ((ret = -EAGAIN,
-                 conn->upper_limit >= conn->queue_len ||
+                 _repl_queue_ok (conn)                          ||
                  act->type         != GCS_ACT_TORDERED)         &&
                 (ret = -ENOTCONN, GCS_CONN_OPEN >= conn->state) &&
                 (act_ptr = (struct gcs_repl_act**)gcs_fifo_lite_get_tail (conn->repl_q)))
@@ -1575,75 +1968,93 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
                 *act_ptr = &repl_act;
                 gcs_fifo_lite_push_tail (conn->repl_q);
 
-                // Keep on trying until something else comes out
-                while ((ret = gcs_core_send (conn->core, act_in, act->size,
-                                             act->type)) == -ERESTART) {}
-
-                if (ret < 0) {
-                    /* remove item from the queue, it will never be delivered */
-                    gu_warn ("Send action {%p, %zd, %s} returned %d (%s)",
-                             act->buf, act->size,gcs_act_type_to_str(act->type),
-                             ret, strerror(-ret));
-
-                    if (!gcs_fifo_lite_remove (conn->repl_q)) {
-                        gu_fatal ("Failed to remove unsent item from repl_q");
-                        assert(0);
-                        ret = -ENOTRECOVERABLE;
-                    }
+                if (groupable) {
+                    /* unsent items are removed from the queue there */
+                    ret = _repl_send_group (conn, &repl_act);
                 }
                 else {
-                    assert (ret == (ssize_t)act->size);
+                    // Keep on trying until something else comes out
+                    while ((ret = gcs_core_send (conn->core, act_in, act->size,
+                                                 act->type)) == -ERESTART) {}
+
+                    if (ret < 0) {
+                        /* remove item from the queue, it will never be
+                         * delivered */
+                        gu_warn ("Send action {%p, %zd, %s} returned %d (%s)",
+                                 act->buf, act->size,
+                                 gcs_act_type_to_str(act->type),
+                                 ret, strerror(-ret));
+
+                        if (!gcs_fifo_lite_remove (conn->repl_q)) {
+                            gu_fatal ("Failed to remove unsent item from "
+                                      "repl_q");
+                            assert(0);
+                            ret = -ENOTRECOVERABLE;
+                        }
+                    }
                 }
+
+                assert (ret < 0 || ret == (ssize_t)act->size);
             }
 
             gcs_sm_leave (conn->sm);
 
             assert(ret);
+        }
+        else if (-EALREADY == ret) {
+            /* collected and sent by the thread in send monitor */
+            assert (groupable);
+            assert (repl_act.collected);
+            ret = act->size;
+        }
+
+        /* now we can go waiting for action delivery */
+        if (ret >= 0) {
+            gu_cond_wait (&repl_act.wait_cond, &repl_act.wait_mutex);
 
-            /* now we can go waiting for action delivery */
-            if (ret >= 0) {
-                gu_cond_wait (&repl_act.wait_cond, &repl_act.wait_mutex);
+            if (gu_unlikely(repl_act.send_ret < 0)) {
+                /* collected but failed to send */
+                ret = repl_act.send_ret;
+                goto out;
+            }
 #ifndef GCS_FOR_GARB
-                /* assert (act->buf != 0); */
-                if (act->buf == 0)
-                {
-                    /* Recv thread purged repl_q before action was delivered */
-                    ret = -ENOTCONN;
-                    goto out;
-                }
+            /* assert (act->buf != 0); */
+            if (act->buf == 0)
+            {
+                /* Recv thread purged repl_q before action was delivered */
+                ret = -ENOTCONN;
+                goto out;
+            }
 #else
-                assert (act->buf == 0);
+            assert (act->buf == 0);
 #endif /* GCS_FOR_GARB */
 
-                if (act->seqno_g < 0) {
-                    assert (GCS_SEQNO_ILL    == act->seqno_l ||
-                            GCS_ACT_TORDERED != act->type);
+            if (act->seqno_g < 0) {
+                assert (GCS_SEQNO_ILL    == act->seqno_l ||
+                        GCS_ACT_TORDERED != act->type);
 
-                    if (act->seqno_g == GCS_SEQNO_ILL) {
-                        /* action was not replicated for some reason */
-                        assert (orig_buf == act->buf);
-                        ret = -EINTR;
-                    }
-                    else {
-                        /* core provided an error code in global seqno */
-                        assert (orig_buf != act->buf);
-                        ret = act->seqno_g;
-                        act->seqno_g = GCS_SEQNO_ILL;
-                    }
+                if (act->seqno_g == GCS_SEQNO_ILL) {
+                    /* action was not replicated for some reason */
+                    assert (orig_buf == act->buf);
+                    ret = -EINTR;
+                }
+                else {
+                    /* core provided an error code in global seqno */
+                    assert (orig_buf != act->buf);
+                    ret = act->seqno_g;
+                    act->seqno_g = GCS_SEQNO_ILL;
+                }
 
-                    if (orig_buf != act->buf) // action was allocated in gcache
-                    {
-                        gu_debug("Freeing gcache buffer %p after receiving %d",
-                                 act->buf, ret);
-                        gcs_gcache_free (conn->gcache, act->buf);
-                        act->buf = orig_buf;
-                    }
+                if (orig_buf != act->buf) // action was allocated in gcache
+                {
+                    gu_debug("Freeing gcache buffer %p after receiving %d",
+                             act->buf, ret);
+                    gcs_gcache_free (conn->gcache, act->buf);
+                    act->buf = orig_buf;
                 }
             }
         }
-#ifndef GCS_FOR_GARB
     out:
-#endif /* GCS_FOR_GARB */
         gu_mutex_unlock  (&repl_act.wait_mutex);
     }
     gu_mutex_destroy (&repl_act.wait_mutex);
@@ -1786,8 +2197,18 @@ long gcs_recv (gcs_conn_t*        conn,
     if ((recv_act = (struct gcs_recv_act*)gu_fifo_get_head (conn->recv_q, &err)))
     {
         conn->queue_len = gu_fifo_length (conn->recv_q) - 1;
+
+        if (conn->params.fc_rate) {
+            if (conn->queue_len > 0)
+                gcs_fc_meter_add (&conn->fc_meter, gu_time_monotonic());
+            else
+                gcs_fc_meter_restart (&conn->fc_meter, gu_time_monotonic());
+        }
+
         bool send_cont  = gcs_fc_cont_begin   (conn);
         bool send_sync  = gcs_send_sync_begin (conn);
+        uint32_t const advertise
+            (send_cont ? 0 : gcs_fc_advertise_begin (conn));
 
         action->buf     = (void*)recv_act->rcvd.act.buf;
         action->size    = recv_act->rcvd.act.buf_len;
@@ -1831,6 +2252,12 @@ long gcs_recv (gcs_conn_t*        conn,
                      err, strerror(-err));
         }
 
+        if (gu_unlikely(advertise) &&
+            (err = gcs_fc_advertise_end (conn, advertise))) {
+            gu_warn ("Failed to re-advertise FC rate: %d (%s). "
+                     "Will try later.", err, strerror(-err));
+        }
+
         return action->size;
     }
     else {
@@ -1876,7 +2303,9 @@ long
 gcs_wait (gcs_conn_t* conn)
 {
     if (gu_likely(GCS_CONN_SYNCED == conn->state)) {
-       return (conn->stop_count > 0 || (conn->queue_len > conn->upper_limit));
+       bool const stopped(conn->params.fc_rate ?
+                          conn->fc_paused : conn->stop_count > 0);
+       return (stopped || (conn->queue_len > conn->upper_limit));
     }
     else {
         switch (conn->state) {
@@ -1950,6 +2379,10 @@ gcs_get_stats (gcs_conn_t* conn, struct gcs_stats* stats)
                       &stats->fc_paused_ns,
                       &stats->fc_paused_avg);
 
+    gcs_fc_pacer_stats_get (&conn->fc_pacer, gu_time_monotonic(),
+                            &stats->fc_throttled_ns,
+                            &stats->fc_throttled_avg);
+
     stats->fc_sent     = conn->stats_fc_sent;
     stats->fc_received = conn->stats_fc_received;
 }
@@ -1959,6 +2392,7 @@ gcs_flush_stats(gcs_conn_t* conn)
 {
     gu_fifo_stats_flush(conn->recv_q);
     gcs_sm_stats_flush (conn->sm);
+    gcs_fc_pacer_stats_flush (&conn->fc_pacer, gu_time_monotonic());
     conn->stats_fc_sent     = 0;
     conn->stats_fc_received = 0;
 }
@@ -2103,6 +2537,66 @@ _set_pkt_size (gcs_conn_t* conn, const char* value)
     }
 }
 
+static long
+_set_compress (gcs_conn_t* conn, const char* value)
+{
+    bool comp;
+    const char* const endptr = gu_str2bool (value, &comp);
+
+    if (endptr[0] != '\0') return -EINVAL;
+
+    if (conn->params.compress != comp) {
+
+        conn->params.compress = comp;
+        _set_core_compress (conn);
+        gu_config_set_bool (conn->config, GCS_PARAMS_COMPRESS, comp);
+    }
+
+    return 0;
+}
+
+static long
+_set_compress_min_size (gcs_conn_t* conn, const char* value)
+{
+    long long size;
+    const char* const endptr = gu_str2ll (value, &size);
+
+    if (size > 0 && *endptr == '\0') {
+
+        if (size > LONG_MAX) size = LONG_MAX;
+
+        if (conn->params.compress_min_size == size) return 0;
+
+        conn->params.compress_min_size = size;
+        _set_core_compress (conn);
+        gu_config_set_int64 (conn->config, GCS_PARAMS_COMPRESS_MIN_SIZE, size);
+
+        return 0;
+    }
+    else {
+        return -EINVAL;
+    }
+}
+
+static long
+_set_max_repl_group (gcs_conn_t* conn, const char* value)
+{
+    long long num;
+    const char* const endptr = gu_str2ll (value, &num);
+
+    if (num > 0 && num <= GCS_MAX_REPL_GROUP && *endptr == '\0') {
+
+        /* read without send monitor lock, takes effect with next action */
+        conn->params.max_repl_group = num;
+        gu_config_set_int64 (conn->config, GCS_PARAMS_MAX_REPL_GROUP, num);
+
+        return 0;
+    }
+    else {
+        return -EINVAL;
+    }
+}
+
 static long
 _set_recv_q_hard_limit (gcs_conn_t* conn, const char* value)
 {
@@ -2198,6 +2692,15 @@ long gcs_param_set  (gcs_conn_t* conn, const char* key, const char *value)
     else if (!strcmp (key, GCS_PARAMS_MAX_THROTTLE)) {
         return _set_max_throttle (conn, value);
     }
+    else if (!strcmp (key, GCS_PARAMS_COMPRESS)) {
+        return _set_compress (conn, value);
+    }
+    else if (!strcmp (key, GCS_PARAMS_COMPRESS_MIN_SIZE)) {
+        return _set_compress_min_size (conn, value);
+    }
+    else if (!strcmp (key, GCS_PARAMS_MAX_REPL_GROUP)) {
+        return _set_max_repl_group (conn, value);
+    }
     else {
         return gcs_core_param_set (conn->core, key, value);
     }
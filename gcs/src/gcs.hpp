@@ -431,6 +431,8 @@ struct gcs_stats
     double    recv_q_len_avg; //! average recv queue length per queued action
     long long fc_paused_ns;   //! total nanoseconds spent in paused state
     double    fc_paused_avg;  //! faction of time paused due to flow control
+    long long fc_throttled_ns;  //! total nanoseconds spent pacing replication
+    double    fc_throttled_avg; //! fraction of time spent pacing replication
     long long fc_sent;        //! flow control stops sent
     long long fc_received;    //! flow control stops received
     size_t    recv_q_size;    //! current recv queue size
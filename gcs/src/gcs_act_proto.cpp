@@ -5,7 +5,7 @@
  */
 /*
  * Interface to action protocol
- * (to be extended to support protocol versions, currently supports only v0)
+ * (supports versions 0, 1 and 2)
  */
 #include <errno.h>
 #include "gcs_act_proto.hpp"
@@ -22,18 +22,41 @@ bytes: 00 01                07 08       11 12       15 16       19 20
 PV - protocol version
 AT - action type
 
+  Version 1 header structure is the same except for byte 17:
+
+bytes: 00 01                07 08       11 12       15 16 17 18 19 20
+      +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+---
+      |PV|      act_id        |  act_size |  frag_no  |AT|FL|resrvd|  data...
+      +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+---
+
+FL - action flags (GCS_ACT_FLAG_*), act_size is the size of transmitted
+     (possibly compressed) action
+
+  Version 2 header structure is the same except for bytes 18-19:
+
+bytes: 00 01                07 08       11 12       15 16 17 18 19 20
+      +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+---
+      |PV|      act_id        |  act_size |  frag_no  |AT|FL| AN  |  data...
+      +--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+--+---
+
+AN - number of actions packed in the message (little-endian), each of them
+     gets its own global seqno
+
 */
 
 static const size_t PROTO_PV_OFFSET       = 0;
 static const size_t PROTO_AT_OFFSET       = 16;
+static const size_t PROTO_FL_OFFSET       = 17;
+static const size_t PROTO_AN_OFFSET       = 18;
 static const size_t PROTO_DATA_OFFSET     = 20;
 // static const size_t PROTO_ACT_ID_OFFSET   = 0;
 // static const size_t PROTO_ACT_SIZE_OFFSET = 8;
 // static const size_t PROTO_FRAG_NO_OFFSET  = 12;
 
-// static const gcs_seqno_t   PROTO_ACT_ID_MAX   = 0x00FFFFFFFFFFFFLL;
+static const gcs_seqno_t PROTO_ACT_ID_MAX = 0x00FFFFFFFFFFFFLL;
 // static const unsigned int  PROTO_FRAG_NO_MAX  = 0xFFFFFFFF;
 // static const unsigned char PROTO_AT_MAX       = 0xFF;
+static const unsigned int PROTO_AN_MAX = 0xFFFF;
 
 static const int PROTO_VERSION = GCS_ACT_PROTO_MAX;
 
@@ -58,10 +81,14 @@ gcs_act_proto_write (gcs_act_frag_t* frag, void* buf, size_t buf_len)
                   frag->act_type, PROTO_AT_MAX);
         return -EOVERFLOW;
     }
-    if (frag->proto_ver != PROTO_VERSION) return -EPROTO;
+    if (frag->proto_ver > PROTO_VERSION) return -EPROTO;
     if (buf_len      < PROTO_DATA_OFFSET) return -EMSGSIZE;
 #endif
 
+    if (frag->proto_ver > 1 &&
+        gu_unlikely(0 == frag->act_num || frag->act_num > PROTO_AN_MAX))
+        return -EPROTO;
+
     // assert (frag->act_size <= PROTO_ACT_SIZE_MAX);
 
     ((uint64_t*)buf)[0] = gu_be64(frag->act_id);
@@ -70,6 +97,9 @@ gcs_act_proto_write (gcs_act_frag_t* frag, void* buf, size_t buf_len)
 
     ((uint8_t *)buf)[PROTO_PV_OFFSET] = frag->proto_ver;
     ((uint8_t *)buf)[PROTO_AT_OFFSET] = frag->act_type;
+    ((uint8_t *)buf)[PROTO_FL_OFFSET] = frag->proto_ver > 0 ? frag->flags : 0;
+    *(uint16_t*)((uint8_t*)buf + PROTO_AN_OFFSET) =
+        htogs(frag->proto_ver > 1 ? (uint16_t)frag->act_num : 0);
 
     frag->frag     = (uint8_t*)buf + PROTO_DATA_OFFSET;
     frag->frag_len = buf_len - PROTO_DATA_OFFSET;
@@ -98,15 +128,24 @@ gcs_act_proto_read (gcs_act_frag_t* frag, const void* buf, size_t buf_len)
         return -EPROTO; // this fragment should be dropped
     }
 
-    ((uint8_t*)buf)[PROTO_PV_OFFSET] = 0x0;
-    frag->act_id   = gu_be64(*(uint64_t*)buf);
+    /* mask protocol version out instead of zeroing it: buffer may be
+     * shared with the backend and must not be modified */
+    frag->act_id   = gu_be64(*(uint64_t*)buf) & PROTO_ACT_ID_MAX;
     frag->act_size = gtohl  (((uint32_t*)buf)[2]);
     frag->frag_no  = gtohl  (((uint32_t*)buf)[3]);
     frag->act_type = static_cast<gcs_act_type_t>(
         ((uint8_t*)buf)[PROTO_AT_OFFSET]);
+    frag->flags    = frag->proto_ver > 0 ? ((uint8_t*)buf)[PROTO_FL_OFFSET] : 0;
+    frag->act_num  = frag->proto_ver > 1 ?
+        gtohs(*(uint16_t*)((uint8_t*)buf + PROTO_AN_OFFSET)) : 1;
     frag->frag     = ((uint8_t*)buf) + PROTO_DATA_OFFSET;
     frag->frag_len = buf_len - PROTO_DATA_OFFSET;
 
+    if (gu_unlikely(0 == frag->act_num)) {
+        gu_error ("Bad number of actions in message: 0");
+        return -EBADMSG;
+    }
+
     /* return 0 or -EMSGSIZE */
     return ((frag->act_size > GCS_MAX_ACT_SIZE) * -EMSGSIZE);
 }
@@ -5,7 +5,7 @@
  */
 /*
  * Interface to action protocol
- * (to be extended to support protocol versions, currently supports only v0)
+ * (supports versions 0, 1 and 2)
  */
 
 #ifndef _gcs_act_proto_h_
@@ -17,8 +17,12 @@
 #include <stdint.h>
 typedef uint8_t gcs_proto_t;
 
-/*! Supported protocol range (for now only version 0 is supported) */
-#define GCS_ACT_PROTO_MAX 0
+/*! Supported protocol range (version 1 adds action flags,
+ *  version 2 - action groups) */
+#define GCS_ACT_PROTO_MAX 2
+
+/*! Action flags (since version 1) */
+#define GCS_ACT_FLAG_COMPRESSED 0x01 // action is compressed, see gcs_core.cpp
 
 /*! Internal action fragment data representation */
 typedef struct gcs_act_frag
@@ -30,6 +34,9 @@ typedef struct gcs_act_frag
     unsigned long  frag_no;
     gcs_act_type_t act_type;
     int            proto_ver;
+    uint8_t        flags;    // GCS_ACT_FLAG_*, always 0 in version 0
+    unsigned int   act_num;  // number of actions in the message, always 1
+                             // before version 2, see gcs_core.cpp
 }
 gcs_act_frag_t;
 
@@ -9,6 +9,8 @@
  */
 
 #include "gu_throw.hpp"
+#include "gu_utils.hpp"
+#include "gu_lz4.h"
 
 #define GCS_COMP_MSG_ACCESS
 
@@ -64,7 +66,41 @@ struct gcs_core
     size_t          send_buf_len;
     gcs_seqno_t     send_act_no;
 
+    /* action compression */
+    size_t          comp_min_size; // 0 - compression disabled
+    void*           comp_src;      // to gather multi-buffer actions
+    size_t          comp_src_len;
+    void*           comp_buf;
+    size_t          comp_buf_len;
+
+    /* compression stats */
+    long long       comp_acts;     // actions sent compressed
+    long long       comp_in;       // original size of compressed actions
+    long long       comp_out;      // size of compressed actions
+    long long       comp_ns;       // time spent compressing
+    long long       decomp_acts;
+    long long       decomp_ns;     // time spent decompressing
+
+    /* action groups */
+    void*           grp_hdr;       // member sizes of the group being sent
+    size_t          grp_hdr_len;
+    void*           grp_iov;       // buffer vector of the group being sent
+    size_t          grp_iov_len;
+    void*           grp_acts;      // members of the received group
+    size_t          grp_acts_len;
+    unsigned int    grp_num;       // number of members in received group
+    unsigned int    grp_next;      // next member to return from recv()
+
+    /* causal read barriers */
+    gu_mutex_t      caused_lock;
+    gu_cond_t       caused_cond;
+    gcs_seqno_t     caused_seqno;  // result of the last completed barrier
+    long long       caused_sent;   // number of barriers sent
+    long long       caused_done;   // number of barriers completed
+
     /* recv part */
+    void*           recv_buf;  // backend may point recv_msg.buf elsewhere
+    int             recv_buf_len;
     gcs_recv_msg_t  recv_msg;
 
     /* local action FIFO */
@@ -92,14 +128,14 @@ typedef struct core_act
 }
 core_act_t;
 
+// causal message is delivered only locally, it carries barrier number
 typedef struct causal_act
 {
-    gcs_seqno_t* act_id;
-    gu_mutex_t*  mtx;
-    gu_cond_t*   cond;
+    long long barrier;
 } causal_act_t;
 
-static int const GCS_PROTO_MAX = 0;
+static int const GCS_PROTO_MAX = 2; // 1 - action flags, compression
+                                    // 2 - action groups
 
 gcs_core_t*
 gcs_core_create (gu_config_t* const conf,
@@ -119,10 +155,10 @@ gcs_core_create (gu_config_t* const conf,
         core->cache  = cache;
 
         // Need to allocate something, otherwise Spread 3.17.3 freaks out.
-        core->recv_msg.buf = gu_malloc(CORE_INIT_BUF_SIZE);
-        if (core->recv_msg.buf) {
+        core->recv_buf = gu_malloc(CORE_INIT_BUF_SIZE);
+        if (core->recv_buf) {
 
-            core->recv_msg.buf_len = CORE_INIT_BUF_SIZE;
+            core->recv_buf_len = CORE_INIT_BUF_SIZE;
 
             core->send_buf = GU_CALLOC(CORE_INIT_BUF_SIZE, char);
             if (core->send_buf) {
@@ -133,6 +169,8 @@ gcs_core_create (gu_config_t* const conf,
                                                    sizeof (core_act_t));
                 if (core->fifo) {
                     gu_mutex_init  (&core->send_lock, NULL);
+                    gu_mutex_init  (&core->caused_lock, NULL);
+                    gu_cond_init   (&core->caused_cond, NULL);
                     core->proto_ver = -1; // shall be bumped in gcs_group_act_conf()
                     gcs_group_init (&core->group, cache, node_name, inc_addr,
                                     GCS_PROTO_MAX, repl_proto_ver,
@@ -149,7 +187,7 @@ gcs_core_create (gu_config_t* const conf,
                 gu_free (core->send_buf);
             }
 
-            gu_free (core->recv_msg.buf);
+            gu_free (core->recv_buf);
         }
 
         gu_free (core);
@@ -238,10 +276,11 @@ core_error (core_state_t state)
  * actions.
  */
 static inline ssize_t
-core_msg_send (gcs_core_t*    core,
-               const void*    msg,
-               size_t         msg_len,
-               gcs_msg_type_t msg_type)
+core_msg_send (gcs_core_t*          core,
+               const struct gu_buf* bufs,
+               int                  bufs_num,
+               size_t               msg_len,
+               gcs_msg_type_t       msg_type)
 {
     ssize_t ret;
 
@@ -251,7 +290,15 @@ core_msg_send (gcs_core_t*    core,
                       (CORE_EXCHANGE == core->state && GCS_MSG_STATE_MSG ==
                        msg_type))) {
 
-            ret = core->backend.send (&core->backend, msg, msg_len, msg_type);
+            if (gu_likely(1 == bufs_num)) {
+                ret = core->backend.send (&core->backend, bufs[0].ptr,
+                                          msg_len, msg_type);
+            }
+            else {
+                assert (NULL != core->backend.send_v);
+                ret = core->backend.send_v (&core->backend, bufs, bufs_num,
+                                            msg_len, msg_type);
+            }
 
             if (ret > 0 && ret != (ssize_t)msg_len &&
                 GCS_MSG_ACTION != msg_type) {
@@ -282,13 +329,15 @@ core_msg_send (gcs_core_t*    core,
  * by core_msg_send()
  */
 static inline ssize_t
-core_msg_send_retry (gcs_core_t*    core,
-                     const void*    buf,
-                     size_t         buf_len,
-                     gcs_msg_type_t type)
+core_msg_send_v_retry (gcs_core_t*          core,
+                       const struct gu_buf* bufs,
+                       int                  bufs_num,
+                       size_t               msg_len,
+                       gcs_msg_type_t       type)
 {
     ssize_t ret;
-    while ((ret = core_msg_send (core, buf, buf_len, type)) == -EAGAIN) {
+    while ((ret = core_msg_send (core, bufs, bufs_num, msg_len, type)) ==
+           -EAGAIN) {
         /* wait for primary configuration - sleep 0.01 sec */
         gu_debug ("Backend requested wait");
         usleep (10000);
@@ -297,11 +346,188 @@ core_msg_send_retry (gcs_core_t*    core,
     return ret;
 }
 
-ssize_t
-gcs_core_send (gcs_core_t*          const conn,
-               const struct gu_buf* const action,
-               size_t                     act_size,
-               gcs_act_type_t       const act_type)
+static inline ssize_t
+core_msg_send_retry (gcs_core_t*    core,
+                     const void*    buf,
+                     size_t         buf_len,
+                     gcs_msg_type_t type)
+{
+    struct gu_buf const b = { buf, (ssize_t)buf_len };
+    return core_msg_send_v_retry (core, &b, 1, buf_len, type);
+}
+
+/* Max number of buffers passed to backend send_v() with action fragment */
+static int const CORE_SEND_IOV_MAX = 32;
+
+/*!
+ * Fills iov with references to at most size bytes of action data starting
+ * at offset off in action[idx]. On input iov_num is the size of iov array,
+ * on output - the number of buffers used.
+ *
+ * @return number of bytes referenced by iov
+ */
+static inline size_t
+core_act_iov (const struct gu_buf* const action,
+              int                        idx,
+              size_t                     off,
+              size_t               const size,
+              struct gu_buf*       const iov,
+              int*                 const iov_num)
+{
+    size_t ret = 0;
+    int    n   = 0;
+
+    while (ret < size && n < *iov_num) {
+        size_t const left = action[idx].size - off;
+
+        if (left > 0) {
+            size_t const len = left < size - ret ? left : size - ret;
+
+            iov[n].ptr  = (const uint8_t*)action[idx].ptr + off;
+            iov[n].size = len;
+            ++n;
+            ret += len;
+        }
+
+        ++idx;
+        off = 0;
+    }
+
+    *iov_num = n;
+    return ret;
+}
+
+/*! Copies size bytes of action data starting at offset off in action[idx] */
+static inline void
+core_act_copy (const struct gu_buf* const action,
+               int                        idx,
+               size_t                     off,
+               size_t                     size,
+               uint8_t*                   dst)
+{
+    while (size > 0) {
+        size_t const left = action[idx].size - off;
+        size_t const len  = left < size ? left : size;
+
+        memcpy (dst, (const uint8_t*)action[idx].ptr + off, len);
+        dst  += len;
+        size -= len;
+
+        ++idx;
+        off = 0;
+    }
+}
+
+/*! Advances action data position by size bytes */
+static inline void
+core_act_skip (const struct gu_buf* const action,
+               int*                 const idx,
+               size_t*              const off,
+               size_t                     size)
+{
+    while (size > 0) {
+        size_t const left = action[*idx].size - *off;
+
+        if (size < left) {
+            *off += size;
+            return;
+        }
+
+        size -= left;
+        ++(*idx);
+        *off = 0;
+    }
+}
+
+/*
+ * Compressed action is the original action size (4 bytes, little-endian)
+ * followed by LZ4 block.
+ */
+static size_t const CORE_COMP_HDR_SIZE = sizeof(uint32_t);
+
+/* Actions bigger than that are not compressed to limit buffer memory */
+static size_t const CORE_COMP_MAX_SIZE = (1 << 24); // 16M
+
+/*! Makes sure buffer is at least size bytes long */
+static inline bool
+core_buf_reserve (void** const buf, size_t* const buf_len, size_t const size)
+{
+    if (gu_likely(*buf_len >= size)) return true;
+
+    void* const tmp = gu_realloc (*buf, size);
+
+    if (gu_unlikely(NULL == tmp)) return false;
+
+    *buf     = tmp;
+    *buf_len = size;
+
+    return true;
+}
+
+/*!
+ * Compresses action into conn->comp_buf.
+ *
+ * @return size of compressed action or 0 if it is not worth sending
+ *         compressed.
+ */
+static size_t
+core_act_compress (gcs_core_t*          const conn,
+                   const struct gu_buf* const action,
+                   size_t               const act_size)
+{
+    /* too small to gain anything */
+    if (act_size <= 2 * CORE_COMP_HDR_SIZE) return 0;
+
+    long long const start = gu_time_monotonic();
+    const void*     src   = action[0].ptr;
+
+    if (size_t(action[0].size) < act_size) {
+        /* LZ4 block must be contiguous, gather action buffers */
+        if (!core_buf_reserve (&conn->comp_src, &conn->comp_src_len, act_size))
+            return 0;
+
+        core_act_copy (action, 0, 0, act_size, (uint8_t*)conn->comp_src);
+        src = conn->comp_src;
+    }
+
+    if (!core_buf_reserve (&conn->comp_buf, &conn->comp_buf_len, act_size))
+        return 0;
+
+    /* require at least 1/16 reduction, otherwise it is not worth the CPU
+     * spent on decompression by every member */
+    size_t const max_size = act_size - CORE_COMP_HDR_SIZE - act_size / 16;
+    size_t const ret = gu_lz4_compress (src, act_size,
+                                        (uint8_t*)conn->comp_buf +
+                                        CORE_COMP_HDR_SIZE, max_size);
+
+    conn->comp_ns += gu_time_monotonic() - start;
+
+    if (0 == ret) return 0;
+
+    *(uint32_t*)conn->comp_buf = htogl((uint32_t)act_size);
+
+    conn->comp_acts++;
+    conn->comp_in  += act_size;
+    conn->comp_out += ret + CORE_COMP_HDR_SIZE;
+
+    return ret + CORE_COMP_HDR_SIZE;
+}
+
+/*!
+ * Sends action act_in of act_size bytes which contains act_num actions
+ * given by locals and local_sizes (just act_in itself if act_num is 1).
+ * Those are delivered back to the sender in local action FIFO.
+ *
+ * @return total size of actions sent or negative error code
+ */
+static ssize_t
+core_send_act (gcs_core_t*                const conn,
+               const struct gu_buf*       const act_in,
+               size_t                           act_size,
+               gcs_act_type_t             const act_type,
+               const struct gu_buf* const*      locals,
+               const size_t*              const local_sizes,
+               unsigned int               const act_num)
 {
     ssize_t        ret  = 0;
     ssize_t        sent = 0;
@@ -309,11 +535,41 @@ gcs_core_send (gcs_core_t*          const conn,
     ssize_t        send_size;
     const unsigned char proto_ver = conn->proto_ver;
     const ssize_t  hdr_size       = gcs_act_proto_hdr_size (proto_ver);
+    size_t         act_len        = 0; // total size of original actions
+    unsigned int   i;
+
+    const struct gu_buf* action = act_in;
+    struct gu_buf        comp_act;
 
     core_act_t*    local_act;
 
     assert (action != NULL);
     assert (act_size > 0);
+    assert (act_num > 0);
+
+    /* Initialize action constants */
+    frg.act_type  = act_type;
+    frg.act_id    = conn->send_act_no; /* incremented for every new action */
+    frg.frag_no   = 0;
+    frg.proto_ver = proto_ver;
+    frg.flags     = 0;
+    frg.act_num   = act_num;
+
+    /* Compress only writesets, older protocol members can't decompress */
+    if (conn->comp_min_size > 0 && act_size >= conn->comp_min_size &&
+        act_size <= CORE_COMP_MAX_SIZE && GCS_ACT_TORDERED == act_type &&
+        proto_ver >= 1) {
+
+        size_t const comp_size = core_act_compress (conn, act_in, act_size);
+
+        if (comp_size > 0) {
+            comp_act.ptr  = conn->comp_buf;
+            comp_act.size = comp_size;
+            action        = &comp_act;
+            act_size      = comp_size;
+            frg.flags    |= GCS_ACT_FLAG_COMPRESSED;
+        }
+    }
 
     /*
      * Action header will be replicated with every message.
@@ -321,53 +577,54 @@ gcs_core_send (gcs_core_t*          const conn,
      * so far and simplifies A LOT.
      */
 
-    /* Initialize action constants */
     frg.act_size  = act_size;
-    frg.act_type  = act_type;
-    frg.act_id    = conn->send_act_no; /* incremented for every new action */
-    frg.frag_no   = 0;
-    frg.proto_ver = proto_ver;
 
     if ((ret = gcs_act_proto_write (&frg, conn->send_buf, conn->send_buf_len)))
         return ret;
 
-    if ((local_act = (core_act_t*)gcs_fifo_lite_get_tail (conn->fifo))) {
-        *local_act = (core_act_t){ conn->send_act_no, action, act_size };
-        gcs_fifo_lite_push_tail (conn->fifo);
-    }
-    else {
-        ret = core_error (conn->state);
-        gu_error ("Failed to access core FIFO: %d (%s)", ret, strerror (-ret));
-        return ret;
+    /* local actions are delivered back to the sender uncompressed */
+    for (i = 0; i < act_num; ++i) {
+        if ((local_act = (core_act_t*)gcs_fifo_lite_get_tail (conn->fifo))) {
+            *local_act = (core_act_t){ conn->send_act_no, locals[i],
+                                       local_sizes[i] };
+            gcs_fifo_lite_push_tail (conn->fifo);
+            act_len += local_sizes[i];
+        }
+        else {
+            ret = core_error (conn->state);
+            gu_error ("Failed to access core FIFO: %d (%s)",
+                      ret, strerror (-ret));
+            while (i-- > 0) gcs_fifo_lite_remove (conn->fifo);
+            return ret;
+        }
     }
 
-    int            idx  = 0;
-    const uint8_t* ptr  = (const uint8_t*)action[idx].ptr;
-    size_t         left = action[idx].size;
+    int    idx = 0; // current action buffer
+    size_t off = 0; // offset of the first unsent byte in it
 
     do {
-        const size_t chunk_size =
+        size_t chunk_size =
             act_size < frg.frag_len ? act_size : frg.frag_len;
 
-        /* Here is the only time we have to cast frg.frag */
-        char* dst = (char*)frg.frag;
-        size_t to_copy = chunk_size;
+        struct gu_buf iov[CORE_SEND_IOV_MAX];
+        int           iov_num;
 
-        while (to_copy > 0) {        // gather action bufs into one
-            if (to_copy < left) {
-                memcpy (dst, ptr, to_copy);
-                ptr     += to_copy;
-                left    -= to_copy;
-                to_copy = 0;
-            }
-            else {
-                memcpy (dst, ptr, left);
-                dst     += left;
-                to_copy -= left;
-                idx++;
-                ptr  = (const uint8_t*)action[idx].ptr;
-                left = action[idx].size;
-            }
+        iov[0].ptr = conn->send_buf;
+
+        if (gu_likely(NULL != conn->backend.send_v)) {
+            /* pass references to action buffers down to backend,
+             * fragment is shortened if it spans too many buffers */
+            iov_num    = CORE_SEND_IOV_MAX - 1;
+            chunk_size = core_act_iov (action, idx, off, chunk_size,
+                                       iov + 1, &iov_num);
+            iov_num   += 1;
+            iov[0].size = hdr_size;
+        }
+        else {
+            /* Here is the only time we have to cast frg.frag */
+            core_act_copy (action, idx, off, chunk_size, (uint8_t*)frg.frag);
+            iov_num     = 1;
+            iov[0].size = hdr_size + chunk_size;
         }
 
         send_size = hdr_size + chunk_size;
@@ -377,8 +634,8 @@ gcs_core_send (gcs_core_t*          const conn,
         gu_info ("Sent %p of size %zu. Total sent: %zu, left: %zu",
                  (char*)conn->send_buf + hdr_size, chunk_size, sent, act_size);
 #endif
-        ret = core_msg_send_retry (conn, conn->send_buf, send_size,
-                                   GCS_MSG_ACTION);
+        ret = core_msg_send_v_retry (conn, iov, iov_num, send_size,
+                                     GCS_MSG_ACTION);
 #ifdef GCS_CORE_TESTING
 //        gu_lock_step_wait (&conn->ls); // pause after every fragment
 //        gu_info ("Sent %p of size %zu, ret: %zd. Total sent: %zu, left: %zu",
@@ -393,29 +650,13 @@ gcs_core_send (gcs_core_t*          const conn,
             sent     += ret;
             act_size -= ret;
 
-            if (gu_unlikely((size_t)ret < chunk_size)) {
-                /* Could not send all that was copied: */
+            /* move to the first unsent byte */
+            core_act_skip (action, &idx, &off, ret);
 
-                /* 1. adjust frag_len, don't copy more than we could send */
+            if (gu_unlikely((size_t)ret < chunk_size)) {
+                /* Could not send all of the fragment,
+                 * don't try to send more than we could next time */
                 frg.frag_len = ret;
-
-                /* 2. move ptr back to point at the first unsent byte */
-                size_t move_back = chunk_size - ret;
-                size_t ptrdiff   = ptr - (uint8_t*)action[idx].ptr;
-                do {
-                    if (move_back <= ptrdiff) {
-                        ptr -= move_back;
-                        left = action[idx].size - ptrdiff + move_back;
-                        break;
-                    }
-                    else {
-                        assert (idx > 0);
-                        move_back -= ptrdiff;
-                        idx--;
-                        ptrdiff = action[idx].size;
-                        ptr = (uint8_t*)action[idx].ptr + ptrdiff;
-                    }
-                } while (true);
             }
         }
         else {
@@ -432,7 +673,7 @@ gcs_core_send (gcs_core_t*          const conn,
              *
              * 1. Action will never be received completely by this node. Hence
              *    action must be removed from fifo on behalf of sending thr.: */
-            gcs_fifo_lite_remove (conn->fifo);
+            for (i = 0; i < act_num; ++i) gcs_fifo_lite_remove (conn->fifo);
             /* 2. Members will have to discard received fragments.
              * Two reasons could lead us here: new member(s) in configuration
              * change or broken connection (leave group). In both cases other
@@ -446,35 +687,130 @@ gcs_core_send (gcs_core_t*          const conn,
 
     /* successfully sent action, increment send counter */
     conn->send_act_no++;
-    ret = sent;
+    assert ((size_t)sent == frg.act_size);
+    ret = act_len;
 
 out:
 //    gu_debug ("returning: %d (%s)", ret, strerror(-ret));
     return ret;
 }
 
+ssize_t
+gcs_core_send (gcs_core_t*          const conn,
+               const struct gu_buf* const act_in,
+               size_t               const act_size,
+               gcs_act_type_t       const act_type)
+{
+    return core_send_act (conn, act_in, act_size, act_type,
+                          &act_in, &act_size, 1);
+}
+
+/* Action group format is described in gcs_defrag.hpp */
+static size_t const CORE_GRP_HDR_SIZE = GCS_DEFRAG_GRP_HDR_SIZE;
+
+/*! Returns the number of buffers that make up size bytes of action */
+static inline int
+core_act_buf_num (const struct gu_buf* const action, size_t size)
+{
+    int n = 0;
+
+    while (size > 0) {
+        size_t const len = action[n].size;
+        size -= len < size ? len : size;
+        ++n;
+    }
+
+    return n;
+}
+
+ssize_t
+gcs_core_send_group (gcs_core_t*                const conn,
+                     const struct gu_buf* const*      acts,
+                     const size_t*              const act_sizes,
+                     unsigned int               const act_num)
+{
+    assert (act_num > 0);
+
+    if (1 == act_num) {
+        return gcs_core_send (conn, acts[0], act_sizes[0], GCS_ACT_TORDERED);
+    }
+
+    /* older protocol members would assign a single seqno to a group */
+    if (conn->proto_ver < 2) return -EPROTONOSUPPORT;
+
+    size_t       grp_size = 0;
+    int          iov_num  = 0;
+    unsigned int i;
+
+    for (i = 0; i < act_num; ++i) {
+        assert (act_sizes[i] > 0);
+        grp_size += CORE_GRP_HDR_SIZE + act_sizes[i];
+        iov_num  += 1 + core_act_buf_num (acts[i], act_sizes[i]);
+    }
+
+    if (gu_unlikely(grp_size > GCS_MAX_ACT_SIZE)) return -EMSGSIZE;
+
+    if (!core_buf_reserve (&conn->grp_hdr, &conn->grp_hdr_len,
+                           act_num * CORE_GRP_HDR_SIZE) ||
+        !core_buf_reserve (&conn->grp_iov, &conn->grp_iov_len,
+                           iov_num * sizeof(struct gu_buf))) return -ENOMEM;
+
+    uint32_t*      const hdr = static_cast<uint32_t*>(conn->grp_hdr);
+    struct gu_buf* const iov = static_cast<struct gu_buf*>(conn->grp_iov);
+    int                  n   = 0;
+
+    for (i = 0; i < act_num; ++i) {
+        hdr[i] = htogl((uint32_t)act_sizes[i]);
+        iov[n].ptr  = &hdr[i];
+        iov[n].size = CORE_GRP_HDR_SIZE;
+        ++n;
+
+        const struct gu_buf* const act  = acts[i];
+        size_t                     left = act_sizes[i];
+
+        for (int k = 0; left > 0; ++k, ++n) {
+            iov[n].ptr  = act[k].ptr;
+            iov[n].size = size_t(act[k].size) < left ? act[k].size : left;
+            left -= iov[n].size;
+        }
+    }
+
+    assert (n == iov_num);
+
+    return core_send_act (conn, iov, grp_size, GCS_ACT_TORDERED,
+                          acts, act_sizes, act_num);
+}
+
 /* A helper for gcs_core_recv().
  * Deals with fetching complete message from backend
- * and reallocates recv buf if needed */
+ * and reallocates recv buf if needed.
+ * Backend may return message in its own memory instead of copying it to
+ * recv buf, so recv_msg->buf is reset to recv buf before every call. */
 static inline long
-core_msg_recv (gcs_backend_t* backend, gcs_recv_msg_t* recv_msg,
-               long long timeout)
+core_msg_recv (gcs_core_t* core, long long timeout)
 {
+    gcs_backend_t*  const backend  = &core->backend;
+    gcs_recv_msg_t* const recv_msg = &core->recv_msg;
     long ret;
 
+    recv_msg->buf     = core->recv_buf;
+    recv_msg->buf_len = core->recv_buf_len;
+
     ret = backend->recv (backend, recv_msg, timeout);
 
     while (gu_unlikely(ret > recv_msg->buf_len)) {
         /* recv_buf too small, reallocate */
         /* sometimes - like in case of component message, we may need to
          * do reallocation 2 times. This should be fixed in backend */
-        void* msg = gu_realloc (recv_msg->buf, ret);
+        void* msg = gu_realloc (core->recv_buf, ret);
         gu_debug ("Reallocating buffer from %d to %d bytes",
-                  recv_msg->buf_len, ret);
+                  core->recv_buf_len, ret);
         if (msg) {
             /* try again */
-            recv_msg->buf     = msg;
-            recv_msg->buf_len = ret;
+            core->recv_buf     = msg;
+            core->recv_buf_len = ret;
+            recv_msg->buf      = msg;
+            recv_msg->buf_len  = ret;
 
             ret = backend->recv (backend, recv_msg, timeout);
 
@@ -496,6 +832,215 @@ core_msg_recv (gcs_backend_t* backend, gcs_recv_msg_t* recv_msg,
     return ret;
 }
 
+/*!
+ * Replaces compressed action buffer with decompressed one.
+ *
+ * @return size of decompressed action or negative error code
+ */
+static ssize_t
+core_act_decompress (gcs_core_t* const core, struct gcs_act* const act)
+{
+#ifndef GCS_FOR_GARB
+    if (gu_unlikely(act->buf_len <= (ssize_t)CORE_COMP_HDR_SIZE)) {
+        return -EBADMSG;
+    }
+
+    const uint8_t* const comp = static_cast<const uint8_t*>(act->buf);
+    size_t const         size = gtohl(*(const uint32_t*)comp);
+
+    if (gu_unlikely(size > GCS_MAX_ACT_SIZE)) return -EMSGSIZE;
+
+    void* const buf = gcs_gcache_malloc (core->cache, size);
+
+    if (gu_unlikely(NULL == buf)) return -ENOMEM;
+
+    long long const start = gu_time_monotonic();
+    ssize_t   const ret   = gu_lz4_decompress (comp + CORE_COMP_HDR_SIZE,
+                                               act->buf_len -
+                                               CORE_COMP_HDR_SIZE,
+                                               buf, size);
+    core->decomp_ns += gu_time_monotonic() - start;
+
+    if (gu_unlikely(ret != (ssize_t)size)) {
+        gcs_gcache_free (core->cache, buf);
+        return (ret < 0 ? ret : -EBADMSG);
+    }
+
+    gcs_gcache_free (core->cache, act->buf);
+
+    act->buf     = buf;
+    act->buf_len = size;
+
+    core->decomp_acts++;
+#endif /* GCS_FOR_GARB */
+
+    /* garbd does not store action contents */
+    return act->buf_len;
+}
+
+#ifndef GCS_FOR_GARB
+/*!
+ * A helper for core_act_ungroup(). Copies members of action group received
+ * in a single buffer to individual buffers and releases the group buffer.
+ *
+ * @return 0 or negative error code
+ */
+static ssize_t
+core_grp_copy (gcs_core_t*                const core,
+               const struct gcs_act_rcvd* const act,
+               struct gcs_act_rcvd*       const grp,
+               unsigned int               const num)
+{
+    const uint8_t*       ptr = static_cast<const uint8_t*>(act->act.buf);
+    const uint8_t* const end = ptr + act->act.buf_len;
+    unsigned int         i;
+
+    for (i = 0; i < num; ++i) {
+        uint32_t size;
+
+        if (gu_unlikely(end - ptr < ssize_t(CORE_GRP_HDR_SIZE))) break;
+        memcpy (&size, ptr, sizeof(size));
+        size = gtohl(size);
+        ptr += CORE_GRP_HDR_SIZE;
+        if (gu_unlikely(0 == size || end - ptr < ssize_t(size))) break;
+
+        /* members are cached and released individually */
+        void* const buf = gcs_gcache_malloc (core->cache, size);
+
+        if (gu_unlikely(NULL == buf)) {
+            gu_fatal ("Out of memory for action of size %u", size);
+            return -ENOMEM;
+        }
+
+        memcpy (buf, ptr, size);
+        ptr += size;
+
+        grp[i] = gcs_act_rcvd(gcs_act(buf, size, act->act.type), NULL,
+                              act->id > 0 ? act->id + i : act->id,
+                              act->sender_idx);
+    }
+
+    if (gu_unlikely(i < num || ptr != end)) {
+        gu_fatal ("Malformed group of %u actions: member %u of %zd bytes",
+                  num, i, act->act.buf_len);
+        return -ENOTRECOVERABLE;
+    }
+
+    gcs_gcache_free (core->cache, act->act.buf);
+
+    return 0;
+}
+#endif /* GCS_FOR_GARB */
+
+/*!
+ * Splits received action group into member actions with consecutive seqnos.
+ * The first one is returned in act, the rest are returned by subsequent
+ * gcs_core_recv() calls.
+ *
+ * @return size of the first member action or negative error code
+ */
+static ssize_t
+core_act_ungroup (gcs_core_t*           const core,
+                  const gcs_act_frag_t* const frg,
+                  struct gcs_act_rcvd*  const act,
+                  bool                  const local)
+{
+    unsigned int const num = frg->act_num;
+    unsigned int       i;
+
+    assert (num > 1);
+    assert (core->grp_next >= core->grp_num);
+
+    if (gu_unlikely(GCS_ACT_TORDERED != act->act.type ||
+                    size_t(act->act.buf_len) < num * CORE_GRP_HDR_SIZE)) {
+        gu_fatal ("Malformed group of %u actions: type %s, size %zd",
+                  num, gcs_act_type_to_str(act->act.type), act->act.buf_len);
+        return -ENOTRECOVERABLE;
+    }
+
+    if (!core_buf_reserve (&core->grp_acts, &core->grp_acts_len,
+                           num * sizeof(struct gcs_act_rcvd))) {
+        gu_fatal ("Out of memory for group of %u actions", num);
+        return -ENOMEM;
+    }
+
+    struct gcs_act_rcvd* const grp =
+        static_cast<struct gcs_act_rcvd*>(core->grp_acts);
+
+#ifndef GCS_FOR_GARB
+    if (gcs_defrag_split (frg)) {
+        /* members are already in own buffers, see gcs_defrag_split() */
+        const struct gcs_act* const members =
+            static_cast<const struct gcs_act*>(act->act.buf);
+
+        for (i = 0; i < num; ++i) {
+            grp[i] = gcs_act_rcvd(members[i], NULL,
+                                  act->id > 0 ? act->id + i : act->id,
+                                  act->sender_idx);
+        }
+
+        gu_free (const_cast<struct gcs_act*>(members));
+    }
+    else {
+        /* compressed group is decompressed into a single buffer */
+        ssize_t const ret = core_grp_copy (core, act, grp, num);
+
+        if (gu_unlikely(ret < 0)) return ret;
+    }
+#else
+    /* actions are not stored here, only seqnos matter */
+    ssize_t const size = act->act.buf_len / num;
+
+    for (i = 0; i < num; ++i) {
+        grp[i] = gcs_act_rcvd(gcs_act(NULL, i + 1 < num ? size :
+                                      act->act.buf_len - size * (num - 1),
+                                      act->act.type), NULL,
+                              act->id > 0 ? act->id + i : act->id,
+                              act->sender_idx);
+    }
+#endif /* GCS_FOR_GARB */
+
+    if (local) {
+        /* local actions, get from FIFO in the order they were sent */
+        for (i = 0; i < num; ++i) {
+            core_act_t* const local_act =
+                static_cast<core_act_t*>(gcs_fifo_lite_get_head (core->fifo));
+
+            if (gu_unlikely(NULL == local_act)) {
+                gu_fatal ("FIFO violation: queue empty when local action "
+                          "received");
+                return -ENOTRECOVERABLE;
+            }
+
+            grp[i].local = static_cast<const struct gu_buf*>(local_act->action);
+            gcs_seqno_t const sent_act_id = local_act->sent_act_id;
+            size_t      const sent_size   = local_act->action_size;
+            gcs_fifo_lite_pop_head (core->fifo);
+
+            if (gu_unlikely(sent_act_id != frg->act_id)) {
+                gu_fatal ("FIFO violation: expected sent_act_id %lld "
+                          "found %lld", sent_act_id, frg->act_id);
+                return -ENOTRECOVERABLE;
+            }
+            if (gu_unlikely(size_t(grp[i].act.buf_len) != sent_size)) {
+                gu_fatal ("Send/recv action size mismatch: %zu/%zd",
+                          sent_size, grp[i].act.buf_len);
+                return -ENOTRECOVERABLE;
+            }
+
+            if (gu_unlikely(CORE_PRIMARY != core->state && grp[i].id < 0)) {
+                grp[i].id = core_error (core->state);
+            }
+        }
+    }
+
+    *act           = grp[0];
+    core->grp_num  = num;
+    core->grp_next = 1;
+
+    return act->act.buf_len;
+}
+
 /*!
  * Helper for gcs_core_recv(). Handles GCS_MSG_ACTION.
  *
@@ -544,6 +1089,18 @@ core_handle_act_msg (gcs_core_t*          core,
         ret = gcs_group_handle_act_msg (group, &frg, msg, act,
                                         commonly_supported_version);
 
+        if (ret > 0 && (frg.flags & GCS_ACT_FLAG_COMPRESSED)) {
+            ret = core_act_decompress (core, &act->act);
+
+            if (gu_unlikely(ret < 0)) {
+                gu_fatal ("Failed to decompress action %lld of size %zd: "
+                          "%zd (%s)", frg.act_id, act->act.buf_len,
+                          ret, strerror (-ret));
+                assert (0);
+                return -ENOTRECOVERABLE;
+            }
+        }
+
         if (ret > 0) { /* complete action received */
             assert (act->act.buf_len == ret);
 #ifndef GCS_FOR_GARB
@@ -553,7 +1110,10 @@ core_handle_act_msg (gcs_core_t*          core,
 #endif
             act->sender_idx = msg->sender_idx;
 
-            if (gu_likely(!my_msg)) {
+            if (gu_unlikely(frg.act_num > 1)) {
+                ret = core_act_ungroup (core, &frg, act, my_msg);
+            }
+            else if (gu_likely(!my_msg)) {
                 /* foreign action, must be passed from gcs_group */
                 assert (GCS_ACT_TORDERED != act->act.type || act->id > 0);
             }
@@ -697,6 +1257,42 @@ core_handle_last_msg (gcs_core_t*          core,
     return 0;
 }
 
+/*! Completes causal barrier and wakes up its waiters. Barriers already
+ *  completed by core_caused_abort() are ignored.
+ *  Must be called with caused_lock held. */
+static void
+core_caused_done (gcs_core_t* const conn,
+                  long long   const barrier,
+                  gcs_seqno_t const seqno)
+{
+    if (gu_unlikely(barrier <= conn->caused_done)) return;
+
+    assert (barrier == conn->caused_done + 1);
+    assert (barrier == conn->caused_sent);
+
+    conn->caused_done  = barrier;
+    conn->caused_seqno = seqno;
+    gu_cond_broadcast (&conn->caused_cond);
+}
+
+/*! Completes barrier in flight with error: its message may never be
+ *  delivered, so nobody must wait for it. Callers waiting for the next
+ *  barrier get the error too instead of sending it to a dead connection. */
+static void
+core_caused_abort (gcs_core_t* const conn, gcs_seqno_t const err)
+{
+    gu_mutex_lock (&conn->caused_lock);
+
+    if (conn->caused_done < conn->caused_sent) {
+        conn->caused_sent++;
+        conn->caused_done  = conn->caused_sent;
+        conn->caused_seqno = err;
+        gu_cond_broadcast (&conn->caused_cond);
+    }
+
+    gu_mutex_unlock (&conn->caused_lock);
+}
+
 /*!
  * Helper for gcs_core_recv(). Handles GCS_MSG_COMPONENT.
  *
@@ -814,6 +1410,7 @@ core_handle_comp_msg (gcs_core_t*          core,
             }
         }
         gu_mutex_unlock (&core->send_lock);
+        core_caused_abort (core, -ENOTCONN);
         assert (ret == act->buf_len || ret < 0);
         break;
     case GCS_GROUP_WAIT_STATE_MSG:
@@ -1024,7 +1621,7 @@ core_msg_to_action (gcs_core_t*          core,
 static long core_msg_causal(gcs_core_t* conn,
                             struct gcs_recv_msg* msg)
 {
-    causal_act_t* act;
+    const causal_act_t* act;
     if (gu_unlikely(msg->size != sizeof(*act)))
     {
         gu_error("invalid causal act len %ld, expected %ld",
@@ -1036,11 +1633,10 @@ static long core_msg_causal(gcs_core_t* conn,
         GCS_GROUP_PRIMARY == conn->group.state ?
         conn->group.act_id_ : GCS_SEQNO_ILL;
 
-    act = (causal_act_t*)msg->buf;
-    gu_mutex_lock(act->mtx);
-    *act->act_id = causal_seqno;
-    gu_cond_signal(act->cond);
-    gu_mutex_unlock(act->mtx);
+    act = (const causal_act_t*)msg->buf;
+    gu_mutex_lock(&conn->caused_lock);
+    core_caused_done(conn, act->barrier, causal_seqno);
+    gu_mutex_unlock(&conn->caused_lock);
     return msg->size;
 }
 
@@ -1061,6 +1657,13 @@ ssize_t gcs_core_recv (gcs_core_t*          conn,
         -1,   // GCS_SEQNO_ILL
         -1);
 
+    if (gu_unlikely(conn->grp_next < conn->grp_num)) {
+        /* return the next member of the received action group */
+        *recv_act = static_cast<struct gcs_act_rcvd*>(conn->grp_acts)
+            [conn->grp_next++];
+        return recv_act->act.buf_len;
+    }
+
     *recv_act = zero_act;
 
     /* receive messages from group and demultiplex them
@@ -1073,7 +1676,7 @@ ssize_t gcs_core_recv (gcs_core_t*          conn,
         assert (recv_act->id          == GCS_SEQNO_ILL);
         assert (recv_act->sender_idx  == -1);
 
-        ret = core_msg_recv (&conn->backend, recv_msg, timeout);
+        ret = core_msg_recv (conn, timeout);
         if (gu_unlikely (ret <= 0)) {
             goto out; /* backend error while receiving message */
         }
@@ -1171,6 +1774,8 @@ long gcs_core_close (gcs_core_t* core)
 
     gu_mutex_unlock (&core->send_lock);
 
+    core_caused_abort (core, -ENOTCONN);
+
     return ret;
 }
 
@@ -1209,9 +1814,17 @@ long gcs_core_destroy (gcs_core_t* core)
     gcs_fifo_lite_destroy (core->fifo);
     gcs_group_free (&core->group);
 
+    gu_cond_destroy  (&core->caused_cond);
+    gu_mutex_destroy (&core->caused_lock);
+
     /* free buffers */
-    gu_free (core->recv_msg.buf);
+    gu_free (core->recv_buf);
     gu_free (core->send_buf);
+    gu_free (core->comp_src);
+    gu_free (core->comp_buf);
+    gu_free (core->grp_hdr);
+    gu_free (core->grp_iov);
+    gu_free (core->grp_acts);
 
 #ifdef GCS_CORE_TESTING
     gu_lock_step_destroy (&core->ls);
@@ -1285,6 +1898,13 @@ gcs_core_set_pkt_size (gcs_core_t* core, long pkt_size)
     return ret;
 }
 
+void
+gcs_core_set_compress (gcs_core_t* core, size_t min_size)
+{
+    /* read once per action by the sending thread, no need to lock */
+    core->comp_min_size = min_size;
+}
+
 static inline long
 core_send_seqno (gcs_core_t* core, gcs_seqno_t seqno, gcs_msg_type_t msg_type)
 {
@@ -1332,33 +1952,46 @@ gcs_core_send_fc (gcs_core_t* core, const void* fc, size_t fc_size)
 gcs_seqno_t
 gcs_core_caused(gcs_core_t* core)
 {
-    long         ret;
-    gcs_seqno_t  act_id = GCS_SEQNO_ILL;
-    gu_mutex_t   mtx;
-    gu_cond_t    cond;
-    causal_act_t act = {&act_id, &mtx, &cond};
-
-    gu_mutex_init (&mtx, NULL);
-    gu_cond_init  (&cond, NULL);
-    gu_mutex_lock (&mtx);
+    gcs_seqno_t ret;
+
+    gu_mutex_lock (&core->caused_lock);
     {
-        ret = core_msg_send_retry (core, &act, sizeof(act), GCS_MSG_CAUSAL);
+        /* The barrier in flight could have been ordered before the writes
+         * this caller must see, so wait for the one sent after this point.
+         * All callers that arrive while a barrier is in flight share the
+         * next one. */
+        long long const barrier = core->caused_sent + 1;
 
-        if (ret == sizeof(act))
+        while (core->caused_done < barrier)
         {
-            gu_cond_wait (&cond, &mtx);
-        }
-        else
-        {
-            assert (ret < 0);
-            act_id = ret;
+            if (core->caused_sent == core->caused_done)
+            {
+                /* nothing in flight, send barrier for all waiters */
+                causal_act_t const act = { ++core->caused_sent };
+
+                gu_mutex_unlock (&core->caused_lock);
+                long const err = core_msg_send_retry (core, &act, sizeof(act),
+                                                      GCS_MSG_CAUSAL);
+                gu_mutex_lock (&core->caused_lock);
+
+                if (err != sizeof(act))
+                {
+                    assert (err < 0);
+                    core_caused_done (core, act.barrier, err);
+                }
+            }
+            else
+            {
+                gu_cond_wait (&core->caused_cond, &core->caused_lock);
+            }
         }
+
+        /* can be the result of a later barrier, still good for causality */
+        ret = core->caused_seqno;
     }
-    gu_mutex_unlock  (&mtx);
-    gu_mutex_destroy (&mtx);
-    gu_cond_destroy  (&cond);
+    gu_mutex_unlock (&core->caused_lock);
 
-    return act_id;
+    return ret;
 }
 
 long
@@ -1391,6 +2024,16 @@ void gcs_core_get_status(gcs_core_t* core, gu::Status& status)
     {
         core->backend.status_get(&core->backend, status);
     }
+
+    double const ratio(core->comp_in > 0 ?
+                       double(core->comp_out) / core->comp_in : 1.0);
+
+    status.insert("gcs_compressed_actions", gu::to_string(core->comp_acts));
+    status.insert("gcs_compress_ratio",     gu::to_string(ratio));
+    status.insert("gcs_compress_ns",        gu::to_string(core->comp_ns));
+    status.insert("gcs_decompressed_actions",
+                  gu::to_string(core->decomp_acts));
+    status.insert("gcs_decompress_ns",      gu::to_string(core->decomp_ns));
     gu_mutex_unlock(&core->send_lock);
 }
 
@@ -105,6 +105,25 @@ gcs_core_send (gcs_core_t*          core,
                size_t               act_size,
                gcs_act_type_t       act_type);
 
+/*
+ * gcs_core_send_group() atomically sends a group of GCS_ACT_TORDERED actions
+ * to group in one message. Every member action is delivered separately with
+ * its own global seqno, in the order of acts array.
+ *
+ * NOT THREAD SAFE! Access should be serialized.
+ *
+ * Return values:
+ * non-negative - total size of member actions sent
+ * negative     - error code as in gcs_core_send()
+ *                -EPROTONOSUPPORT - group protocol version does not support
+ *                                   action groups, send actions one by one
+ */
+extern ssize_t
+gcs_core_send_group (gcs_core_t*                core,
+                     const struct gu_buf* const* acts,
+                     const size_t*              act_sizes,
+                     unsigned int               act_num);
+
 /*
  * gcs_core_recv() blocks until some action is received from group.
  *
@@ -138,6 +157,11 @@ gcs_core_group_protocol_version (const gcs_core_t* conn);
 extern long
 gcs_core_set_pkt_size (gcs_core_t* conn, long pkt_size);
 
+/* Enables compression of actions of at least min_size bytes (0 disables).
+ * Takes effect only if all group members support it. */
+extern void
+gcs_core_set_compress (gcs_core_t* core, size_t min_size);
+
 /* sends this node's last applied value to group */
 extern long
 gcs_core_set_last_applied (gcs_core_t* core, gcs_seqno_t seqno);
@@ -154,6 +178,8 @@ gcs_core_send_sync (gcs_core_t* core, gcs_seqno_t seqno);
 extern long
 gcs_core_send_fc (gcs_core_t* core, const void* fc, size_t fc_size);
 
+/* returns global seqno of a barrier ordered after this call, concurrent
+ * callers share one barrier message */
 extern gcs_seqno_t
 gcs_core_caused(gcs_core_t* core);
 
@@ -10,6 +10,8 @@
 #include <unistd.h>
 #include <string.h>
 
+#include <algorithm>
+
 #define DF_ALLOC()                                              \
     do {                                                        \
         df->head = static_cast<uint8_t*>(gcs_gcache_malloc (df->cache, df->size)); \
@@ -24,6 +26,101 @@
         }                                                       \
     } while (0)
 
+#define DF_GRP_ALLOC()                                          \
+    do {                                                        \
+        df->grp = static_cast<struct gcs_act*>(                 \
+            gu_malloc (frg->act_num * sizeof(struct gcs_act))); \
+                                                                \
+        if(gu_likely(df->grp != NULL)) {                        \
+            df->grp_num     = frg->act_num;                     \
+            df->grp_idx     = 0;                                \
+            df->grp_hdr_len = 0;                                \
+        }                                                       \
+        else {                                                  \
+            gu_error ("Could not allocate memory for new "      \
+                      "group of %u actions", frg->act_num);     \
+            assert(0);                                          \
+            return -ENOMEM;                                     \
+        }                                                       \
+    } while (0)
+
+/*!
+ * Copies fragment of action group to member buffers, allocating every
+ * member from cache as soon as its size is received.
+ *
+ * @return 0 - success, negative - error.
+ */
+static ssize_t
+df_grp_copy (gcs_defrag_t* const df, const gcs_act_frag_t* const frg)
+{
+    const uint8_t* ptr  = static_cast<const uint8_t*>(frg->frag);
+    size_t         left = frg->frag_len;
+
+    while (left > 0) {
+
+        if (df->grp_hdr_len < GCS_DEFRAG_GRP_HDR_SIZE) {
+            /* member size may be split between fragments */
+            size_t const len (std::min (left, GCS_DEFRAG_GRP_HDR_SIZE -
+                                        df->grp_hdr_len));
+
+            memcpy (df->grp_hdr + df->grp_hdr_len, ptr, len);
+            df->grp_hdr_len += len;
+            ptr             += len;
+            left            -= len;
+
+            if (df->grp_hdr_len < GCS_DEFRAG_GRP_HDR_SIZE) break;
+
+            uint32_t size;
+            memcpy (&size, df->grp_hdr, sizeof(size));
+            size = gtohl(size);
+
+            /* bytes of the action following member size */
+            size_t const rest (df->size - (df->received - left));
+
+            if (gu_unlikely(df->grp_idx == df->grp_num || 0 == size ||
+                            size > rest)) {
+                gu_error ("Malformed group of %u actions: member %u of %u "
+                          "bytes, %zu bytes left", df->grp_num, df->grp_idx,
+                          size, rest);
+                df->grp_hdr_len = 0; // nothing allocated for this member
+                assert(0);
+                return -EPROTO;
+            }
+
+            void* const buf (gcs_gcache_malloc (df->cache, size));
+
+            if (gu_unlikely(NULL == buf)) {
+                gu_error ("Could not allocate memory for group member "
+                          "of size: %u", size);
+                df->grp_hdr_len = 0;
+                assert(0);
+                return -ENOMEM;
+            }
+
+            df->grp[df->grp_idx] = gcs_act(buf, size, frg->act_type);
+            df->tail             = static_cast<uint8_t*>(buf);
+            df->grp_left         = size;
+        }
+        else {
+            size_t const len (std::min (left, df->grp_left));
+
+            memcpy (df->tail, ptr, len);
+            df->tail     += len;
+            df->grp_left -= len;
+            ptr          += len;
+            left         -= len;
+
+            if (0 == df->grp_left) {
+                /* member complete, next one starts with its size */
+                df->grp_idx++;
+                df->grp_hdr_len = 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
 /*!
  * Handle action fragment
  *
@@ -66,6 +163,16 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                 df->tail     = df->head;
                 df->reset    = false;
 
+#ifndef GCS_FOR_GARB
+                if (df->grp != NULL) {
+                    /* resent action is the same group */
+                    assert (gcs_defrag_split (frg));
+                    gcs_defrag_free_split (df);
+                    df->size = frg->act_size;
+                    DF_GRP_ALLOC();
+                }
+                else
+#endif /* GCS_FOR_GARB */
                 if (df->size != frg->act_size) {
 
                     df->size = frg->act_size;
@@ -111,7 +218,12 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
             df->reset   = false;
 
 #ifndef GCS_FOR_GARB
-            DF_ALLOC();
+            if (gcs_defrag_split (frg)) {
+                DF_GRP_ALLOC();
+            }
+            else {
+                DF_ALLOC();
+            }
 #else
             /* we don't store actions locally at all */
             df->head = NULL;
@@ -128,12 +240,12 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                 return 0;
             }
             else {
-                ((char*)frg->frag)[frg->frag_len - 1] = '\0';
                 gu_error ("Unordered fragment received. Protocol error.");
                 gu_error ("Expected: any:0(first), received: %lld:%ld",
                           frg->act_id, frg->frag_no);
-                gu_error ("Contents: '%s', local: %s, reset: %s",
-                          (char*)frg->frag, local ? "yes" : "no",
+                gu_error ("Contents: '%.*s', local: %s, reset: %s",
+                          (int)frg->frag_len, (char*)frg->frag,
+                          local ? "yes" : "no",
                           df->reset ? "yes" : "no");
                 assert(0);
                 return -EPROTO;
@@ -145,9 +257,16 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
     assert (df->received <= df->size);
 
 #ifndef GCS_FOR_GARB
-    assert (df->tail);
-    memcpy (df->tail, frg->frag, frg->frag_len);
-    df->tail += frg->frag_len;
+    if (df->grp != NULL) {
+        ssize_t const ret (df_grp_copy (df, frg));
+
+        if (gu_unlikely(ret < 0)) return ret;
+    }
+    else {
+        assert (df->tail);
+        memcpy (df->tail, frg->frag, frg->frag_len);
+        df->tail += frg->frag_len;
+    }
 #else
     /* we skip memcpy since have not allocated any buffer */
     assert (NULL == df->tail);
@@ -158,6 +277,18 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
     if (df->received == df->size) {
         act->buf     = df->head;
         act->buf_len = df->received;
+#ifndef GCS_FOR_GARB
+        if (df->grp != NULL) {
+            if (gu_unlikely(df->grp_idx != df->grp_num)) {
+                gu_error ("Malformed group of %u actions: %u received",
+                          df->grp_num, df->grp_idx);
+                assert(0);
+                return -EPROTO;
+            }
+
+            act->buf = df->grp;
+        }
+#endif /* GCS_FOR_GARB */
         gcs_defrag_init (df, df->cache);
         return act->buf_len;
     }
@@ -29,9 +29,38 @@ typedef struct gcs_defrag
     size_t         received;
     ulong          frag_no; // number of fragment received
     bool           reset;
+    struct gcs_act* grp;        // members of split action group
+    unsigned int   grp_num;     // number of group members
+    unsigned int   grp_idx;     // member being received
+    size_t         grp_left;    // bytes of the member yet to be received
+    size_t         grp_hdr_len; // bytes of the member size received
+    uint8_t        grp_hdr[sizeof(uint32_t)];
 }
 gcs_defrag_t;
 
+/*
+ * Action group is a sequence of member actions, each preceded by its size
+ * (4 bytes, little-endian). Number of members is carried in action header.
+ */
+static size_t const GCS_DEFRAG_GRP_HDR_SIZE = sizeof(uint32_t);
+
+/*!
+ * Returns true if action group members are received into separate buffers:
+ * uncompressed group is split as it is defragmented, so that every member
+ * is copied only once. Such group is returned as an array of frg->act_num
+ * member actions in act->buf, see gcs_defrag_free_group().
+ */
+static inline bool
+gcs_defrag_split (const gcs_act_frag_t* frg)
+{
+#ifndef GCS_FOR_GARB
+    return (frg->act_num > 1 && !(frg->flags & GCS_ACT_FLAG_COMPRESSED));
+#else
+    /* garbd does not store action contents */
+    return false;
+#endif
+}
+
 static inline void
 gcs_defrag_init (gcs_defrag_t* df, gcache_t* cache)
 {
@@ -53,6 +82,31 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                         struct gcs_act*       act,
                         bool                  local);
 
+/*! Free members of a split action group and the member array itself */
+static inline void
+gcs_defrag_free_group (gcache_t*             cache,
+                       const struct gcs_act* grp,
+                       unsigned int          num)
+{
+    for (unsigned int i = 0; i < num; ++i) {
+        gcs_gcache_free (cache, grp[i].buf);
+    }
+
+    gu_free (const_cast<struct gcs_act*>(grp));
+}
+
+/*! Free members of the split action group being received */
+static inline void
+gcs_defrag_free_split (gcs_defrag_t* df)
+{
+    /* member being received is allocated once its size is complete */
+    bool const partial (df->grp_idx < df->grp_num &&
+                        GCS_DEFRAG_GRP_HDR_SIZE == df->grp_hdr_len);
+
+    gcs_defrag_free_group (df->cache, df->grp, df->grp_idx + partial);
+    df->grp = NULL;
+}
+
 /*! Deassociate, but don't deallocate action resources */
 static inline void
 gcs_defrag_forget (gcs_defrag_t* df)
@@ -65,7 +119,10 @@ static inline void
 gcs_defrag_free (gcs_defrag_t* df)
 {
 #ifndef GCS_FOR_GARB
-    if (df->head) {
+    if (df->grp) {
+        gcs_defrag_free_split (df);
+    }
+    else if (df->head) {
         gcs_gcache_free (df->cache, df->head);
         // df->head, df->tail will be zeroed in gcs_defrag_init() below
     }
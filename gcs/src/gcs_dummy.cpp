@@ -17,6 +17,8 @@
 
 #include <galerautils.h>
 
+#include <algorithm>
+
 #define GCS_COMP_MSG_ACCESS // for gcs_comp_memb_t
 
 #ifndef GCS_DUMMY_TESTING
@@ -35,16 +37,24 @@ typedef struct dummy_msg
 dummy_msg_t;
 
 static inline dummy_msg_t*
-dummy_msg_create (gcs_msg_type_t const type,
-                  size_t         const len,
-                  long           const sender,
-                  const void*    const buf)
+dummy_msg_create (gcs_msg_type_t       const type,
+                  size_t               const len,
+                  long                 const sender,
+                  const struct gu_buf* const bufs)
 {
     dummy_msg_t *msg = NULL;
 
     if ((msg = static_cast<dummy_msg_t*>(gu_malloc (sizeof(dummy_msg_t) + len))))
     {
-        memcpy (msg->buf, buf, len);
+        size_t off = 0;
+
+        for (int i = 0; off < len; ++i) // gather first len bytes of bufs
+        {
+            size_t const n = std::min<size_t>(bufs[i].size, len - off);
+            memcpy (msg->buf + off, bufs[i].ptr, n);
+            off += n;
+        }
+
         msg->len        = len;
         msg->type       = type;
         msg->sender_idx = sender;
@@ -102,8 +112,42 @@ GCS_BACKEND_DESTROY_FN(dummy_destroy)
     return 0;
 }
 
+static long
+dummy_inject_v (gcs_backend_t*       const backend,
+                const struct gu_buf* const bufs,
+                size_t               const len,
+                gcs_msg_type_t       const type,
+                long                 const sender_idx)
+{
+    long         ret;
+    size_t       send_size = len < backend->conn->max_send_size ?
+                             len : backend->conn->max_send_size;
+    dummy_msg_t* msg = dummy_msg_create (type, send_size, sender_idx, bufs);
+
+    if (msg)
+    {
+        dummy_msg_t** ptr = static_cast<dummy_msg_t**>(
+            gu_fifo_get_tail (backend->conn->gc_q));
+
+        if (gu_likely(ptr != NULL)) {
+            *ptr = msg;
+            gu_fifo_push_tail (backend->conn->gc_q);
+            ret = send_size;
+        }
+        else {
+            dummy_msg_destroy (msg);
+            ret = -EBADFD; // closed
+        }
+    }
+    else {
+        ret = -ENOMEM;
+    }
+
+    return ret;
+}
+
 static
-GCS_BACKEND_SEND_FN(dummy_send)
+GCS_BACKEND_SEND_V_FN(dummy_send_v)
 {
     int err = 0;
     dummy_t* dummy = backend->conn;
@@ -112,8 +156,8 @@ GCS_BACKEND_SEND_FN(dummy_send)
 
     if (gu_likely(DUMMY_PRIM == dummy->state))
     {
-        err = gcs_dummy_inject_msg (backend, buf, len, msg_type,
-                                    backend->conn->my_idx);
+        err = dummy_inject_v (backend, bufs, len, msg_type,
+                              backend->conn->my_idx);
     }
     else {
         static long send_error[DUMMY_PRIM] =
@@ -124,6 +168,14 @@ GCS_BACKEND_SEND_FN(dummy_send)
     return err;
 }
 
+static
+GCS_BACKEND_SEND_FN(dummy_send)
+{
+    struct gu_buf const b = { buf, static_cast<ssize_t>(len) };
+
+    return dummy_send_v (backend, &b, 1, len, msg_type);
+}
+
 static
 GCS_BACKEND_RECV_FN(dummy_recv)
 {
@@ -298,6 +350,7 @@ GCS_BACKEND_CREATE_FN(gcs_dummy_create)
     backend->close     = dummy_close;
     backend->destroy   = dummy_destroy;
     backend->send      = dummy_send;
+    backend->send_v    = dummy_send_v;
     backend->recv      = dummy_recv;
     backend->name      = dummy_name;
     backend->msg_size  = dummy_msg_size;
@@ -326,31 +379,9 @@ gcs_dummy_inject_msg (gcs_backend_t* backend,
                       gcs_msg_type_t type,
                       long           sender_idx)
 {
-    long         ret;
-    size_t       send_size = buf_len < backend->conn->max_send_size ?
-                             buf_len : backend->conn->max_send_size;
-    dummy_msg_t* msg = dummy_msg_create (type, send_size, sender_idx, buf);
-
-    if (msg)
-    {
-        dummy_msg_t** ptr = static_cast<dummy_msg_t**>(
-            gu_fifo_get_tail (backend->conn->gc_q));
-
-        if (gu_likely(ptr != NULL)) {
-            *ptr = msg;
-            gu_fifo_push_tail (backend->conn->gc_q);
-            ret = send_size;
-        }
-        else {
-            dummy_msg_destroy (msg);
-            ret = -EBADFD; // closed
-        }
-    }
-    else {
-        ret = -ENOMEM;
-    }
+    struct gu_buf const b = { buf, static_cast<ssize_t>(buf_len) };
 
-    return ret;
+    return dummy_inject_v (backend, &b, buf_len, type, sender_idx);
 }
 
 /*! Sets the new component view.
@@ -204,3 +204,193 @@ gcs_fc_process (gcs_fc_t* fc, ssize_t act_size)
 }
 
 void gcs_fc_debug (gcs_fc_t* fc, long debug_level) { fc->debug = debug_level; }
+
+static long long const meter_period = 100000000LL; //! sample length (ns)
+
+void
+gcs_fc_meter_init (gcs_fc_meter_t* const m, long long const now)
+{
+    m->start = now;
+    m->count = 0;
+    m->rate  = -1.0; // not measured yet
+}
+
+void
+gcs_fc_meter_add (gcs_fc_meter_t* const m, long long const now)
+{
+    m->count++;
+
+    long long const elapsed(now - m->start);
+
+    if (elapsed >= meter_period) {
+        double const rate(m->count * 1.0e9 / elapsed);
+
+        m->rate  = m->rate < 0.0 ? rate : (m->rate + rate) * 0.5;
+        m->start = now;
+        m->count = 0;
+    }
+}
+
+void
+gcs_fc_meter_restart (gcs_fc_meter_t* const m, long long const now)
+{
+    m->start = now;
+    m->count = 0;
+}
+
+double
+gcs_fc_meter_rate (const gcs_fc_meter_t* const m, long long const now)
+{
+    long long const elapsed(now - m->start);
+
+    if (elapsed >= meter_period) {
+        double const rate(m->count * 1.0e9 / elapsed);
+        if (m->rate < 0.0 || rate < m->rate) return rate;
+    }
+
+    return m->rate < 0.0 ? 0.0 : m->rate;
+}
+
+static double const drain_margin = 0.9; //! fraction of rate to advertise
+static double const drain_period = 1.0; //! time to drain the excess (s)
+
+double
+gcs_fc_drain_rate (double const rate, long const queue_len, long const target)
+{
+    double const excess(queue_len > target ? queue_len - target : 0);
+    double const ret(rate * drain_margin - excess / drain_period);
+
+    return (ret > 0.0 ? ret : 0.0);
+}
+
+void
+gcs_fc_pacer_init (gcs_fc_pacer_t* const p, long long const now)
+{
+    memset (p, 0, sizeof(*p));
+    p->sample_start = now;
+}
+
+void
+gcs_fc_pacer_set (gcs_fc_pacer_t* const p, long long const interval)
+{
+    assert (interval >= 0);
+    gu_atomic_set (&p->interval, &interval);
+}
+
+long long
+gcs_fc_pacer_delay (gcs_fc_pacer_t* const p, long long const now)
+{
+    long long interval;
+    gu_atomic_get (&p->interval, &interval);
+
+    if (gu_likely(0 == interval)) return 0;
+
+    /* no credit is accumulated for idle periods: a burst after a pause
+     * is paced too */
+    if (p->next < now) p->next = now;
+
+    long long const ret(p->next - now);
+
+    p->next += interval;
+
+    return ret;
+}
+
+void
+gcs_fc_pacer_reserve (gcs_fc_pacer_t* const p, long long const now,
+                      long const n)
+{
+    assert (n >= 0);
+
+    long long interval;
+    gu_atomic_get (&p->interval, &interval);
+
+    if (gu_likely(0 == interval)) return;
+
+    if (p->next < now) p->next = now;
+
+    p->next += interval * n;
+}
+
+void
+gcs_fc_pacer_stats_get (const gcs_fc_pacer_t* const p, long long const now,
+                        long long* const throttled_ns,
+                        double*    const throttled_avg)
+{
+    *throttled_ns = p->throttled_ns;
+
+    if (gu_likely(now > p->sample_start)) {
+        *throttled_avg = double(p->throttled_ns - p->throttled_sample) /
+            (now - p->sample_start);
+    }
+    else {
+        *throttled_avg = 0.0;
+    }
+}
+
+void
+gcs_fc_pacer_stats_flush (gcs_fc_pacer_t* const p, long long const now)
+{
+    p->sample_start     = now;
+    p->throttled_sample = p->throttled_ns;
+}
+
+void
+gcs_fc_rates_init (gcs_fc_rates_t* const r)
+{
+    r->memb     = NULL;
+    r->memb_num = 0;
+}
+
+void
+gcs_fc_rates_free (gcs_fc_rates_t* const r)
+{
+    gu_free (r->memb);
+    gcs_fc_rates_init (r);
+}
+
+int
+gcs_fc_rates_reset (gcs_fc_rates_t* const r, long const memb_num)
+{
+    if (memb_num != r->memb_num) {
+        void* const tmp(gu_realloc (r->memb, memb_num * sizeof(*r->memb)));
+
+        if (!tmp && memb_num > 0) return -ENOMEM;
+
+        r->memb     = static_cast<gcs_fc_memb_rate_t*>(tmp);
+        r->memb_num = memb_num;
+    }
+
+    if (memb_num > 0) memset (r->memb, 0, memb_num * sizeof(*r->memb));
+
+    return 0;
+}
+
+double
+gcs_fc_rates_update (gcs_fc_rates_t* const r, long const idx,
+                     uint32_t const stop)
+{
+    if (gu_likely(idx >= 0 && idx < r->memb_num)) {
+        gcs_fc_memb_rate_t* const m(&r->memb[idx]);
+
+        if (stop) {
+            /* the latest STOP carries the member's current rate, CONT that
+             * follows a re-advertising STOP does not revoke it */
+            m->stops++;
+            m->rate = stop - 1;
+        }
+        else if (m->stops > 0) {
+            m->stops--;
+        }
+    }
+
+    double ret(-1.0);
+
+    for (long i(0); i < r->memb_num; ++i) {
+        if (r->memb[i].stops > 0 && (ret < 0.0 || r->memb[i].rate < ret)) {
+            ret = r->memb[i].rate;
+        }
+    }
+
+    return ret;
+}
@@ -13,6 +13,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
 
 typedef struct gcs_fc
 {
@@ -56,4 +57,115 @@ gcs_fc_process (gcs_fc_t* fc, ssize_t act_size);
 extern void
 gcs_fc_debug (gcs_fc_t* fc, long debug_level);
 
+/*! Measures the rate at which actions are taken off the slave queue.
+ *  Used by rate-based flow control to advertise how fast this node applies. */
+typedef struct gcs_fc_meter
+{
+    long long start;  // beginning of the current sample (nanosec, monotonic)
+    long      count;  // actions processed since the beginning of the sample
+    double    rate;   // smoothed rate of the past samples (actions/s)
+}
+gcs_fc_meter_t;
+
+extern void
+gcs_fc_meter_init (gcs_fc_meter_t* m, long long now);
+
+/*! Accounts for one more action taken off the slave queue */
+extern void
+gcs_fc_meter_add (gcs_fc_meter_t* m, long long now);
+
+/*! Discards the current sample without affecting the rate. To be called
+ *  when the slave queue runs empty: processing is not a bottleneck then and
+ *  the measured rate would reflect only the incoming one. */
+extern void
+gcs_fc_meter_restart (gcs_fc_meter_t* m, long long now);
+
+/*! @return current estimate of the processing rate (actions/s). If the
+ *          current sample is overdue the estimate only goes down, so that
+ *          a stalled node does not keep advertising its former rate. */
+extern double
+gcs_fc_meter_rate (const gcs_fc_meter_t* m, long long now);
+
+/*! Calculates the rate at which a node can keep on accepting actions and
+ *  still drain its slave queue down to target length within a second.
+ *  @param rate      measured processing rate (actions/s)
+ *  @param queue_len current slave queue length
+ *  @param target    queue length to drain to
+ *  @return actions/s, 0 if replication has to stop */
+extern double
+gcs_fc_drain_rate (double rate, long queue_len, long target);
+
+/*! Rates advertised with FC_STOP by each group member. Members re-advertise
+ *  their rate while stopped, so the slowest rate can go up as well as down. */
+typedef struct gcs_fc_memb_rate
+{
+    long   stops; // STOPs - CONTs received from the member
+    double rate;  // rate advertised with the last STOP (actions/s)
+}
+gcs_fc_memb_rate_t;
+
+typedef struct gcs_fc_rates
+{
+    gcs_fc_memb_rate_t* memb;
+    long                memb_num;
+}
+gcs_fc_rates_t;
+
+extern void
+gcs_fc_rates_init (gcs_fc_rates_t* r);
+
+extern void
+gcs_fc_rates_free (gcs_fc_rates_t* r);
+
+/*! Forgets all advertised rates and resizes the table for new membership
+ *  @return 0 on success, -ENOMEM */
+extern int
+gcs_fc_rates_reset (gcs_fc_rates_t* r, long memb_num);
+
+/*! Accounts for FC event from a member.
+ *  @param stop  0 - CONT, otherwise rate + 1 (1 - full STOP)
+ *  @return the slowest rate advertised by members that are currently
+ *          stopped, 0 if none of them advertised a rate (full STOP),
+ *          negative if no member is stopped */
+extern double
+gcs_fc_rates_update (gcs_fc_rates_t* r, long idx, uint32_t stop);
+
+/*! Paces local replication to the rate dictated by rate-based flow control.
+ *  interval is set by the receiving thread, the rest is only accessed by
+ *  the thread that is currently in the send monitor. */
+typedef struct gcs_fc_pacer
+{
+    long long interval;       // minimum interval between sends (nanosec)
+    long long next;           // earliest time for the next send
+    long long throttled_ns;   // total nanoseconds spent pacing
+    long long throttled_sample; // throttled_ns at the beginning of the sample
+    long long sample_start;   // beginning of the sample period
+}
+gcs_fc_pacer_t;
+
+extern void
+gcs_fc_pacer_init (gcs_fc_pacer_t* p, long long now);
+
+/*! Sets the minimum interval between sends, 0 turns pacing off */
+extern void
+gcs_fc_pacer_set (gcs_fc_pacer_t* p, long long interval);
+
+/*! Reserves the next send slot.
+ *  @return nanoseconds to wait before sending, 0 - send right away */
+extern long long
+gcs_fc_pacer_delay (gcs_fc_pacer_t* p, long long now);
+
+/*! Reserves n more send slots after the current one for actions sent along
+ *  with it, following sends will wait them out */
+extern void
+gcs_fc_pacer_reserve (gcs_fc_pacer_t* p, long long now, long n);
+
+/*! Returns total time throttled and its fraction since last flush */
+extern void
+gcs_fc_pacer_stats_get (const gcs_fc_pacer_t* p, long long now,
+                        long long* throttled_ns, double* throttled_avg);
+
+extern void
+gcs_fc_pacer_stats_flush (gcs_fc_pacer_t* p, long long now);
+
 #endif /* _gcs_fc_h_ */
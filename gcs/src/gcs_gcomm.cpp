@@ -5,9 +5,6 @@
 /*!
  * @file GComm GCS Backend implementation
  *
- * @todo Figure out if there is lock-free way to handle RecvBuf
- *       push/pop operations.
- *
  */
 
 
@@ -32,8 +29,9 @@
 #include <gu_throw.hpp>
 #include <gu_logger.hpp>
 #include <gu_prodcons.hpp>
+#include <gu_atomic.hpp>
 
-#include <deque>
+#include <algorithm>
 
 using namespace std;
 using namespace gu;
@@ -63,25 +61,18 @@ private:
     ProtoUpMeta um_;
 };
 
-#if defined(GALERA_USE_BOOST_POOL_ALLOC)
-
-#include <boost/pool/pool_alloc.hpp>
-
-typedef deque<RecvBufData,
-              boost::fast_pool_allocator<
-                  RecvBufData,
-                  boost::default_user_allocator_new_delete,
-                  boost::details::pool::null_mutex
-                  >
-              >
-#else
-
-typedef deque<RecvBufData>
-
-#endif /* GALERA_USE_BOOST_POOL_ALLOC */
-
-RecvBufQueue;
-
+/*!
+ * Message queue between gcomm thread (producer) and gcs receive thread
+ * (consumer).
+ *
+ * Messages are stored in fixed size blocks linked into a list, so push_back()
+ * never blocks gcomm thread. Only the receiving thread consumes, and
+ * handle_up() calls which push are serialized by protonet lock, so no
+ * locking is needed in the common case: producer publishes a message by
+ * bumping the block write count, consumer advances its private read
+ * position. Consumer spins for a while on empty queue before parking on
+ * the condition variable, spin limit adapts to how often spinning succeeds.
+ */
 class RecvBuf
 {
 private:
@@ -89,59 +80,206 @@ private:
     class Waiting
     {
     public:
-        Waiting (bool& w) : w_(w) { w_ = true;  }
-        ~Waiting()                { w_ = false; }
+        Waiting (gu::Atomic<int>& w) : w_(w) { w_ = 1; }
+        ~Waiting()                           { w_ = 0; }
+    private:
+        gu::Atomic<int>& w_;
+    };
+
+    static size_t const BLOCK_SIZE = 1024;
+    static int    const SPIN_MIN   = 16;
+    static int    const SPIN_MAX   = 1 << 14;
+
+    class Block
+    {
+    public:
+
+        Block()
+            :
+            data_   (static_cast<RecvBufData*>(
+                         ::operator new(BLOCK_SIZE * sizeof(RecvBufData)))),
+            written_(0),
+            next_   (0)
+        {}
+
+        ~Block() { ::operator delete(data_); }
+
+        RecvBufData* data_;
+        gu::Atomic<size_t> written_; // published messages
+        gu::Atomic<Block*> next_;
+
     private:
-        bool& w_;
+
+        Block(const Block&);
+        void operator=(const Block&);
     };
 
 public:
 
-    RecvBuf() : mutex_(), cond_(), queue_(), waiting_(false) { }
+    RecvBuf()
+        :
+        mutex_   (),
+        cond_    (),
+        head_    (new Block),
+        head_pos_(0),
+        tail_    (head_),
+        tail_pos_(0),
+        spare_   (0),
+        spin_    (SPIN_MIN),
+        waiting_ (0),
+        held_    (false)
+    { }
+
+    ~RecvBuf()
+    {
+        while (available()) pop_front();
+
+        while (head_ != 0)
+        {
+            Block* const next(head_->next_());
+            delete head_;
+            head_ = next;
+        }
+
+        delete spare_();
+    }
 
     void push_back(const RecvBufData& p)
     {
-        Lock lock(mutex_);
+        if (gu_unlikely(BLOCK_SIZE == tail_pos_))
+        {
+            Block* b(spare_());
+
+            if (b != 0)
+            {
+                spare_ = 0;
+            }
+            else
+            {
+                b = new Block;
+            }
 
-        queue_.push_back(p);
+            tail_->next_ = b;
+            tail_        = b;
+            tail_pos_    = 0;
+        }
 
-        if (waiting_ == true) { cond_.signal(); }
+        new (tail_->data_ + tail_pos_) RecvBufData(p);
+        tail_->written_ = ++tail_pos_;
+
+        if (waiting_() != 0)
+        {
+            Lock lock(mutex_);
+            cond_.signal();
+        }
     }
 
     const RecvBufData& front(const Date& timeout)
     {
-        Lock lock(mutex_);
+        if (gu_unlikely(!available()))
+        {
+            wait(timeout);
+        }
+
+        return head_->data_[head_pos_];
+    }
+
+    void pop_front()
+    {
+        assert(available());
 
-        while (queue_.empty())
+        head_->data_[head_pos_].~RecvBufData();
+
+        ++head_pos_;
+    }
+
+    /* Front element payload is referenced by the receiver, keep it in the
+     * queue until release_held(). Both are called by the receiving thread
+     * only, so held_ needs no protection. */
+    void hold_front() { assert(!held_); held_ = true; }
+
+    void release_held()
+    {
+        if (held_)
         {
-            Waiting w(waiting_);
-            if (gu_likely (timeout == GU_TIME_ETERNITY))
+            held_ = false;
+            pop_front();
+        }
+    }
+
+private:
+
+    RecvBuf(const RecvBuf&);
+    void operator=(const RecvBuf&);
+
+    /* moves to the next block once the current one is consumed,
+     * called by consumer only */
+    bool available()
+    {
+        if (gu_unlikely(BLOCK_SIZE == head_pos_))
+        {
+            Block* const next(head_->next_());
+
+            if (0 == next) return false;
+
+            Block* const old(head_);
+            head_     = next;
+            head_pos_ = 0;
+
+            if (0 == spare_())
             {
-                lock.wait(cond_);
+                old->written_ = 0;
+                old->next_    = 0;
+                spare_        = old;
             }
             else
             {
-                lock.wait(cond_, timeout);
+                delete old;
             }
         }
-        assert (false == waiting_);
 
-        return queue_.front();
+        return (head_pos_ < head_->written_());
     }
 
-    void pop_front()
+    void wait(const Date& timeout)
     {
+        for (int i(0); i < spin_; ++i)
+        {
+            if (available())
+            {
+                spin_ = std::min(spin_ * 2, SPIN_MAX);
+                return;
+            }
+        }
+
+        spin_ = std::max(spin_ / 2, SPIN_MIN);
+
         Lock lock(mutex_);
-        assert(queue_.empty() == false);
-        queue_.pop_front();
-    }
+        Waiting w(waiting_);
 
-private:
+        while (!available())
+        {
+            if (gu_likely (timeout == GU_TIME_ETERNITY))
+            {
+                lock.wait(cond_);
+            }
+            else
+            {
+                lock.wait(cond_, timeout);
+            }
+        }
+    }
 
-    Mutex mutex_;
-    Cond cond_;
-    RecvBufQueue queue_;
-    bool waiting_;
+    Mutex              mutex_;
+    Cond               cond_;
+    Block*             head_;     // consumer only
+    size_t             head_pos_; // consumer only
+    Block*             tail_;     // producer only
+    size_t             tail_pos_; // producer only
+    gu::Atomic<Block*> spare_;    // consumed block for reuse
+    int                spin_;     // consumer only
+    gu::Atomic<int>    waiting_;
+    bool               held_;
 };
 
 
@@ -525,7 +663,7 @@ static GCS_BACKEND_MSG_SIZE_FN(gcomm_msg_size)
 }
 
 
-static GCS_BACKEND_SEND_FN(gcomm_send)
+static GCS_BACKEND_SEND_V_FN(gcomm_send_v)
 {
     GCommConn::Ref ref(backend);
 
@@ -536,10 +674,20 @@ static GCS_BACKEND_SEND_FN(gcomm_send)
 
     GCommConn& conn(*ref.get());
 
-    Datagram dg(
-        SharedBuffer(
-            new Buffer(reinterpret_cast<const byte_t*>(buf),
-                       reinterpret_cast<const byte_t*>(buf) + len)));
+    /* gcomm keeps the payload for retransmission, so this is the only copy
+     * of the message made on the sending side */
+    SharedBuffer buf(new Buffer());
+    buf->reserve(len);
+
+    for (int i(0); i < bufs_num; ++i)
+    {
+        const byte_t* const ptr(static_cast<const byte_t*>(bufs[i].ptr));
+        buf->insert(buf->end(), ptr, ptr + bufs[i].size);
+    }
+
+    assert(buf->size() == len);
+
+    Datagram dg(buf);
     gcomm::Critical<Protonet> crit(conn.get_pnet());
     if (gu_unlikely(conn.get_error() != 0))
     {
@@ -553,6 +701,14 @@ static GCS_BACKEND_SEND_FN(gcomm_send)
 }
 
 
+static GCS_BACKEND_SEND_FN(gcomm_send)
+{
+    struct gu_buf const b = { buf, static_cast<ssize_t>(len) };
+
+    return gcomm_send_v(backend, &b, 1, len, msg_type);
+}
+
+
 static void fill_cmp_msg(const View& view, const gcomm::UUID& my_uuid,
                          gcs_comp_msg_t* cm)
 {
@@ -597,6 +753,9 @@ static GCS_BACKEND_RECV_FN(gcomm_recv)
 
         RecvBuf& recv_buf(conn.get_recv_buf());
 
+        /* previous message payload is not referenced by the caller anymore */
+        recv_buf.release_held();
+
         const RecvBufData& d(recv_buf.front(timeout));
 
         msg->sender_idx = d.get_source_idx();
@@ -611,18 +770,15 @@ static GCS_BACKEND_RECV_FN(gcomm_recv)
             const byte_t* b(gcomm::begin(dg));
             const ssize_t pload_len(gcomm::available(dg));
 
-            msg->size = pload_len;
-
-            if (gu_likely(pload_len <= msg->buf_len))
-            {
-                memcpy(msg->buf, b, pload_len);
-                msg->type = static_cast<gcs_msg_type_t>(um.user_type());
-                recv_buf.pop_front();
-            }
-            else
-            {
-                msg->type = GCS_MSG_ERROR;
-            }
+            /* Pass the payload in place, it is copied only once by the
+             * receiver, e.g. when action fragment gets defragmented into
+             * gcache buffer. Datagram payload may be shared with gcomm
+             * internals, so the receiver must not modify it. */
+            msg->buf     = const_cast<byte_t*>(b);
+            msg->buf_len = pload_len;
+            msg->size    = pload_len;
+            msg->type    = static_cast<gcs_msg_type_t>(um.user_type());
+            recv_buf.hold_front();
         }
         else if (um.err_no() != 0)
         {
@@ -903,6 +1059,7 @@ GCS_BACKEND_CREATE_FN(gcs_gcomm_create)
     backend->close     = gcomm_close;
     backend->destroy   = gcomm_destroy;
     backend->send      = gcomm_send;
+    backend->send_v    = gcomm_send_v;
     backend->recv      = gcomm_recv;
     backend->name      = gcomm_name;
     backend->msg_size  = gcomm_msg_size;
@@ -173,8 +173,10 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
                       commonly_supported_version)) {
             /* Common situation -
              * increment and assign act_id only for totally ordered actions
-             * and only in PRIM (skip messages while in state exchange) */
-            rcvd->id = ++group->act_id_;
+             * and only in PRIM (skip messages while in state exchange).
+             * Group of actions takes act_num seqnos starting with this one */
+            rcvd->id = group->act_id_ + 1;
+            group->act_id_ += frg->act_num;
         }
         else if (GCS_ACT_TORDERED  == rcvd->act.type) {
             /* Rare situations */
@@ -191,6 +193,14 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
             else {
                 /* Just ignore it */
                 ret = 0;
+
+                if (gcs_defrag_split (frg)) {
+                    gcs_defrag_free_group (group->cache,
+                                           static_cast<const struct gcs_act*>
+                                           (rcvd->act.buf), frg->act_num);
+                    rcvd->act.buf = NULL;
+                }
+
                 gcs_group_ignore_action (group, rcvd);
             }
         }
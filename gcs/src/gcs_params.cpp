@@ -14,21 +14,29 @@ const char* const GCS_PARAMS_FC_FACTOR         = "gcs.fc_factor";
 const char* const GCS_PARAMS_FC_LIMIT          = "gcs.fc_limit";
 const char* const GCS_PARAMS_FC_MASTER_SLAVE   = "gcs.fc_master_slave";
 const char* const GCS_PARAMS_FC_DEBUG          = "gcs.fc_debug";
+const char* const GCS_PARAMS_FC_RATE           = "gcs.fc_rate";
 const char* const GCS_PARAMS_SYNC_DONOR        = "gcs.sync_donor";
 const char* const GCS_PARAMS_MAX_PKT_SIZE      = "gcs.max_packet_size";
 const char* const GCS_PARAMS_RECV_Q_HARD_LIMIT = "gcs.recv_q_hard_limit";
 const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT = "gcs.recv_q_soft_limit";
 const char* const GCS_PARAMS_MAX_THROTTLE      = "gcs.max_throttle";
+const char* const GCS_PARAMS_COMPRESS          = "gcs.compress";
+const char* const GCS_PARAMS_COMPRESS_MIN_SIZE = "gcs.compress_min_size";
+const char* const GCS_PARAMS_MAX_REPL_GROUP    = "gcs.max_repl_group";
 
 static const char* const GCS_PARAMS_FC_FACTOR_DEFAULT         = "1.0";
 static const char* const GCS_PARAMS_FC_LIMIT_DEFAULT          = "16";
 static const char* const GCS_PARAMS_FC_MASTER_SLAVE_DEFAULT   = "no";
 static const char* const GCS_PARAMS_FC_DEBUG_DEFAULT          = "0";
+static const char* const GCS_PARAMS_FC_RATE_DEFAULT           = "no";
 static const char* const GCS_PARAMS_SYNC_DONOR_DEFAULT        = "no";
 static const char* const GCS_PARAMS_MAX_PKT_SIZE_DEFAULT      = "64500";
 static ssize_t const GCS_PARAMS_RECV_Q_HARD_LIMIT_DEFAULT     = SSIZE_MAX;
 static const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT_DEFAULT = "0.25";
 static const char* const GCS_PARAMS_MAX_THROTTLE_DEFAULT      = "0.25";
+static const char* const GCS_PARAMS_COMPRESS_DEFAULT          = "no";
+static const char* const GCS_PARAMS_COMPRESS_MIN_SIZE_DEFAULT = "1024";
+static const char* const GCS_PARAMS_MAX_REPL_GROUP_DEFAULT    = "1";
 
 bool
 gcs_params_register(gu_config_t* conf)
@@ -43,6 +51,8 @@ gcs_params_register(gu_config_t* conf)
                           GCS_PARAMS_FC_MASTER_SLAVE_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_FC_DEBUG,
                           GCS_PARAMS_FC_DEBUG_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_FC_RATE,
+                          GCS_PARAMS_FC_RATE_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_SYNC_DONOR,
                           GCS_PARAMS_SYNC_DONOR_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_MAX_PKT_SIZE,
@@ -57,6 +67,12 @@ gcs_params_register(gu_config_t* conf)
                           GCS_PARAMS_RECV_Q_SOFT_LIMIT_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_MAX_THROTTLE,
                           GCS_PARAMS_MAX_THROTTLE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_COMPRESS,
+                          GCS_PARAMS_COMPRESS_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_COMPRESS_MIN_SIZE,
+                          GCS_PARAMS_COMPRESS_MIN_SIZE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_MAX_REPL_GROUP,
+                          GCS_PARAMS_MAX_REPL_GROUP_DEFAULT);
 
     return ret;
 }
@@ -186,6 +202,14 @@ gcs_params_init (struct gcs_params* params, gu_config_t* config)
     if ((ret = params_init_long (config, GCS_PARAMS_MAX_PKT_SIZE, 0,LONG_MAX,
                                  &params->max_packet_size))) return ret;
 
+    if ((ret = params_init_long (config, GCS_PARAMS_COMPRESS_MIN_SIZE, 1,
+                                 LONG_MAX, &params->compress_min_size)))
+        return ret;
+
+    if ((ret = params_init_long (config, GCS_PARAMS_MAX_REPL_GROUP, 1,
+                                 GCS_MAX_REPL_GROUP, &params->max_repl_group)))
+        return ret;
+
     if ((ret = params_init_double (config, GCS_PARAMS_FC_FACTOR, 0.0, 1.0,
                                    &params->fc_resume_factor))) return ret;
 
@@ -205,7 +229,13 @@ gcs_params_init (struct gcs_params* params, gu_config_t* config)
     if ((ret = params_init_bool (config, GCS_PARAMS_FC_MASTER_SLAVE,
                                  &params->fc_master_slave))) return ret;
 
+    if ((ret = params_init_bool (config, GCS_PARAMS_FC_RATE,
+                                 &params->fc_rate))) return ret;
+
     if ((ret = params_init_bool (config, GCS_PARAMS_SYNC_DONOR,
                                  &params->sync_donor))) return ret;
+
+    if ((ret = params_init_bool (config, GCS_PARAMS_COMPRESS,
+                                 &params->compress))) return ret;
     return 0;
 }
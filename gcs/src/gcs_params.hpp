@@ -17,19 +17,30 @@ struct gcs_params
     long    fc_base_limit;
     long    max_packet_size;
     long    fc_debug;
+    long    compress_min_size;
+    long    max_repl_group;
     bool    fc_master_slave;
+    bool    fc_rate;
     bool    sync_donor;
+    bool    compress;
 };
 
 extern const char* const GCS_PARAMS_FC_FACTOR;
 extern const char* const GCS_PARAMS_FC_LIMIT;
 extern const char* const GCS_PARAMS_FC_MASTER_SLAVE;
 extern const char* const GCS_PARAMS_FC_DEBUG;
+extern const char* const GCS_PARAMS_FC_RATE;
 extern const char* const GCS_PARAMS_SYNC_DONOR;
 extern const char* const GCS_PARAMS_MAX_PKT_SIZE;
 extern const char* const GCS_PARAMS_RECV_Q_HARD_LIMIT;
 extern const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT;
 extern const char* const GCS_PARAMS_MAX_THROTTLE;
+extern const char* const GCS_PARAMS_COMPRESS;
+extern const char* const GCS_PARAMS_COMPRESS_MIN_SIZE;
+extern const char* const GCS_PARAMS_MAX_REPL_GROUP;
+
+/*! Upper bound for the number of actions replicated in one group */
+#define GCS_MAX_REPL_GROUP 128
 
 /*! Register configuration parameters */
 extern bool
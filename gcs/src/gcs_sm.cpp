@@ -94,7 +94,7 @@ gcs_sm_close (gcs_sm_t* sm)
     while (sm->users > 0) { // wait for cleared queue
         sm->users++;
         GCS_SM_INCREMENT(sm->wait_q_tail);
-        _gcs_sm_enqueue_common (sm, &cond, true);
+        _gcs_sm_enqueue_common (sm, &cond, true, NULL, NULL);
         sm->users--;
         GCS_SM_INCREMENT(sm->wait_q_head);
     }
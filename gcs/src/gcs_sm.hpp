@@ -24,6 +24,8 @@
 typedef struct gcs_sm_user
 {
     gu_cond_t* cond;
+    void*      ctx;       // user context for gcs_sm_collect()
+    bool*      collected; // set by gcs_sm_collect() when user is released
     bool       wait;
 }
 gcs_sm_user_t;
@@ -163,17 +165,33 @@ _gcs_sm_leave_common (gcs_sm_t* sm)
     _gcs_sm_wake_up_waiters (sm);
 }
 
-static inline bool
-_gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block)
+/*!
+ * A user released by gcs_sm_collect() may wake up after the queue has
+ * wrapped around and its slot was taken by another user, so it learns about
+ * that from its own collected flag and does not touch the slot.
+ *
+ * @retval 0         - woken up to enter the monitor
+ * @retval -EINTR    - interrupted or timed out
+ * @retval -EALREADY - collected by gcs_sm_collect()
+ */
+static inline long
+_gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block, void* ctx,
+                        bool* collected)
 {
     unsigned long tail = sm->wait_q_tail;
 
-    sm->wait_q[tail].cond = cond;
-    sm->wait_q[tail].wait = true;
+    assert (NULL == ctx || NULL != collected);
+    if (collected) *collected = false;
+
+    sm->wait_q[tail].cond      = cond;
+    sm->wait_q[tail].ctx       = ctx;
+    sm->wait_q[tail].collected = collected;
+    sm->wait_q[tail].wait      = true;
     bool ret;
     if (block == true)
     {
         gu_cond_wait (cond, &sm->lock);
+        if (gu_unlikely(collected && *collected)) return -EALREADY;
         assert(tail == sm->wait_q_head || false == sm->wait_q[tail].wait);
         assert(sm->wait_q[tail].cond == cond || false == sm->wait_q[tail].wait);
         sm->wait_q[tail].cond = NULL;
@@ -187,6 +205,7 @@ _gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block)
         struct timespec ts;
         abstime._timespec(ts);
         int waitret = gu_cond_timedwait(cond, &sm->lock, &ts);
+        if (gu_unlikely(collected && *collected)) return -EALREADY;
         sm->wait_q[tail].cond = NULL;
         // sm->wait_time is incremented by second each time cond wait
         // times out, reset back to one second when cond wait
@@ -220,7 +239,11 @@ _gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block)
         }
         sm->wait_q[tail].wait = false;
     }
-    return ret;
+
+    sm->wait_q[tail].ctx       = NULL;
+    sm->wait_q[tail].collected = NULL;
+
+    return (ret ? 0 : -EINTR);
 }
 
 #ifdef GCS_SM_CONCURRENCY
@@ -283,26 +306,28 @@ gcs_sm_schedule (gcs_sm_t* sm)
  * @param cond condition to signal to wake up thread in case of wait
  * @param block if true block until entered or send monitor is closed,
  *              if false enter wait times out eventually
+ * @param ctx  if not NULL, the user in the monitor may take over the job of
+ *             this waiter with gcs_sm_collect()
+ * @param collected where to flag that this waiter was collected, must be
+ *             provided with ctx and stay valid until the call returns
  *
- * @retval -EAGAIN - out of space
- * @retval -EBADFD - monitor closed
- * @retval -EINTR  - was interrupted by another thread
+ * @retval -EAGAIN   - out of space
+ * @retval -EBADFD   - monitor closed
+ * @retval -EINTR    - was interrupted by another thread
+ * @retval -EALREADY - was collected by the user in the monitor
  * @retval 0 - successfully entered
  */
 static inline long
-gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
+gcs_sm_enter_ctx (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block,
+                  void* ctx, bool* collected)
 {
     long ret = 0; /* if scheduled and no queue */
 
     if (gu_likely (scheduled || (ret = gcs_sm_schedule(sm)) >= 0)) {
 
         if (GCS_SM_HAS_TO_WAIT) {
-            if (gu_likely(_gcs_sm_enqueue_common (sm, cond, block))) {
-                ret = sm->ret;
-            }
-            else {
-                ret = -EINTR;
-            }
+            ret = _gcs_sm_enqueue_common (sm, cond, block, ctx, collected);
+            if (gu_likely(0 == ret)) ret = sm->ret;
         }
 
         assert (ret <= 0);
@@ -313,7 +338,7 @@ gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
             sm->entered++;
         }
         else {
-            if (gu_likely(-EINTR == ret)) {
+            if (gu_likely(-EINTR == ret || -EALREADY == ret)) {
                 /* was interrupted, will be handled by someone else */
             }
             else {
@@ -329,6 +354,62 @@ gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
     return ret;
 }
 
+static inline long
+gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
+{
+    return gcs_sm_enter_ctx (sm, cond, scheduled, block, NULL, NULL);
+}
+
+/*!
+ * Releases users waiting in the queue right behind the caller, which must be
+ * in the monitor, and returns their contexts (see gcs_sm_enter_ctx()).
+ * Interrupted users are skipped, the first one without context stops it.
+ * Nobody is released while the monitor is paused or closed, as they would
+ * not be allowed to enter it either.
+ * Released users return -EALREADY from gcs_sm_enter_ctx() in the order
+ * they were queued and do not enter the monitor.
+ *
+ * @param ctx array to store the contexts
+ * @param max maximum number of users to release
+ * @return number of users released
+ */
+static inline long
+gcs_sm_collect (gcs_sm_t* sm, void** ctx, long max)
+{
+    long ret = 0;
+
+    if (gu_unlikely(gu_mutex_lock (&sm->lock))) abort();
+
+    assert (sm->entered > 0);
+
+    if (gu_unlikely(sm->pause || sm->ret)) max = 0;
+
+    unsigned long cursor = sm->wait_q_head;
+
+    for (long left = sm->users - 1; left > 0 && ret < max; --left) {
+        GCS_SM_INCREMENT(cursor);
+
+        gcs_sm_user_t* const user = &sm->wait_q[cursor];
+
+        if (!user->wait) continue; /* interrupted, skip */
+        if (NULL == user->ctx) break;
+
+        assert (NULL != user->cond);
+        assert (NULL != user->collected);
+        ctx[ret++]       = user->ctx;
+        *user->collected = true;
+        user->wait       = false;
+        gu_cond_signal (user->cond);
+        user->cond       = NULL;
+        user->ctx        = NULL;
+        user->collected  = NULL;
+    }
+
+    gu_mutex_unlock (&sm->lock);
+
+    return ret;
+}
+
 static inline void
 gcs_sm_leave (gcs_sm_t* sm)
 {
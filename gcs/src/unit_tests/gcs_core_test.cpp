@@ -395,25 +395,12 @@ core_test_init (bool bootstrap = true,
     mark_point();
 }
 
-// cleans up core and backend objects
+// destroys closed core and checks backend
 static inline void
-core_test_cleanup ()
+core_test_destroy ()
 {
     long      ret;
     char      tmp[1];
-    action_t  act;
-
-    fail_if (NULL == Core);
-    fail_if (NULL == Backend);
-
-    // to fetch self-leave message
-    fail_if (CORE_RECV_START (&act));
-    ret = gcs_core_close (Core);
-    fail_if (0 != ret, "Failed to close core: %ld (%s)",
-             ret, strerror (-ret));
-    ret = CORE_RECV_END (&act, NULL, UNKNOWN_SIZE, GCS_ACT_CONF);
-    fail_if (ret, "ret: %ld (%s)", ret, strerror(-ret));
-    free (act.out);
 
     // check that backend is closed too
     ret = Backend->send (Backend, tmp, sizeof(tmp), GCS_MSG_ACTION);
@@ -431,6 +418,28 @@ core_test_cleanup ()
     }
 }
 
+// cleans up core and backend objects
+static inline void
+core_test_cleanup ()
+{
+    long      ret;
+    action_t  act;
+
+    fail_if (NULL == Core);
+    fail_if (NULL == Backend);
+
+    // to fetch self-leave message
+    fail_if (CORE_RECV_START (&act));
+    ret = gcs_core_close (Core);
+    fail_if (0 != ret, "Failed to close core: %ld (%s)",
+             ret, strerror (-ret));
+    ret = CORE_RECV_END (&act, NULL, UNKNOWN_SIZE, GCS_ACT_CONF);
+    fail_if (ret, "ret: %ld (%s)", ret, strerror(-ret));
+    free (act.out);
+
+    core_test_destroy ();
+}
+
 // just a smoke test for core API
 START_TEST (gcs_core_test_api)
 {
@@ -487,6 +496,221 @@ START_TEST (gcs_core_test_api)
 }
 END_TEST
 
+// compressed action must be delivered identical to the sent one
+START_TEST (gcs_core_test_compress)
+{
+    core_test_init ();
+    fail_if (NULL == Core);
+
+    gcs_core_send_lock_step (Core, false);
+
+    long ret = core_test_set_payload_size (64);
+    fail_if (0 != ret, "Failed to set up the message payload size: %ld (%s)",
+             ret, strerror(-ret));
+
+    char act_str[4096];
+    for (size_t i = 0; i < sizeof(act_str); i++) {
+        act_str[i] = "row image "[i % 10] + (i / 1000);
+    }
+
+    // unaligned buffers need to be gathered before compression
+    const struct gu_buf act[] = {
+        { act_str,        1000 },
+        { act_str + 1000, 1    },
+        { act_str + 1001, sizeof(act_str) - 1001 }
+    };
+
+    action_t act_r(act, NULL, NULL, -1, (gcs_act_type_t)-1, -1,
+                   (gu_thread_t)-1);
+
+    // below threshold: sent as is
+    gcs_core_set_compress (Core, sizeof(act_str) + 1);
+    ret = gcs_core_send (Core, act, sizeof(act_str), GCS_ACT_TORDERED);
+    fail_if (ret != sizeof(act_str), "Expected %zu, got %ld (%s)",
+             sizeof(act_str), ret, strerror (-ret));
+    fail_if (CORE_RECV_ACT (&act_r, act_str, sizeof(act_str),
+                            GCS_ACT_TORDERED));
+    free (act_r.out);
+
+    // compressed
+    gcs_core_set_compress (Core, sizeof(act_str));
+    ret = gcs_core_send (Core, act, sizeof(act_str), GCS_ACT_TORDERED);
+    fail_if (ret != sizeof(act_str), "Expected %zu, got %ld (%s)",
+             sizeof(act_str), ret, strerror (-ret));
+    fail_if (CORE_RECV_ACT (&act_r, act_str, sizeof(act_str),
+                            GCS_ACT_TORDERED));
+    free (act_r.out);
+
+    gu::Status status;
+    gcs_core_get_status (Core, status);
+
+    size_t found = 0;
+    for (gu::Status::const_iterator i = status.begin(); i != status.end(); ++i)
+    {
+        if (i->first == "gcs_compressed_actions" ||
+            i->first == "gcs_decompressed_actions") {
+            fail_if (i->second != "1", "%s: %s",
+                     i->first.c_str(), i->second.c_str());
+            found++;
+        }
+    }
+    fail_if (2 != found, "Compression status not found");
+
+    gcs_core_set_compress (Core, 0);
+    gcs_core_send_lock_step (Core, true);
+    core_test_cleanup ();
+}
+END_TEST
+
+// action group members must be delivered one by one with own seqnos
+START_TEST (gcs_core_test_group)
+{
+    core_test_init ();
+    fail_if (NULL == Core);
+
+    gcs_core_send_lock_step (Core, false);
+
+    fail_if (gcs_core_group_protocol_version (Core) < 2,
+             "group protocol version %d does not support action groups",
+             gcs_core_group_protocol_version (Core));
+
+    const struct gu_buf* const acts[] = { act1, act2, act3 };
+    const char*          const strs[] = { act1_str, act2_str, act3_str };
+    const size_t sizes[] = { sizeof(act1_str), sizeof(act2_str),
+                             sizeof(act3_str) };
+
+    // whole group in one fragment, then members and sizes split between
+    // fragments
+    const ssize_t payloads[] = { 64, FRAG_SIZE };
+    long ret;
+
+    for (size_t p = 0; p < sizeof(payloads)/sizeof(payloads[0]); ++p) {
+        ret = core_test_set_payload_size (payloads[p]);
+        fail_if (0 != ret, "Failed to set up the message payload size: "
+                 "%ld (%s)", ret, strerror(-ret));
+
+        ret = gcs_core_send_group (Core, acts, sizes, 3);
+        fail_if (ret != (long)(sizes[0] + sizes[1] + sizes[2]),
+                 "Expected %zu, got %ld (%s)", sizes[0] + sizes[1] + sizes[2],
+                 ret, strerror (-ret));
+
+        for (int i = 0; i < 3; ++i) {
+            action_t act_r(acts[i], NULL, NULL, -1, (gcs_act_type_t)-1, -1,
+                           (gu_thread_t)-1);
+            fail_if (CORE_RECV_ACT (&act_r, strs[i], sizes[i],
+                                    GCS_ACT_TORDERED));
+            free (act_r.out);
+        }
+    }
+
+    // action ordered after the group must get the next seqno
+    ret = gcs_core_send (Core, act1, sizeof(act1_str), GCS_ACT_TORDERED);
+    fail_if (ret != sizeof(act1_str), "Expected %zu, got %ld (%s)",
+             sizeof(act1_str), ret, strerror (-ret));
+    action_t act_r(act1, NULL, NULL, -1, (gcs_act_type_t)-1, -1,
+                   (gu_thread_t)-1);
+    fail_if (CORE_RECV_ACT (&act_r, act1_str, sizeof(act1_str),
+                            GCS_ACT_TORDERED));
+    free (act_r.out);
+
+    gcs_core_send_lock_step (Core, true);
+    core_test_cleanup ();
+}
+END_TEST
+
+static void*
+core_caused_thread (void* arg)
+{
+    *(gcs_seqno_t*)arg = gcs_core_caused (Core);
+    return NULL;
+}
+
+// concurrent causal barriers must all return current seqno
+START_TEST (gcs_core_test_caused)
+{
+    core_test_init ();
+    fail_if (NULL == Core);
+
+    gcs_core_send_lock_step (Core, false);
+
+    for (int round = 0; round < 2; ++round) {
+        // causal messages are handled inside gcs_core_recv()
+        action_t act_r(act1, NULL, NULL, -1, (gcs_act_type_t)-1, -1,
+                       (gu_thread_t)-1);
+        fail_if (CORE_RECV_START (&act_r));
+
+        static int const THREADS = 8;
+        gu_thread_t thr[THREADS];
+        gcs_seqno_t seqno[THREADS];
+
+        for (int i = 0; i < THREADS; ++i) {
+            seqno[i] = GCS_SEQNO_ILL;
+            fail_if (gu_thread_create (&thr[i], NULL, core_caused_thread,
+                                       &seqno[i]));
+        }
+
+        for (int i = 0; i < THREADS; ++i) {
+            gu_thread_join (thr[i], NULL);
+            fail_if (seqno[i] != Seqno, "thread %d: expected %lld, got %lld",
+                     i, (long long)Seqno, (long long)seqno[i]);
+        }
+
+        // let recv thread return
+        long ret = gcs_core_send (Core, act1, sizeof(act1_str),
+                                  GCS_ACT_TORDERED);
+        fail_if (ret != sizeof(act1_str), "Expected %zu, got %ld (%s)",
+                 sizeof(act1_str), ret, strerror (-ret));
+        fail_if (CORE_RECV_END (&act_r, act1_str, sizeof(act1_str),
+                                GCS_ACT_TORDERED));
+        free (act_r.out);
+    }
+
+    gcs_core_send_lock_step (Core, true);
+    core_test_cleanup ();
+}
+END_TEST
+
+// barrier in flight must not block its waiters after the core is closed
+START_TEST (gcs_core_test_caused_close)
+{
+    core_test_init ();
+    fail_if (NULL == Core);
+
+    gcs_core_send_lock_step (Core, false);
+
+    // nobody receives, so the barrier stays in flight
+    static int const THREADS = 4;
+    gu_thread_t thr[THREADS];
+    gcs_seqno_t seqno[THREADS];
+
+    for (int i = 0; i < THREADS; ++i) {
+        seqno[i] = GCS_SEQNO_ILL;
+        fail_if (gu_thread_create (&thr[i], NULL, core_caused_thread,
+                                   &seqno[i]));
+    }
+
+    usleep (100000); // let them send the barrier and wait for it
+
+    long ret = gcs_core_close (Core);
+    fail_if (0 != ret, "Failed to close core: %ld (%s)",
+             ret, strerror (-ret));
+
+    for (int i = 0; i < THREADS; ++i) {
+        gu_thread_join (thr[i], NULL);
+        fail_if (seqno[i] != -ENOTCONN, "thread %d: expected %d, got %lld",
+                 i, -ENOTCONN, (long long)seqno[i]);
+    }
+
+    // late barrier delivery is ignored, self-leave message follows it
+    action_t act;
+    fail_if (CORE_RECV_ACT (&act, NULL, UNKNOWN_SIZE, GCS_ACT_CONF));
+    free (act.out);
+
+    gcs_core_send_lock_step (Core, true);
+    core_test_destroy ();
+}
+END_TEST
+
 // do a single send step, compare with the expected result
 static inline bool
 CORE_SEND_STEP (gcs_core_t* core, long timeout, long ret)
@@ -738,6 +962,8 @@ START_TEST (gcs_core_test_gh74)
     frg.act_id = 1;
     frg.act_size = act_size;
     frg.act_type = GCS_ACT_STATE_REQ;
+    frg.flags = 0;
+    frg.act_num = 1;
     char msg_buf[1024];
     fail_if(gcs_act_proto_write(&frg, msg_buf, sizeof(msg_buf)));
     memcpy(const_cast<void*>(frg.frag), act_ptr, act_size);
@@ -947,6 +1173,10 @@ Suite *gcs_core_suite(void)
   bool skip = false;
   if (skip == false) {
       tcase_add_test  (tcase, gcs_core_test_api);
+      tcase_add_test  (tcase, gcs_core_test_compress);
+      tcase_add_test  (tcase, gcs_core_test_group);
+      tcase_add_test  (tcase, gcs_core_test_caused);
+      tcase_add_test  (tcase, gcs_core_test_caused_close);
       tcase_add_test  (tcase, gcs_core_test_own);
       //  tcase_add_test  (tcase, gcs_core_test_foreign);
       // tcase_add_test (tcase, gcs_core_test_gh74);
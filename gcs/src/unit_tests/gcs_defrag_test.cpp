@@ -9,6 +9,9 @@
 #include <string.h>
 #include <errno.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "gcs_defrag_test.hpp"
 #include "../gcs_defrag.hpp"
 
@@ -67,6 +70,8 @@ START_TEST (gcs_defrag_test)
     frg1.frag_no   = 0;
     frg1.act_type  = GCS_ACT_TORDERED;
     frg1.proto_ver = 0;
+    frg1.flags     = 0;
+    frg1.act_num   = 1;
 
     // normal fragments
     frg2 = frg3 = frg1;
@@ -164,6 +169,93 @@ START_TEST (gcs_defrag_test)
 }
 END_TEST
 
+// action group must be received into separate member buffers
+START_TEST (gcs_defrag_test_group)
+{
+    // member sizes, the last one spans several fragments
+    static uint32_t const sizes[] = { 5, 1, 29 };
+    unsigned int const    num     = sizeof(sizes)/sizeof(sizes[0]);
+
+    std::vector<uint8_t> grp;
+
+    for (unsigned int i = 0; i < num; ++i) {
+        uint32_t const hdr = htogl(sizes[i]);
+        const uint8_t* const h = reinterpret_cast<const uint8_t*>(&hdr);
+
+        grp.insert (grp.end(), h, h + sizeof(hdr));
+        for (uint32_t k = 0; k < sizes[i]; ++k) grp.push_back ('a' + i);
+    }
+
+    // fragments are short enough to split member sizes
+    size_t const frag_len = 3;
+
+    gcs_act_frag_t frg;
+    frg.act_id    = getpid();
+    frg.act_size  = grp.size();
+    frg.act_type  = GCS_ACT_TORDERED;
+    frg.proto_ver = 2;
+    frg.flags     = 0;
+    frg.act_num   = num;
+
+    fail_if (!gcs_defrag_split (&frg));
+
+    gcs_defrag_t   defrag;
+    struct gcs_act recv_act;
+    ssize_t        ret = 0;
+
+    gcs_defrag_init (&defrag, NULL);
+
+    // 1. Receive half of the group and drop it as if the sender left
+    for (size_t off = 0; off < grp.size() / 2; off += frag_len) {
+        frg.frag     = &grp[off];
+        frg.frag_len = frag_len;
+        frg.frag_no  = off / frag_len;
+
+        ret = gcs_defrag_handle_frag (&defrag, &frg, &recv_act, false);
+        fail_if (ret != 0, "ret = %zd", ret);
+    }
+
+    fail_if (defrag.grp == NULL);
+    fail_if (defrag.head != NULL);
+    gcs_defrag_free (&defrag);
+    defrag_check_init (&defrag);
+    fail_if (defrag.grp != NULL);
+
+    // 2. Receive the whole group
+    for (size_t off = 0; off < grp.size(); off += frag_len) {
+        frg.frag     = &grp[off];
+        frg.frag_len = std::min(frag_len, grp.size() - off);
+        frg.frag_no  = off / frag_len;
+
+        ret = gcs_defrag_handle_frag (&defrag, &frg, &recv_act, false);
+        fail_if (ret != (off + frg.frag_len < grp.size() ? 0 :
+                         ssize_t(grp.size())), "ret = %zd", ret);
+    }
+
+    fail_if (recv_act.buf_len != ssize_t(grp.size()));
+    defrag_check_init (&defrag);
+    fail_if (defrag.grp != NULL);
+
+    const struct gcs_act* const members =
+        static_cast<const struct gcs_act*>(recv_act.buf);
+
+    for (unsigned int i = 0; i < num; ++i) {
+        fail_if (members[i].buf_len != ssize_t(sizes[i]),
+                 "member %u: size %zd, expected %u",
+                 i, members[i].buf_len, sizes[i]);
+        fail_if (members[i].type != GCS_ACT_TORDERED);
+
+        const uint8_t* const m = static_cast<const uint8_t*>(members[i].buf);
+
+        for (uint32_t k = 0; k < sizes[i]; ++k) {
+            fail_if (m[k] != 'a' + i, "member %u, byte %u: %c", i, k, m[k]);
+        }
+    }
+
+    gcs_defrag_free_group (NULL, members, num);
+}
+END_TEST
+
 Suite *gcs_defrag_suite(void)
 {
   Suite *suite = suite_create("GCS defragmenter");
@@ -171,6 +263,7 @@ Suite *gcs_defrag_suite(void)
 
   suite_add_tcase (suite, tcase);
   tcase_add_test  (tcase, gcs_defrag_test);
+  tcase_add_test  (tcase, gcs_defrag_test_group);
   return suite;
 }
 
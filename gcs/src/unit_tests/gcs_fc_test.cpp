@@ -120,6 +120,136 @@ START_TEST(gcs_fc_test_precise)
 }
 END_TEST
 
+START_TEST(gcs_fc_test_meter)
+{
+    gcs_fc_meter_t m;
+    long long now = 1000000000LL;
+    int i;
+
+    gcs_fc_meter_init (&m, now);
+    fail_if (gcs_fc_meter_rate (&m, now) != 0.0, "unmeasured rate must be 0");
+
+    // 1000 actions in 0.1s
+    for (i = 0; i < 1000; i++) {
+        now += 100000;
+        gcs_fc_meter_add (&m, now);
+    }
+    fail_if (!double_equals (m.rate, 10000.0), "rate: %f", m.rate);
+
+    // 500 actions in the next 0.1s, rate is smoothed
+    for (i = 0; i < 500; i++) {
+        now += 200000;
+        gcs_fc_meter_add (&m, now);
+    }
+    fail_if (!double_equals (m.rate, 7500.0), "rate: %f", m.rate);
+
+    // restart does not change the rate
+    now += 1000000000LL;
+    gcs_fc_meter_restart (&m, now);
+    fail_if (!double_equals (gcs_fc_meter_rate (&m, now), 7500.0));
+
+    // stalled processing: overdue sample drags the estimate down
+    gcs_fc_meter_add (&m, now);
+    now += 1000000000LL;
+    fail_if (!double_equals (gcs_fc_meter_rate (&m, now), 1.0),
+             "rate: %f", gcs_fc_meter_rate (&m, now));
+}
+END_TEST
+
+START_TEST(gcs_fc_test_drain_rate)
+{
+    // queue below target: 0.9 of processing rate
+    fail_if (!double_equals (gcs_fc_drain_rate (1000.0, 10, 16), 900.0));
+    // excess of 100 to be drained within a second
+    fail_if (!double_equals (gcs_fc_drain_rate (1000.0, 116, 16), 800.0));
+    // queue can't be drained within a second
+    fail_if (gcs_fc_drain_rate (1000.0, 1016, 16) != 0.0);
+    fail_if (gcs_fc_drain_rate (0.0, 16, 16) != 0.0);
+}
+END_TEST
+
+START_TEST(gcs_fc_test_pacer)
+{
+    gcs_fc_pacer_t p;
+    long long now = 1000000000LL;
+
+    gcs_fc_pacer_init (&p, now);
+    fail_if (gcs_fc_pacer_delay (&p, now) != 0);
+
+    gcs_fc_pacer_set (&p, 1000000); // 1ms
+    fail_if (gcs_fc_pacer_delay (&p, now) != 0);       // first slot is now
+    fail_if (gcs_fc_pacer_delay (&p, now) != 1000000); // then 1ms later
+    fail_if (gcs_fc_pacer_delay (&p, now + 500000) != 1500000);
+
+    // no credit for idle time
+    now += 1000000000LL;
+    fail_if (gcs_fc_pacer_delay (&p, now) != 0);
+    fail_if (gcs_fc_pacer_delay (&p, now) != 1000000);
+
+    // group of 4 sent in the last slot takes 3 more
+    gcs_fc_pacer_reserve (&p, now, 3);
+    fail_if (gcs_fc_pacer_delay (&p, now) != 5000000);
+
+    gcs_fc_pacer_set (&p, 0);
+    gcs_fc_pacer_reserve (&p, now, 3);
+    fail_if (gcs_fc_pacer_delay (&p, now) != 0);
+
+    long long ns;
+    double    avg;
+
+    p.throttled_ns = 250000000LL;
+    gcs_fc_pacer_stats_get (&p, now, &ns, &avg);
+    fail_if (ns != 250000000LL);
+    fail_if (!double_equals (avg, 0.25), "avg: %f", avg);
+
+    gcs_fc_pacer_stats_flush (&p, now);
+    gcs_fc_pacer_stats_get (&p, now + 1000000000LL, &ns, &avg);
+    fail_if (ns != 250000000LL);
+    fail_if (avg != 0.0, "avg: %f", avg);
+}
+END_TEST
+
+START_TEST(gcs_fc_test_rates)
+{
+    gcs_fc_rates_t r;
+
+    gcs_fc_rates_init (&r);
+    fail_if (gcs_fc_rates_reset (&r, 3));
+    fail_if (r.memb_num != 3);
+
+    fail_if (gcs_fc_rates_update (&r, 0, 0) >= 0.0, "no member is stopped");
+
+    // rates are advertised as rate + 1
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 0, 1001), 1000.0));
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 1, 501), 500.0));
+
+    // slowest member re-advertises: new STOP, then CONT for the old one
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 1, 2001), 1000.0));
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 1, 0), 1000.0));
+    fail_if (r.memb[1].stops != 1);
+
+    // escalation to full STOP the same way
+    fail_if (gcs_fc_rates_update (&r, 0, 1) != 0.0);
+    fail_if (gcs_fc_rates_update (&r, 0, 0) != 0.0);
+
+    // full STOP released
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 0, 0), 2000.0));
+    fail_if (gcs_fc_rates_update (&r, 1, 0) >= 0.0);
+
+    // events from unknown members do not affect the table
+    fail_if (gcs_fc_rates_update (&r, 3, 101) >= 0.0);
+    fail_if (gcs_fc_rates_update (&r, -1, 101) >= 0.0);
+
+    // reset forgets everything
+    fail_if (!double_equals (gcs_fc_rates_update (&r, 2, 101), 100.0));
+    fail_if (gcs_fc_rates_reset (&r, 5));
+    fail_if (gcs_fc_rates_update (&r, 4, 0) >= 0.0);
+
+    gcs_fc_rates_free (&r);
+    fail_if (r.memb != NULL);
+}
+END_TEST
+
 Suite *gcs_fc_suite(void)
 {
     Suite *s  = suite_create("GCS state transfer FC");
@@ -129,6 +259,10 @@ Suite *gcs_fc_suite(void)
     tcase_add_test  (tc, gcs_fc_test_limits);
     tcase_add_test  (tc, gcs_fc_test_basic);
     tcase_add_test  (tc, gcs_fc_test_precise);
+    tcase_add_test  (tc, gcs_fc_test_meter);
+    tcase_add_test  (tc, gcs_fc_test_drain_rate);
+    tcase_add_test  (tc, gcs_fc_test_pacer);
+    tcase_add_test  (tc, gcs_fc_test_rates);
 
     return s;
 }
@@ -111,6 +111,8 @@ START_TEST (gcs_group_configuration)
     frg1.frag_no   = 0;
     frg1.act_type  = GCS_ACT_TORDERED;
     frg1.proto_ver = 0;
+    frg1.flags     = 0;
+    frg1.act_num   = 1;
 
     // normal fragments
     frg2 = frg3 = frg1;
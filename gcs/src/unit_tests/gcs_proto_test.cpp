@@ -34,6 +34,7 @@ START_TEST (gcs_proto_test)
     char*        act_recv_ptr = act_recv;
     const size_t buf_len      = 32;
     char         buf[buf_len];
+    char         buf_copy[buf_len];
     gcs_act_frag_t frg_send, frg_recv;
     long         ret;
 
@@ -59,8 +60,11 @@ START_TEST (gcs_proto_test)
     act_send_ptr += frg_send.frag_len;
 
     // message was sent and received, now parse the header
+    memcpy (buf_copy, buf, buf_len);
     ret = gcs_act_proto_read (&frg_recv, buf, buf_len);
     fail_if (ret, "error code: %d", ret);
+    // received message may be shared with the backend
+    fail_if (memcmp (buf_copy, buf, buf_len), "Message buffer modified");
     fail_if (frg_recv.frag     == NULL);
     fail_if (frg_recv.frag_len == 0);
     fail_if (frgcmp (&frg_send, &frg_recv),
@@ -105,6 +109,49 @@ START_TEST (gcs_proto_test)
 }
 END_TEST
 
+START_TEST (gcs_proto_test_group)
+{
+    const size_t   buf_len = 64;
+    char           buf[buf_len];
+    gcs_act_frag_t frg_send, frg_recv;
+    long           ret;
+
+    frg_send.act_id    = 12345;
+    frg_send.act_size  = 40;
+    frg_send.frag      = NULL;
+    frg_send.frag_len  = 0;
+    frg_send.frag_no   = 0;
+    frg_send.act_type  = GCS_ACT_TORDERED;
+    frg_send.proto_ver = 2;
+    frg_send.flags     = GCS_ACT_FLAG_COMPRESSED;
+    frg_send.act_num   = 300;
+
+    ret = gcs_act_proto_write (&frg_send, buf, buf_len);
+    fail_if (ret, "error code: %d", ret);
+
+    ret = gcs_act_proto_read (&frg_recv, buf, buf_len);
+    fail_if (ret, "error code: %d", ret);
+    fail_if (frgcmp (&frg_send, &frg_recv),
+             "Sent and recvd headers are not identical");
+    fail_if (frg_recv.proto_ver != 2);
+    fail_if (frg_recv.flags     != GCS_ACT_FLAG_COMPRESSED);
+    fail_if (frg_recv.act_num   != 300, "act_num: %u", frg_recv.act_num);
+
+    // before version 2 there is always exactly one action in the message
+    frg_send.proto_ver = 1;
+    ret = gcs_act_proto_write (&frg_send, buf, buf_len);
+    fail_if (ret, "error code: %d", ret);
+    ret = gcs_act_proto_read (&frg_recv, buf, buf_len);
+    fail_if (ret, "error code: %d", ret);
+    fail_if (frg_recv.act_num != 1, "act_num: %u", frg_recv.act_num);
+
+    // empty group is not allowed
+    frg_send.proto_ver = 2;
+    frg_send.act_num   = 0;
+    fail_if (0 == gcs_act_proto_write (&frg_send, buf, buf_len));
+}
+END_TEST
+
 Suite *gcs_proto_suite(void)
 {
   Suite *suite = suite_create("GCS core protocol");
@@ -112,6 +159,7 @@ Suite *gcs_proto_suite(void)
 
   suite_add_tcase (suite, tcase);
   tcase_add_test  (tcase, gcs_proto_test);
+  tcase_add_test  (tcase, gcs_proto_test_group);
   return suite;
 }
 
@@ -503,6 +503,187 @@ START_TEST (gcs_sm_test_interrupt)
 }
 END_TEST
 
+struct collect_user
+{
+    gcs_sm_t* sm;
+    long      ret;
+    bool      collected;
+};
+
+static void* collect_thread (void* arg)
+{
+    struct collect_user* const user = (struct collect_user*)arg;
+
+    gu_cond_t cond;
+    gu_cond_init (&cond, NULL);
+
+    if (0 == (user->ret = gcs_sm_enter_ctx (user->sm, &cond, false, true,
+                                            user, &user->collected))) {
+        gcs_sm_leave (user->sm);
+    }
+
+    gu_cond_destroy (&cond);
+
+    return NULL;
+}
+
+START_TEST (gcs_sm_test_collect)
+{
+    gcs_sm_t* sm = gcs_sm_create(4, 1);
+    fail_if(!sm);
+
+    gu_cond_t cond;
+    gu_cond_init (&cond, NULL);
+
+    long ret = gcs_sm_enter (sm, &cond, false, true);
+    fail_if (ret != 0);
+
+    struct collect_user u1 = { sm, 1, false };
+    struct collect_user u2 = { sm, 1, false };
+    gu_thread_t thr1, thr2, thr3;
+
+    gu_thread_create (&thr1, NULL, collect_thread, &u1);
+    WAIT_FOR(2 == sm->users);
+    gu_thread_create (&thr2, NULL, collect_thread, &u2);
+    WAIT_FOR(3 == sm->users);
+    global_ret = 1;
+    gu_thread_create (&thr3, NULL, interrupt_thread, sm); /* no context */
+    WAIT_FOR(4 == sm->users);
+    fail_if (sm->users != 4, "users = %ld, expected 4", sm->users);
+
+    void* ctx[4] = { NULL, };
+
+    /* nobody is collected while flow control holds the monitor */
+    gcs_sm_pause (sm);
+    ret = gcs_sm_collect (sm, ctx, 4);
+    fail_if (ret != 0, "collected %ld while paused, expected 0", ret);
+    gcs_sm_continue (sm);
+
+    ret = gcs_sm_collect (sm, ctx, 1);
+    fail_if (ret != 1, "collected %ld, expected 1", ret);
+    fail_if (ctx[0] != &u1);
+    gu_thread_join (thr1, NULL);
+    fail_if (u1.ret != -EALREADY, "u1.ret = %ld, expected -EALREADY", u1.ret);
+    fail_if (!u1.collected);
+
+    /* collection stops at the waiter without context */
+    ret = gcs_sm_collect (sm, ctx, 4);
+    fail_if (ret != 1, "collected %ld, expected 1", ret);
+    fail_if (ctx[0] != &u2);
+    gu_thread_join (thr2, NULL);
+    fail_if (u2.ret != -EALREADY, "u2.ret = %ld, expected -EALREADY", u2.ret);
+    fail_if (!u2.collected);
+
+    ret = gcs_sm_collect (sm, ctx, 4);
+    fail_if (ret != 0, "collected %ld, expected 0", ret);
+
+    /* collected waiters are skipped, the last one enters */
+    gcs_sm_leave (sm);
+    gu_thread_join (thr3, NULL);
+    fail_if (global_ret != 0, "global_ret = %ld, expected 0", global_ret);
+    fail_if (sm->users  != 0, "users = %ld, expected 0", sm->users);
+
+    gu_cond_destroy (&cond);
+    gcs_sm_close (sm);
+    gcs_sm_destroy (sm);
+}
+END_TEST
+
+#define WRAP_USERS  6
+#define WRAP_ROUNDS 20000
+
+struct wrap_user
+{
+    gcs_sm_t* sm;
+    long*     inside;    // users in the monitor
+    long      collected; // times collected by others
+    long      released;  // times gcs_sm_enter_ctx() returned -EALREADY
+    long      errors;
+    bool      groupable;
+    bool      wait_collected; // collected flag for gcs_sm_enter_ctx()
+};
+
+static void* wrap_thread (void* arg)
+{
+    struct wrap_user* const user = (struct wrap_user*)arg;
+
+    gu_cond_t cond;
+    gu_cond_init (&cond, NULL);
+
+    for (long i = 0; i < WRAP_ROUNDS; ++i) {
+        long const ret = gcs_sm_enter_ctx (user->sm, &cond, false, true,
+                                           user->groupable ? user : NULL,
+                                           &user->wait_collected);
+        if (0 == ret) {
+            if (__sync_add_and_fetch (user->inside, 1) != 1) user->errors++;
+
+            sched_yield(); /* let others queue up */
+
+            void* ctx[2];
+            long const num = gcs_sm_collect (user->sm, ctx, 2);
+
+            for (long j = 0; j < num; ++j) {
+                __sync_fetch_and_add
+                    (&static_cast<struct wrap_user*>(ctx[j])->collected, 1);
+            }
+
+            __sync_fetch_and_sub (user->inside, 1);
+            gcs_sm_leave (user->sm);
+        }
+        else if (-EALREADY == ret) {
+            user->released++;
+        }
+        else if (-EAGAIN == ret) { /* queue full */
+            sched_yield();
+        }
+        else {
+            user->errors++;
+        }
+    }
+
+    gu_cond_destroy (&cond);
+
+    return NULL;
+}
+
+START_TEST (gcs_sm_test_collect_wrap)
+{
+    /* a short queue wraps around all the time, so a collected user may
+     * wake up after its slot was taken by another one */
+    gcs_sm_t* sm = gcs_sm_create(4, 1);
+    fail_if(!sm);
+
+    long inside = 0;
+    struct wrap_user users[WRAP_USERS];
+    gu_thread_t      thrs [WRAP_USERS];
+
+    for (int i = 0; i < WRAP_USERS; ++i) {
+        struct wrap_user const u = { sm, &inside, 0, 0, 0, i % 3 != 0,
+                                     false };
+        users[i] = u;
+        gu_thread_create (&thrs[i], NULL, wrap_thread, &users[i]);
+    }
+
+    long collected = 0;
+
+    for (int i = 0; i < WRAP_USERS; ++i) {
+        gu_thread_join (thrs[i], NULL);
+        fail_if (users[i].errors != 0, "user %d: %ld errors",
+                 i, users[i].errors);
+        fail_if (users[i].released != users[i].collected,
+                 "user %d: released %ld times, collected %ld times",
+                 i, users[i].released, users[i].collected);
+        fail_if (!users[i].groupable && users[i].collected != 0);
+        collected += users[i].collected;
+    }
+
+    fail_if (0 == collected, "nobody was collected");
+    fail_if (sm->users != 0, "users = %ld, expected 0", sm->users);
+
+    gcs_sm_close (sm);
+    gcs_sm_destroy (sm);
+}
+END_TEST
 
 Suite *gcs_send_monitor_suite(void)
 {
@@ -515,6 +696,8 @@ Suite *gcs_send_monitor_suite(void)
   tcase_add_test  (tc, gcs_sm_test_close);
   tcase_add_test  (tc, gcs_sm_test_pause);
   tcase_add_test  (tc, gcs_sm_test_interrupt);
+  tcase_add_test  (tc, gcs_sm_test_collect);
+  tcase_add_test  (tc, gcs_sm_test_collect_wrap);
   return s;
 }
 